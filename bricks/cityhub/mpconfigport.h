@@ -6,7 +6,7 @@
 #define MICROPY_HW_BOARD_NAME           "Powered Up Smart Hub"
 #define MICROPY_HW_MCU_NAME             "STM32F030RC"
 
-#define PYBRICKS_HEAP_KB                16 // half of RAM
+#define PYBRICKS_HEAP_KB                14 // half of RAM minus 2 KB for PBIO_CONFIG_ARENA_KB
 
 #define PYBRICKS_HUB_CITYHUB            (1)
 
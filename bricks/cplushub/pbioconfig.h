@@ -5,6 +5,9 @@
 
 #define PBIO_CONFIG_DCMOTOR                 (1)
 
+#define PBIO_CONFIG_BATTERY_COMPENSATION    (1)
+#define PBIO_CONFIG_BATTERY_NOMINAL_MV      (7200)
+
 #define PBIO_CONFIG_TACHO                   (1)
 
 #define PBIO_CONFIG_UARTDEV                 (1)
@@ -12,3 +15,5 @@
 
 #define PBIO_CONFIG_ENABLE_DEINIT           (1)
 #define PBIO_CONFIG_ENABLE_SYS              (1)
+
+#define PBIO_CONFIG_ARENA_KB                (8)
@@ -5,3 +5,7 @@
 #define PBIO_CONFIG_UARTDEV_NUM_DEV         (1)
 
 #define PBIO_CONFIG_ENABLE_SYS              (1)
+
+#define PBIO_CONFIG_ARENA_KB                (16)
+
+#define PBIO_CONFIG_LOOPSTATS               (1)
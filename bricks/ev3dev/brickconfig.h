@@ -47,6 +47,7 @@ extern const struct _mp_obj_module_t pb_module_experimental;
 extern const struct _mp_obj_module_t pb_module_hubs;
 extern const struct _mp_obj_module_t pb_module_iodevices;
 extern const struct _mp_obj_module_t pb_module_media_ev3dev;
+extern const struct _mp_obj_module_t pb_module_messaging;
 extern const struct _mp_obj_module_t pb_module_nxtdevices;
 extern const struct _mp_obj_module_t pb_module_parameters;
 extern const struct _mp_obj_module_t pb_module_robotics;
@@ -60,6 +61,7 @@ extern const struct _mp_obj_module_t pb_module_usignal;
     { MP_ROM_QSTR(MP_QSTR_hubs_c),          MP_ROM_PTR(&pb_module_hubs)             }, \
     { MP_ROM_QSTR(MP_QSTR_iodevices_c),     MP_ROM_PTR(&pb_module_iodevices)        }, \
     { MP_ROM_QSTR(MP_QSTR_media_ev3dev_c),  MP_ROM_PTR(&pb_module_media_ev3dev)     }, \
+    { MP_ROM_QSTR(MP_QSTR_messaging_c),     MP_ROM_PTR(&pb_module_messaging)        }, \
     { MP_ROM_QSTR(MP_QSTR_nxtdevices_c),    MP_ROM_PTR(&pb_module_nxtdevices)       }, \
     { MP_ROM_QSTR(MP_QSTR_parameters_c),    MP_ROM_PTR(&pb_module_parameters)       }, \
     { MP_ROM_QSTR(MP_QSTR_robotics_c),      MP_ROM_PTR(&pb_module_robotics)         }, \
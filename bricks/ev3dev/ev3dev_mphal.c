@@ -26,7 +26,9 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -37,6 +39,7 @@
 
 #include "py/mphal.h"
 #include "py/runtime.h"
+#include "extmod/misc.h"
 
 
 STATIC void sighandler(int signum) {
@@ -95,10 +98,100 @@ void mp_hal_stdio_mode_orig(void) {
 
 #endif
 
+// Output is collected in a ring buffer and written to stdout by a background
+// thread, so that print() does not make a system call and hand off the GIL
+// each time it is called.
+#define STDOUT_BUF_SIZE (4096)
+#define STDOUT_FLUSH_MS (20)
+
+static struct {
+    char data[STDOUT_BUF_SIZE];
+    size_t head;        // total number of bytes written to the buffer
+    size_t tail;        // total number of bytes written to stdout
+    size_t flush_to;    // write up to here without waiting for more data
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t space;
+    pthread_t thread;
+    bool started;
+} stdout_buf = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .space = PTHREAD_COND_INITIALIZER,
+};
+
+static void *stdout_writer(void *arg) {
+    pthread_mutex_lock(&stdout_buf.lock);
+    for (;;) {
+        while (stdout_buf.head == stdout_buf.tail) {
+            pthread_cond_wait(&stdout_buf.wake, &stdout_buf.lock);
+        }
+
+        // give a partial line some time to be completed
+        if ((ssize_t)(stdout_buf.flush_to - stdout_buf.tail) <= 0) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += STDOUT_FLUSH_MS * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            while ((ssize_t)(stdout_buf.flush_to - stdout_buf.tail) <= 0) {
+                if (pthread_cond_timedwait(&stdout_buf.wake, &stdout_buf.lock, &deadline) == ETIMEDOUT) {
+                    break;
+                }
+            }
+        }
+
+        // write everything that is available, up to the end of the buffer
+        size_t offset = stdout_buf.tail % STDOUT_BUF_SIZE;
+        size_t len = MIN(stdout_buf.head - stdout_buf.tail, STDOUT_BUF_SIZE - offset);
+        pthread_mutex_unlock(&stdout_buf.lock);
+        ssize_t ret = write(STDOUT_FILENO, &stdout_buf.data[offset], len);
+        pthread_mutex_lock(&stdout_buf.lock);
+
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        // on other errors, or if nothing could be written, the output is
+        // dropped like it was before
+        stdout_buf.tail += ret <= 0 ? len : (size_t)ret;
+        pthread_cond_broadcast(&stdout_buf.space);
+    }
+    return NULL;
+}
+
+static void stdout_drain(void);
+
+static void stdout_start(void) {
+    if (stdout_buf.started) {
+        return;
+    }
+    stdout_buf.started = true;
+    pthread_create(&stdout_buf.thread, NULL, stdout_writer, NULL);
+    atexit(stdout_drain);
+}
+
+// Waits until everything in the buffer has been written
+static void stdout_drain(void) {
+    if (!stdout_buf.started) {
+        return;
+    }
+    pthread_mutex_lock(&stdout_buf.lock);
+    stdout_buf.flush_to = stdout_buf.head;
+    pthread_cond_signal(&stdout_buf.wake);
+    while (stdout_buf.head != stdout_buf.tail) {
+        pthread_cond_wait(&stdout_buf.space, &stdout_buf.lock);
+    }
+    pthread_mutex_unlock(&stdout_buf.lock);
+}
+
 int mp_hal_stdin_rx_chr(void) {
     unsigned char c;
     int ret;
     MP_THREAD_GIL_EXIT();
+    // make sure the prompt is visible before we wait for input
+    stdout_drain();
     ret = read(STDIN_FILENO, &c, 1);
     MP_THREAD_GIL_ENTER();
     if (ret == 0) {
@@ -109,16 +202,67 @@ int mp_hal_stdin_rx_chr(void) {
     return c;
 }
 
+// Copies output into the buffer. If it is full, this waits for the writer
+// thread to make space. If the caller holds the GIL, it is released while
+// waiting so that other threads can run.
+static void stdout_write(const char *str, size_t len, bool release_gil) {
+    bool newline = memchr(str, '\n', len) != NULL;
+    stdout_start();
+    pthread_mutex_lock(&stdout_buf.lock);
+    while (len > 0) {
+        size_t space = STDOUT_BUF_SIZE - (stdout_buf.head - stdout_buf.tail);
+        if (space == 0) {
+            // buffer is full, so let the writer catch up
+            stdout_buf.flush_to = stdout_buf.head;
+            pthread_cond_signal(&stdout_buf.wake);
+            if (release_gil) {
+                pthread_mutex_unlock(&stdout_buf.lock);
+                MP_THREAD_GIL_EXIT();
+                pthread_mutex_lock(&stdout_buf.lock);
+            }
+            while (stdout_buf.head - stdout_buf.tail == STDOUT_BUF_SIZE) {
+                pthread_cond_wait(&stdout_buf.space, &stdout_buf.lock);
+            }
+            if (release_gil) {
+                pthread_mutex_unlock(&stdout_buf.lock);
+                MP_THREAD_GIL_ENTER();
+                pthread_mutex_lock(&stdout_buf.lock);
+            }
+            continue;
+        }
+        size_t offset = stdout_buf.head % STDOUT_BUF_SIZE;
+        size_t n = MIN(MIN(len, space), STDOUT_BUF_SIZE - offset);
+        memcpy(&stdout_buf.data[offset], str, n);
+        stdout_buf.head += n;
+        str += n;
+        len -= n;
+    }
+    // complete lines and large chunks are written right away, anything else
+    // is written when the next line completes or after STDOUT_FLUSH_MS
+    if (newline || stdout_buf.head - stdout_buf.tail >= STDOUT_BUF_SIZE / 2) {
+        stdout_buf.flush_to = stdout_buf.head;
+    }
+    pthread_cond_signal(&stdout_buf.wake);
+    pthread_mutex_unlock(&stdout_buf.lock);
+}
+
+// This does not need the GIL, so it can be used from any thread
 void mp_hal_stdout_tx_strn(const char *str, size_t len) {
-    MP_THREAD_GIL_EXIT();
-    int ret = write(STDOUT_FILENO, str, len);
-    MP_THREAD_GIL_ENTER();
-    (void)ret; // to suppress compiler warning
+    mp_uos_dupterm_tx_strn(str, len);
+    stdout_write(str, len, false);
+}
+
+// This does not need the GIL, so it can be used during startup and shutdown
+void mp_hal_stdout_flush(void) {
+    stdout_drain();
 }
 
-// cooked is same as uncooked because the terminal does some postprocessing
+// This is MP_PLAT_PRINT_STRN, used by print() and the REPL, so the caller
+// holds the GIL. Cooked is same as uncooked because the terminal does some
+// postprocessing.
 void mp_hal_stdout_tx_strn_cooked(const char *str, size_t len) {
-    mp_hal_stdout_tx_strn(str, len);
+    mp_uos_dupterm_tx_strn(str, len);
+    stdout_write(str, len, true);
 }
 
 void mp_hal_stdout_tx_str(const char *str) {
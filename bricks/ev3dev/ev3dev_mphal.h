@@ -34,6 +34,9 @@ void mp_hal_set_interrupt_char(char c);
 void mp_hal_stdio_mode_raw(void);
 void mp_hal_stdio_mode_orig(void);
 
+// Waits until all buffered output has been written to stdout
+void mp_hal_stdout_flush(void);
+
 #if MICROPY_USE_READLINE == 1 && MICROPY_PY_BUILTINS_INPUT
 #include "py/misc.h"
 #include "lib/mp-readline/readline.h"
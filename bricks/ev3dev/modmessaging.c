@@ -0,0 +1,558 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Mailbox engine for pybricks.messaging
+//
+// All connections of a mailbox server or client are handled by one object
+// that waits for all of them with a single call to poll(), so no thread is
+// needed per connection. Messages are encoded and decoded in C and the last
+// value of each mailbox is kept in a dictionary.
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <pbio/mailbox.h>
+
+#include "py/mpconfig.h"
+#include "py/mphal.h"
+#include "py/obj.h"
+#include "py/runtime.h"
+
+// stuff from bluetooth/bluetooth.h and bluetooth/rfcomm.h
+
+#ifndef AF_BLUETOOTH
+#define AF_BLUETOOTH 31
+#endif
+#define BTPROTO_RFCOMM 3
+
+struct sockaddr_rc {
+    sa_family_t rc_family;
+    uint8_t rc_bdaddr[6];
+    uint8_t rc_channel;
+};
+
+// EV3 supports up to 7 Bluetooth connections
+#define MAILBOX_MAX_CONNECTIONS (7)
+
+enum {
+    MAILBOX_TRANSPORT_RFCOMM,
+    MAILBOX_TRANSPORT_TCP,
+    MAILBOX_TRANSPORT_UNIX,
+};
+
+typedef union {
+    struct sockaddr sa;
+    struct sockaddr_rc rc;
+    struct sockaddr_in in;
+    struct sockaddr_un un;
+} mailbox_sockaddr_t;
+
+typedef struct _mailbox_connection_t {
+    int fd;
+    char name[64];
+    pbio_mailbox_decoder_t dec;
+    uint8_t buf[PBIO_MAILBOX_MAX_SIZE];
+} mailbox_connection_t;
+
+typedef struct _messaging_MailboxEngine_obj_t {
+    mp_obj_base_t base;
+    int listen_fd;
+    uint32_t num_accepted;
+    mailbox_connection_t *connections[MAILBOX_MAX_CONNECTIONS];
+    mp_obj_t mailboxes;
+} messaging_MailboxEngine_obj_t;
+
+STATIC mailbox_connection_t *find_connection(messaging_MailboxEngine_obj_t *self, int fd, const char *name) {
+    for (int i = 0; i < MAILBOX_MAX_CONNECTIONS; i++) {
+        mailbox_connection_t *conn = self->connections[i];
+        if (conn && (conn->fd == fd || (name && strcmp(conn->name, name) == 0))) {
+            return conn;
+        }
+    }
+    return NULL;
+}
+
+STATIC void add_connection(messaging_MailboxEngine_obj_t *self, int fd, const char *name) {
+    for (int i = 0; i < MAILBOX_MAX_CONNECTIONS; i++) {
+        if (!self->connections[i]) {
+            mailbox_connection_t *conn = malloc(sizeof(*conn));
+            if (!conn) {
+                close(fd);
+                mp_raise_OSError(ENOMEM);
+            }
+            conn->fd = fd;
+            snprintf(conn->name, sizeof(conn->name), "%s", name);
+            pbio_mailbox_decoder_init(&conn->dec, conn->buf, sizeof(conn->buf));
+            self->connections[i] = conn;
+            return;
+        }
+    }
+    close(fd);
+    mp_raise_ValueError("too many connections");
+}
+
+STATIC void remove_connection(messaging_MailboxEngine_obj_t *self, mailbox_connection_t *conn) {
+    for (int i = 0; i < MAILBOX_MAX_CONNECTIONS; i++) {
+        if (self->connections[i] == conn) {
+            self->connections[i] = NULL;
+        }
+    }
+    close(conn->fd);
+    free(conn);
+}
+
+// Gets the name of a connection from the address of the remote device
+STATIC void sockaddr_to_name(const mailbox_sockaddr_t *addr, char *name, size_t size) {
+    switch (addr->sa.sa_family) {
+        case AF_BLUETOOTH: {
+            const uint8_t *b = addr->rc.rc_bdaddr;
+            snprintf(name, size, "%02X:%02X:%02X:%02X:%02X:%02X", b[5], b[4], b[3], b[2], b[1], b[0]);
+            break;
+        }
+        case AF_INET: {
+            char host[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &addr->in.sin_addr, host, sizeof(host));
+            snprintf(name, size, "%s:%u", host, ntohs(addr->in.sin_port));
+            break;
+        }
+        default:
+            name[0] = '\0';
+            break;
+    }
+}
+
+// Converts a Python address to a socket address and a connection name
+STATIC socklen_t make_sockaddr(mp_int_t transport, mp_obj_t address_in, mailbox_sockaddr_t *addr, char *name, size_t size) {
+    memset(addr, 0, sizeof(*addr));
+
+    if (transport == MAILBOX_TRANSPORT_UNIX) {
+        size_t len;
+        const char *path = mp_obj_str_get_data(address_in, &len);
+        if (len >= sizeof(addr->un.sun_path)) {
+            mp_raise_ValueError("path too long");
+        }
+        addr->un.sun_family = AF_UNIX;
+        memcpy(addr->un.sun_path, path, len);
+        snprintf(name, size, "%s", path);
+        return sizeof(addr->un);
+    }
+
+    mp_obj_t *items;
+    mp_obj_get_array_fixed_n(address_in, 2, &items);
+    const char *host = mp_obj_str_get_str(items[0]);
+    mp_int_t port = mp_obj_get_int(items[1]);
+
+    if (transport == MAILBOX_TRANSPORT_RFCOMM) {
+        uint8_t *b = addr->rc.rc_bdaddr;
+        if (sscanf(host, "%2hhx:%2hhx:%2hhx:%2hhx:%2hhx:%2hhx", &b[5], &b[4], &b[3], &b[2], &b[1], &b[0]) != 6) {
+            mp_raise_ValueError("invalid Bluetooth address");
+        }
+        addr->rc.rc_family = AF_BLUETOOTH;
+        addr->rc.rc_channel = port;
+        sockaddr_to_name(addr, name, size);
+        return sizeof(addr->rc);
+    }
+
+    if (transport == MAILBOX_TRANSPORT_TCP) {
+        addr->in.sin_family = AF_INET;
+        addr->in.sin_port = htons(port);
+        if (host[0] == '\0') {
+            addr->in.sin_addr.s_addr = htonl(INADDR_ANY);
+        } else {
+            struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+            struct addrinfo *res;
+            MP_THREAD_GIL_EXIT();
+            int ret = getaddrinfo(host, NULL, &hints, &res);
+            MP_THREAD_GIL_ENTER();
+            if (ret != 0) {
+                nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_OSError,
+                    "could not resolve %s: %s", host, gai_strerror(ret)));
+            }
+            addr->in.sin_addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+            freeaddrinfo(res);
+        }
+        snprintf(name, size, "%s:" INT_FMT, host, port);
+        return sizeof(addr->in);
+    }
+
+    mp_raise_ValueError("invalid transport");
+}
+
+STATIC int new_socket(mp_int_t transport) {
+    int fd;
+    if (transport == MAILBOX_TRANSPORT_RFCOMM) {
+        fd = socket(AF_BLUETOOTH, SOCK_STREAM | SOCK_CLOEXEC, BTPROTO_RFCOMM);
+    } else if (transport == MAILBOX_TRANSPORT_TCP) {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    } else {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    }
+    if (fd == -1) {
+        mp_raise_OSError(errno);
+    }
+    if (transport == MAILBOX_TRANSPORT_TCP) {
+        // Messages are small, so send them right away
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+    return fd;
+}
+
+// Stores the messages received on a connection. Returns false if the
+// connection was closed or sent something that is not a mailbox message.
+STATIC bool receive(messaging_MailboxEngine_obj_t *self, mailbox_connection_t *conn) {
+    size_t space;
+    uint8_t *buf = pbio_mailbox_decoder_get_space(&conn->dec, &space);
+    ssize_t ret = recv(conn->fd, buf, space, MSG_DONTWAIT);
+    if (ret == -1 && (errno == EAGAIN || errno == EINTR)) {
+        return true;
+    }
+    if (ret <= 0) {
+        return false;
+    }
+    pbio_mailbox_decoder_commit(&conn->dec, ret);
+
+    pbio_mailbox_msg_t msg;
+    pbio_error_t err;
+    while ((err = pbio_mailbox_decoder_next(&conn->dec, &msg)) == PBIO_SUCCESS) {
+        mp_obj_dict_store(self->mailboxes, mp_obj_new_str(msg.name, msg.name_len),
+            mp_obj_new_bytes(msg.payload, msg.payload_len));
+    }
+    return err == PBIO_ERROR_AGAIN;
+}
+
+// Waits for incoming messages and connections for up to timeout milliseconds
+// (or forever if timeout is -1) and handles them. Returns true if anything
+// was ready.
+STATIC bool engine_poll(messaging_MailboxEngine_obj_t *self, int timeout) {
+    struct pollfd fds[MAILBOX_MAX_CONNECTIONS + 1];
+    nfds_t nfds = 0;
+    bool full = true;
+
+    for (int i = 0; i < MAILBOX_MAX_CONNECTIONS; i++) {
+        if (self->connections[i]) {
+            fds[nfds].fd = self->connections[i]->fd;
+            fds[nfds++].events = POLLIN;
+        } else {
+            full = false;
+        }
+    }
+    if (self->listen_fd != -1 && !full) {
+        fds[nfds].fd = self->listen_fd;
+        fds[nfds++].events = POLLIN;
+    }
+
+    MP_THREAD_GIL_EXIT();
+    int ret = poll(fds, nfds, timeout);
+    MP_THREAD_GIL_ENTER();
+
+    if (ret == -1) {
+        if (errno == EINTR) {
+            return false;
+        }
+        mp_raise_OSError(errno);
+    }
+    bool ready = ret > 0;
+
+    for (nfds_t i = 0; i < nfds && ret > 0; i++) {
+        if (!fds[i].revents) {
+            continue;
+        }
+        ret--;
+
+        if (fds[i].fd == self->listen_fd) {
+            mailbox_sockaddr_t addr;
+            socklen_t len = sizeof(addr);
+            int fd = accept4(self->listen_fd, &addr.sa, &len, SOCK_CLOEXEC);
+            if (fd == -1) {
+                continue;
+            }
+            char name[64];
+            sockaddr_to_name(&addr, name, sizeof(name));
+            if (name[0] == '\0') {
+                snprintf(name, sizeof(name), "#%d", fd);
+            }
+            add_connection(self, fd, name);
+            self->num_accepted++;
+            continue;
+        }
+
+        // The connection may have been closed by another thread while we
+        // were waiting, so look it up again.
+        mailbox_connection_t *conn = find_connection(self, fds[i].fd, NULL);
+        if (conn && !receive(self, conn)) {
+            remove_connection(self, conn);
+        }
+    }
+    return ready;
+}
+
+STATIC mp_obj_t messaging_MailboxEngine_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+
+    messaging_MailboxEngine_obj_t *self = m_new_obj_with_finaliser(messaging_MailboxEngine_obj_t);
+    self->base.type = (mp_obj_type_t *)type;
+    self->listen_fd = -1;
+    self->num_accepted = 0;
+    for (int i = 0; i < MAILBOX_MAX_CONNECTIONS; i++) {
+        self->connections[i] = NULL;
+    }
+    self->mailboxes = mp_obj_new_dict(0);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// def MailboxEngine.listen(transport, address)
+STATIC mp_obj_t messaging_MailboxEngine_listen(mp_obj_t self_in, mp_obj_t transport_in, mp_obj_t address_in) {
+    messaging_MailboxEngine_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t transport = mp_obj_get_int(transport_in);
+
+    if (self->listen_fd != -1) {
+        mp_raise_ValueError("already listening");
+    }
+
+    mailbox_sockaddr_t addr;
+    char name[64];
+    socklen_t len = make_sockaddr(transport, address_in, &addr, name, sizeof(name));
+
+    // Remove a socket file that was left behind by an earlier program
+    struct stat st;
+    if (transport == MAILBOX_TRANSPORT_UNIX && stat(addr.un.sun_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(addr.un.sun_path);
+    }
+
+    int fd = new_socket(transport);
+    if (bind(fd, &addr.sa, len) == -1 || listen(fd, MAILBOX_MAX_CONNECTIONS) == -1) {
+        int err = errno;
+        close(fd);
+        mp_raise_OSError(err);
+    }
+    self->listen_fd = fd;
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(messaging_MailboxEngine_listen_obj, messaging_MailboxEngine_listen);
+
+// def MailboxEngine.connect(transport, address)
+STATIC mp_obj_t messaging_MailboxEngine_connect(mp_obj_t self_in, mp_obj_t transport_in, mp_obj_t address_in) {
+    messaging_MailboxEngine_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t transport = mp_obj_get_int(transport_in);
+
+    mailbox_sockaddr_t addr;
+    char name[64];
+    socklen_t len = make_sockaddr(transport, address_in, &addr, name, sizeof(name));
+
+    if (find_connection(self, -1, name)) {
+        mp_raise_ValueError("connection with this address already exists");
+    }
+
+    int fd = new_socket(transport);
+    MP_THREAD_GIL_EXIT();
+    int ret = connect(fd, &addr.sa, len);
+    MP_THREAD_GIL_ENTER();
+    if (ret == -1) {
+        int err = errno;
+        close(fd);
+        mp_raise_OSError(err);
+    }
+    add_connection(self, fd, name);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(messaging_MailboxEngine_connect_obj, messaging_MailboxEngine_connect);
+
+// def MailboxEngine.wait_for_connection(count=1)
+STATIC mp_obj_t messaging_MailboxEngine_wait_for_connection(size_t n_args, const mp_obj_t *args) {
+    messaging_MailboxEngine_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t count = n_args > 1 ? mp_obj_get_int(args[1]) : 1;
+
+    if (self->listen_fd == -1) {
+        mp_raise_ValueError("not listening");
+    }
+
+    uint32_t target = self->num_accepted + count;
+    while ((int32_t)(target - self->num_accepted) > 0) {
+        mp_handle_pending();
+        engine_poll(self, -1);
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(messaging_MailboxEngine_wait_for_connection_obj, 1, 2, messaging_MailboxEngine_wait_for_connection);
+
+// def MailboxEngine.read(name)
+STATIC mp_obj_t messaging_MailboxEngine_read(mp_obj_t self_in, mp_obj_t name_in) {
+    messaging_MailboxEngine_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    // Take in everything that has arrived so far, without waiting, so the
+    // latest value is returned even if it came in several pieces
+    while (engine_poll(self, 0)) {
+    }
+
+    mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(self->mailboxes), name_in, MP_MAP_LOOKUP);
+    return elem ? elem->value : mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(messaging_MailboxEngine_read_obj, messaging_MailboxEngine_read);
+
+// def MailboxEngine.send(name, payload, destination=None)
+STATIC mp_obj_t messaging_MailboxEngine_send(size_t n_args, const mp_obj_t *args) {
+    messaging_MailboxEngine_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    size_t name_len;
+    const char *name = mp_obj_str_get_data(args[1], &name_len);
+    mp_buffer_info_t payload;
+    mp_get_buffer_raise(args[2], &payload, MP_BUFFER_READ);
+
+    mailbox_connection_t *dest = NULL;
+    if (n_args > 3 && args[3] != mp_const_none) {
+        const char *dest_name = mp_obj_str_get_str(args[3]);
+        dest = find_connection(self, -1, dest_name);
+        if (!dest) {
+            nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError,
+                "not connected to \"%s\"", dest_name));
+        }
+    }
+
+    size_t size = PBIO_MAILBOX_HEADER_SIZE + name_len + 1 + payload.len;
+    uint8_t *msg = m_new(uint8_t, size);
+    size_t msg_len;
+    if (pbio_mailbox_encode(msg, size, name, name_len, payload.buf, payload.len, &msg_len) != PBIO_SUCCESS) {
+        m_del(uint8_t, msg, size);
+        mp_raise_ValueError("name or payload too long");
+    }
+
+    int err = 0;
+    for (int i = 0; i < MAILBOX_MAX_CONNECTIONS; i++) {
+        mailbox_connection_t *conn = self->connections[i];
+        if (!conn || (dest && conn != dest)) {
+            continue;
+        }
+        int fd = conn->fd;
+        size_t done = 0;
+        while (done < msg_len) {
+            MP_THREAD_GIL_EXIT();
+            ssize_t ret = send(fd, &msg[done], msg_len - done, MSG_NOSIGNAL);
+            MP_THREAD_GIL_ENTER();
+            if (ret == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                err = errno;
+                conn = find_connection(self, fd, NULL);
+                if (conn) {
+                    remove_connection(self, conn);
+                }
+                break;
+            }
+            done += ret;
+        }
+    }
+
+    m_del(uint8_t, msg, size);
+
+    if (err) {
+        mp_raise_OSError(err);
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(messaging_MailboxEngine_send_obj, 3, 4, messaging_MailboxEngine_send);
+
+// def MailboxEngine.wait(name, timeout=None)
+STATIC mp_obj_t messaging_MailboxEngine_wait(size_t n_args, const mp_obj_t *args) {
+    messaging_MailboxEngine_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_map_t *map = mp_obj_dict_get_map(self->mailboxes);
+    mp_int_t timeout = n_args > 2 && args[2] != mp_const_none ? mp_obj_get_int(args[2]) : -1;
+
+    // Each message creates a new value object, so any change of the value
+    // object means that the mailbox received a message.
+    mp_map_elem_t *elem = mp_map_lookup(map, args[1], MP_MAP_LOOKUP);
+    mp_obj_t old = elem ? elem->value : MP_OBJ_NULL;
+
+    mp_uint_t start = mp_hal_ticks_ms();
+    for (;;) {
+        mp_handle_pending();
+
+        int remaining = -1;
+        if (timeout >= 0) {
+            remaining = timeout - (mp_int_t)(mp_hal_ticks_ms() - start);
+            if (remaining < 0) {
+                remaining = 0;
+            }
+        }
+        engine_poll(self, remaining);
+
+        elem = mp_map_lookup(map, args[1], MP_MAP_LOOKUP);
+        if (elem && elem->value != old) {
+            return mp_const_true;
+        }
+        if (remaining == 0) {
+            return mp_const_false;
+        }
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(messaging_MailboxEngine_wait_obj, 2, 3, messaging_MailboxEngine_wait);
+
+// def MailboxEngine.close()
+STATIC mp_obj_t messaging_MailboxEngine_close(mp_obj_t self_in) {
+    messaging_MailboxEngine_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    for (int i = 0; i < MAILBOX_MAX_CONNECTIONS; i++) {
+        if (self->connections[i]) {
+            remove_connection(self, self->connections[i]);
+        }
+    }
+    if (self->listen_fd != -1) {
+        close(self->listen_fd);
+        self->listen_fd = -1;
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(messaging_MailboxEngine_close_obj, messaging_MailboxEngine_close);
+
+STATIC const mp_rom_map_elem_t messaging_MailboxEngine_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),             MP_ROM_PTR(&messaging_MailboxEngine_close_obj)                },
+    { MP_ROM_QSTR(MP_QSTR_listen),              MP_ROM_PTR(&messaging_MailboxEngine_listen_obj)               },
+    { MP_ROM_QSTR(MP_QSTR_connect),             MP_ROM_PTR(&messaging_MailboxEngine_connect_obj)              },
+    { MP_ROM_QSTR(MP_QSTR_wait_for_connection), MP_ROM_PTR(&messaging_MailboxEngine_wait_for_connection_obj)  },
+    { MP_ROM_QSTR(MP_QSTR_read),                MP_ROM_PTR(&messaging_MailboxEngine_read_obj)                 },
+    { MP_ROM_QSTR(MP_QSTR_send),                MP_ROM_PTR(&messaging_MailboxEngine_send_obj)                 },
+    { MP_ROM_QSTR(MP_QSTR_wait),                MP_ROM_PTR(&messaging_MailboxEngine_wait_obj)                 },
+    { MP_ROM_QSTR(MP_QSTR_close),               MP_ROM_PTR(&messaging_MailboxEngine_close_obj)                },
+};
+STATIC MP_DEFINE_CONST_DICT(messaging_MailboxEngine_locals_dict, messaging_MailboxEngine_locals_dict_table);
+
+STATIC const mp_obj_type_t messaging_MailboxEngine_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_MailboxEngine,
+    .make_new = messaging_MailboxEngine_make_new,
+    .locals_dict = (mp_obj_dict_t *)&messaging_MailboxEngine_locals_dict,
+};
+
+STATIC const mp_rom_map_elem_t ev3dev_messaging_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__),      MP_ROM_QSTR(MP_QSTR_messaging_c)                       },
+    { MP_ROM_QSTR(MP_QSTR_MailboxEngine), MP_ROM_PTR(&messaging_MailboxEngine_type)              },
+    { MP_ROM_QSTR(MP_QSTR_RFCOMM),        MP_ROM_INT(MAILBOX_TRANSPORT_RFCOMM)                    },
+    { MP_ROM_QSTR(MP_QSTR_TCP),           MP_ROM_INT(MAILBOX_TRANSPORT_TCP)                       },
+    { MP_ROM_QSTR(MP_QSTR_UNIX),          MP_ROM_INT(MAILBOX_TRANSPORT_UNIX)                      },
+};
+STATIC MP_DEFINE_CONST_DICT(ev3dev_messaging_globals, ev3dev_messaging_globals_table);
+
+const mp_obj_module_t pb_module_messaging = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t *)&ev3dev_messaging_globals,
+};
@@ -1,7 +1,8 @@
 """The experimental module contains unstable APIs for development and testing.
 """
 
-from experimental_c import pthread_raise
+from experimental_c import (  # noqa: F401
+    pthread_raise, loop_stats, record_start, record_save)
 from _thread import start_new_thread, get_ident, allocate_lock
 from usignal import pthread_kill, SIGUSR2
 
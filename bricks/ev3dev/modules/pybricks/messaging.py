@@ -1,12 +1,10 @@
 # SPDX-License-Identifier: MIT
 # Copyright (C) 2020 The Pybricks Authors
 
-from _thread import allocate_lock
-from uerrno import ECONNRESET
 from ustruct import pack, unpack
 
-from pybricks.bluetooth import (resolve, BDADDR_ANY, ThreadingRFCOMMServer,
-                                ThreadingRFCOMMClient, StreamRequestHandler)
+from messaging_c import MailboxEngine, RFCOMM, TCP, UNIX
+from pybricks.bluetooth import resolve, BDADDR_ANY
 
 
 class Mailbox:
@@ -128,51 +126,11 @@ class TextMailbox(Mailbox):
 # EV3 standard firmware is hard-coded to use channel 1
 EV3_RFCOMM_CHANNEL = 1
 
-# EV3 VM bytecodes
-SYSTEM_COMMAND_NO_REPLY = 0x81
-WRITEMAILBOX = 0x9E
-
-
-class MailboxHandler(StreamRequestHandler):
-    def handle(self):
-        with self.server._lock:
-            self.server._clients[self.client_address[0]] = self.request
-        while True:
-            try:
-                buf = self.rfile.read(2)
-            except OSError as ex:
-                # The client disconnected the connection
-                if ex.args[0] == ECONNRESET:
-                    break
-                raise
-            size, = unpack('<H', buf)
-            buf = self.rfile.read(size)
-            msg_count, cmd_type, cmd, name_size = unpack('<HBBB', buf)
-            if cmd_type != SYSTEM_COMMAND_NO_REPLY:
-                raise ValueError('Bad message type')
-            if cmd != WRITEMAILBOX:
-                raise ValueError('Bad command')
-            mbox = buf[5:5+name_size].decode().strip('\0')
-            data_size, = unpack('<H', buf[5+name_size:7+name_size])
-            data = buf[7+name_size:7+name_size+data_size]
-
-            with self.server._lock:
-                self.server._mailboxes[mbox] = data
-                update_lock = self.server._updates.get(mbox)
-                if update_lock:
-                    update_lock.release()
-
 
 class MailboxHandlerMixIn:
     def __init__(self):
-        # protects against concurrent access of other attributes
-        self._lock = allocate_lock()
-        # map of mailbox name to raw data
-        self._mailboxes = {}
-        # map of device name/address to object with send() method
-        self._clients = {}
-        # map of mailbox name to mutex lock
-        self._updates = {}
+        # handles all connections, and the encoding and decoding of messages
+        self._engine = MailboxEngine()
         # map of names to addresses
         self._addresses = {}
 
@@ -188,8 +146,7 @@ class MailboxHandlerMixIn:
                 The current mailbox raw data or ``None`` if nothing has ever
                 been delivered to the mailbox.
         """
-        with self._lock:
-            return self._mailboxes.get(mbox)
+        return self._engine.read(mbox)
 
     def send_to_mailbox(self, brick, mbox, payload):
         """Sends a mailbox value using raw bytes data.
@@ -203,39 +160,25 @@ class MailboxHandlerMixIn:
             payload (bytes):
                 A bytes-like object that will be sent to the mailbox.
         """
-        mbox_len = len(mbox) + 1
-        payload_len = len(payload)
-        send_len = 7 + mbox_len + payload_len
-        fmt = '<HHBBB{}sH{}s'.format(mbox_len, payload_len)
-        data = pack(fmt, send_len, 1, SYSTEM_COMMAND_NO_REPLY, WRITEMAILBOX,
-                    mbox_len, mbox, payload_len, payload)
-        with self._lock:
-            if brick is None:
-                for client in self._clients.values():
-                    client.send(data)
-            else:
-                addr = self._addresses.get(brick)
-                if addr is None:
-                    addr = resolve(brick)
-                    self._addresses[brick] = addr
-                if addr is None:
-                    raise ValueError('no paired devices matching "{}"'.format(brick))
-                self._clients[addr].send(data)
+        if brick is not None:
+            brick = self._resolve(brick)
+        self._engine.send(mbox, payload, brick)
 
     def wait_for_mailbox_update(self, mbox):
         """Waits until ``mbox`` receives a value."""
-        lock = allocate_lock()
-        lock.acquire()
-        with self._lock:
-            self._updates[mbox] = lock
-        try:
-            return lock.acquire()
-        finally:
-            with self._lock:
-                del self._updates[mbox]
-
-
-class BluetoothMailboxServer(MailboxHandlerMixIn, ThreadingRFCOMMServer):
+        self._engine.wait(mbox)
+
+    def _resolve(self, brick):
+        addr = self._addresses.get(brick)
+        if addr is None:
+            addr = resolve(brick)
+            if addr is None:
+                raise ValueError('no paired devices matching "{}"'.format(brick))
+            self._addresses[brick] = addr
+        return addr
+
+
+class BluetoothMailboxServer(MailboxHandlerMixIn):
     def __init__(self):
         """Object that represents an incoming Bluetooth connection from another
         EV3.
@@ -244,8 +187,13 @@ class BluetoothMailboxServer(MailboxHandlerMixIn, ThreadingRFCOMMServer):
         firmare.
         """
         super().__init__()
-        super(ThreadingRFCOMMServer, self).__init__(
-            (BDADDR_ANY, EV3_RFCOMM_CHANNEL), MailboxHandler)
+        self._engine.listen(RFCOMM, (BDADDR_ANY, EV3_RFCOMM_CHANNEL))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, type, value, traceback):
+        self.server_close()
 
     def wait_for_connection(self, count=1):
         """Waits for a :class:`BluetoothMailboxClient` on a remote device to
@@ -259,20 +207,11 @@ class BluetoothMailboxServer(MailboxHandlerMixIn, ThreadingRFCOMMServer):
             OSError:
                 There was a problem establishing the connection.
         """
-        for _ in range(count):
-            self.handle_request()
-
+        self._engine.wait_for_connection(count)
 
-class MailboxRFCOMMClient(ThreadingRFCOMMClient):
-    def __init__(self, parent, bdaddr):
-        self.parent = parent
-        super().__init__((bdaddr, EV3_RFCOMM_CHANNEL), MailboxHandler)
-
-    def send(self, data):
-        self.socket.send(data)
-
-    def finish_request(self, request, client_address):
-        self.RequestHandlerClass(request, client_address, self.parent)
+    def server_close(self):
+        """Closes the server and all connections."""
+        self._engine.close()
 
 
 class BluetoothMailboxClient(MailboxHandlerMixIn):
@@ -308,20 +247,53 @@ class BluetoothMailboxClient(MailboxHandlerMixIn):
             OSError:
                 There was a problem establishing the connection.
         """
-        addr = resolve(brick)
-        if addr is None:
-            raise ValueError('no paired devices matching "{}"'.format(brick))
-        client = MailboxRFCOMMClient(self, addr)
-        if self._clients.setdefault(addr, client) is not client:
-            raise ValueError('connection with this address already exists')
-        try:
-            client.handle_request()
-        except:
-            del self._clients[addr]
-            raise
+        addr = self._resolve(brick)
+        self._engine.connect(RFCOMM, (addr, EV3_RFCOMM_CHANNEL))
 
     def close(self):
         """Closes the connections."""
-        for client in self._clients.values():
-            client.client_close()
-        self._clients.clear()
+        self._engine.close()
+
+
+def _transport(address):
+    return UNIX if isinstance(address, str) else TCP
+
+
+def _address_name(address):
+    return address if isinstance(address, str) else '{}:{}'.format(*address)
+
+
+class SocketMailboxServer(BluetoothMailboxServer):
+    def __init__(self, address):
+        """Same as :class:`BluetoothMailboxServer`, but uses a TCP port or a
+        UNIX socket instead of Bluetooth. This can be used to test programs
+        that use mailboxes on a single computer.
+
+        Arguments:
+            address:
+                ``(host, port)`` for TCP or a path for a UNIX socket.
+        """
+        super(BluetoothMailboxServer, self).__init__()
+        self._engine.listen(_transport(address), address)
+
+    def _resolve(self, brick):
+        return _address_name(brick)
+
+
+class SocketMailboxClient(BluetoothMailboxClient):
+    """Same as :class:`BluetoothMailboxClient`, but uses TCP or UNIX sockets
+    instead of Bluetooth. Destinations are given as ``'host:port'`` or as the
+    socket path.
+    """
+
+    def connect(self, address):
+        """Connects to a :class:`SocketMailboxServer`.
+
+        Arguments:
+            address:
+                ``(host, port)`` for TCP or a path for a UNIX socket.
+        """
+        self._engine.connect(_transport(address), address)
+
+    def _resolve(self, brick):
+        return _address_name(brick)
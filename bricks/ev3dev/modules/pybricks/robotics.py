@@ -3,7 +3,8 @@
 
 """Pybricks robotics module."""
 
-from robotics_c import DriveBase as CompatDriveBase
+from robotics_c import (  # noqa: F401
+    DriveBase as CompatDriveBase, MotorGroup, run_targets)
 
 from pybricks.tools import wait
 from pybricks.parameters import Stop
@@ -8,6 +8,11 @@
 
 #include "py/obj.h"
 
+// class DataLog
+
+extern const mp_obj_type_t pb_type_ev3dev_DataLog;
+void pb_type_ev3dev_DataLog_close_all(void);
+
 // class Font
 
 // IMPORTANT: pb_type_ev3dev_Font_init() must be called before using
@@ -0,0 +1,449 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// class DataLog
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "py/mpconfig.h"
+#include "py/formatfloat.h"
+#include "py/misc.h"
+#include "py/mpprint.h"
+#include "py/mphal.h"
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include "pb_ev3dev_types.h"
+
+// Size of the buffer between log() and the writer thread
+#define DATALOG_BUF_SIZE (64 * 1024)
+
+// Size of the buffer for formatting one row
+#define DATALOG_ROW_SIZE (256)
+
+// Rows are written as soon as this much data is waiting
+#define DATALOG_WRITE_THRESHOLD (DATALOG_BUF_SIZE / 4)
+
+// State that is shared with the writer thread. This is not allocated on the
+// MicroPython heap, so logs can still be flushed after the VM has stopped.
+typedef struct _datalog_t {
+    struct _datalog_t *next;
+    int fd;
+    int flush_interval;
+    char *path;
+    char *buf;
+    size_t head;        // total number of bytes added to buf
+    size_t tail;        // total number of bytes written to the file
+    size_t flush_to;    // write up to here without waiting for the interval
+    bool closing;
+    bool closed;        // file was closed, but the Python object still has this
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t space;
+    pthread_t thread;
+    char row[DATALOG_ROW_SIZE];
+    size_t row_len;
+} datalog_t;
+
+typedef struct _ev3dev_DataLog_obj_t {
+    mp_obj_base_t base;
+    datalog_t *log;
+} ev3dev_DataLog_obj_t;
+
+// All logs that are open, so that they can be closed at exit
+static datalog_t *open_logs;
+static pthread_mutex_t open_logs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *datalog_writer(void *arg) {
+    datalog_t *log = arg;
+
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        while (log->head == log->tail && !log->closing) {
+            pthread_cond_wait(&log->wake, &log->lock);
+        }
+        if (log->head == log->tail) {
+            break;
+        }
+
+        // Collect rows for up to flush_interval, so they are written at once
+        if ((ssize_t)(log->flush_to - log->tail) <= 0 && !log->closing) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += log->flush_interval / 1000;
+            deadline.tv_nsec += log->flush_interval % 1000 * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            while ((ssize_t)(log->flush_to - log->tail) <= 0 && !log->closing) {
+                if (pthread_cond_timedwait(&log->wake, &log->lock, &deadline) == ETIMEDOUT) {
+                    break;
+                }
+            }
+        }
+
+        size_t offset = log->tail % DATALOG_BUF_SIZE;
+        size_t len = MIN(log->head - log->tail, DATALOG_BUF_SIZE - offset);
+        pthread_mutex_unlock(&log->lock);
+        ssize_t ret = write(log->fd, &log->buf[offset], len);
+        pthread_mutex_lock(&log->lock);
+
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        // If the disk is full, the data is lost, like it would be with print()
+        log->tail += ret <= 0 ? len : (size_t)ret;
+        pthread_cond_broadcast(&log->space);
+    }
+    pthread_mutex_unlock(&log->lock);
+
+    return NULL;
+}
+
+// Copies data to the buffer of the writer thread. Called with the GIL held.
+static void datalog_add(datalog_t *log, const char *data, size_t len) {
+    pthread_mutex_lock(&log->lock);
+    while (len > 0) {
+        size_t space = DATALOG_BUF_SIZE - (log->head - log->tail);
+        if (space == 0) {
+            // The writer can't keep up, so wait for it without holding the GIL
+            log->flush_to = log->head;
+            pthread_cond_signal(&log->wake);
+            pthread_mutex_unlock(&log->lock);
+            MP_THREAD_GIL_EXIT();
+            pthread_mutex_lock(&log->lock);
+            while (log->head - log->tail == DATALOG_BUF_SIZE) {
+                pthread_cond_wait(&log->space, &log->lock);
+            }
+            pthread_mutex_unlock(&log->lock);
+            MP_THREAD_GIL_ENTER();
+            pthread_mutex_lock(&log->lock);
+            continue;
+        }
+        size_t offset = log->head % DATALOG_BUF_SIZE;
+        size_t n = MIN(MIN(len, space), DATALOG_BUF_SIZE - offset);
+        memcpy(&log->buf[offset], data, n);
+        log->head += n;
+        data += n;
+        len -= n;
+    }
+    if (log->head - log->tail >= DATALOG_WRITE_THRESHOLD) {
+        log->flush_to = log->head;
+    }
+    pthread_cond_signal(&log->wake);
+    pthread_mutex_unlock(&log->lock);
+}
+
+// Waits until everything was written to the file
+static void datalog_flush(datalog_t *log) {
+    pthread_mutex_lock(&log->lock);
+    log->flush_to = log->head;
+    pthread_cond_signal(&log->wake);
+    while (log->head != log->tail) {
+        pthread_cond_wait(&log->space, &log->lock);
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+// Writes all remaining data and closes the file. The log itself remains
+// valid until datalog_close(), because a Python object may still refer to it.
+static void datalog_finish(datalog_t *log) {
+    if (log->closed) {
+        return;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    log->closing = true;
+    pthread_cond_signal(&log->wake);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+
+    pthread_mutex_lock(&open_logs_lock);
+    for (datalog_t **l = &open_logs; *l; l = &(*l)->next) {
+        if (*l == log) {
+            *l = log->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&open_logs_lock);
+
+    close(log->fd);
+    log->closed = true;
+}
+
+static void datalog_close(datalog_t *log) {
+    datalog_finish(log);
+    free(log->path);
+    free(log->buf);
+    free(log);
+}
+
+// Writes all remaining data of all logs. Called at exit. The logs are freed
+// when their Python objects are closed or collected.
+void pb_type_ev3dev_DataLog_close_all(void) {
+    while (open_logs) {
+        datalog_finish(open_logs);
+    }
+}
+
+// Row formatting
+
+static void row_flush(datalog_t *log) {
+    datalog_add(log, log->row, log->row_len);
+    log->row_len = 0;
+}
+
+static void row_add(datalog_t *log, const char *str, size_t len) {
+    if (log->row_len + len > DATALOG_ROW_SIZE) {
+        row_flush(log);
+        if (len > DATALOG_ROW_SIZE) {
+            datalog_add(log, str, len);
+            return;
+        }
+    }
+    memcpy(&log->row[log->row_len], str, len);
+    log->row_len += len;
+}
+
+static void row_print_strn(void *env, const char *str, size_t len) {
+    row_add(env, str, len);
+}
+
+static void row_add_int(datalog_t *log, mp_int_t value) {
+    char buf[24];
+    char *p = &buf[sizeof(buf)];
+    mp_uint_t u = value < 0 ? -(mp_uint_t)value : (mp_uint_t)value;
+    do {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (value < 0) {
+        *--p = '-';
+    }
+    row_add(log, p, &buf[sizeof(buf)] - p);
+}
+
+#if MICROPY_PY_BUILTINS_FLOAT
+// Formats a float like str() does
+static void row_add_float(datalog_t *log, mp_float_t value) {
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+    char buf[16];
+    const int precision = 6;
+    #else
+    char buf[32];
+    const int precision = 16;
+    #endif
+    mp_format_float(value, buf, sizeof(buf), 'g', precision, '\0');
+    size_t len = strlen(buf);
+    row_add(log, buf, len);
+    if (!memchr(buf, '.', len) && !memchr(buf, 'e', len) && !memchr(buf, 'n', len)) {
+        row_add(log, ".0", 2);
+    }
+}
+#endif
+
+// Adds values separated by ", " and a newline, like print(*values, sep=', ')
+static void row_add_values(datalog_t *log, size_t n_values, const mp_obj_t *values) {
+    mp_print_t print = { .data = log, .print_strn = row_print_strn };
+
+    // Drop what is left of a row that could not be completed because
+    // printing one of its values raised an exception
+    log->row_len = 0;
+
+    for (size_t i = 0; i < n_values; i++) {
+        if (i > 0) {
+            row_add(log, ", ", 2);
+        }
+        mp_obj_t value = values[i];
+        if (mp_obj_is_small_int(value)) {
+            row_add_int(log, MP_OBJ_SMALL_INT_VALUE(value));
+        #if MICROPY_PY_BUILTINS_FLOAT
+        } else if (mp_obj_is_float(value)) {
+            row_add_float(log, mp_obj_float_get(value));
+        #endif
+        } else {
+            mp_obj_print_helper(&print, value, PRINT_STR);
+        }
+    }
+    row_add(log, "\n", 1);
+    row_flush(log);
+}
+
+// Python type
+
+STATIC datalog_t *ev3dev_DataLog_get_log(ev3dev_DataLog_obj_t *self) {
+    if (!self->log || self->log->closed) {
+        mp_raise_ValueError("log is closed");
+    }
+    return self->log;
+}
+
+STATIC mp_obj_t ev3dev_DataLog_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    enum { ARG_name, ARG_timestamp, ARG_extension, ARG_append, ARG_flush_interval };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_name, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_log)} },
+        { MP_QSTR_timestamp, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = true} },
+        { MP_QSTR_extension, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_csv)} },
+        { MP_QSTR_append, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+        { MP_QSTR_flush_interval, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1000} },
+    };
+
+    // All positional arguments are column headers
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, args + n_args);
+    mp_arg_val_t arg_vals[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(0, NULL, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, arg_vals);
+
+    const char *name = mp_obj_str_get_str(arg_vals[ARG_name].u_obj);
+    const char *extension = mp_obj_str_get_str(arg_vals[ARG_extension].u_obj);
+    mp_int_t flush_interval = arg_vals[ARG_flush_interval].u_int;
+    if (flush_interval < 0) {
+        mp_raise_ValueError("flush_interval must not be negative");
+    }
+
+    // Make timestamp of the form _yyyy_mm_dd_hh_mm_ss_uuuuuu
+    char stamp[32] = "";
+    if (arg_vals[ARG_timestamp].u_bool) {
+        struct timeval tv;
+        struct tm tm;
+        gettimeofday(&tv, NULL);
+        localtime_r(&tv.tv_sec, &tm);
+        snprintf(stamp, sizeof(stamp), "_%d_%02d_%02d_%02d_%02d_%02d_%06ld",
+            tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, (long)tv.tv_usec);
+    }
+
+    datalog_t *log = calloc(1, sizeof(datalog_t));
+    if (log) {
+        log->buf = malloc(DATALOG_BUF_SIZE);
+        log->path = malloc(strlen(name) + strlen(stamp) + strlen(extension) + 2);
+    }
+    if (!log || !log->buf || !log->path) {
+        if (log) {
+            free(log->buf);
+            free(log->path);
+            free(log);
+        }
+        mp_raise_msg(&mp_type_MemoryError, NULL);
+    }
+    sprintf(log->path, "%s%s.%s", name, stamp, extension);
+
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (arg_vals[ARG_append].u_bool ? O_APPEND : O_TRUNC);
+    log->fd = open(log->path, flags, 0666);
+    if (log->fd < 0) {
+        int err = errno;
+        free(log->buf);
+        free(log->path);
+        free(log);
+        mp_raise_OSError(err);
+    }
+
+    log->flush_interval = flush_interval;
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, NULL);
+    pthread_cond_init(&log->space, NULL);
+    pthread_create(&log->thread, NULL, datalog_writer, log);
+
+    pthread_mutex_lock(&open_logs_lock);
+    log->next = open_logs;
+    open_logs = log;
+    pthread_mutex_unlock(&open_logs_lock);
+
+    ev3dev_DataLog_obj_t *self = m_new_obj_with_finaliser(ev3dev_DataLog_obj_t);
+    self->base.type = &pb_type_ev3dev_DataLog;
+    self->log = log;
+
+    // If column headers were given and the file is empty, write the headers
+    if (n_args > 0 && lseek(log->fd, 0, SEEK_END) == 0) {
+        row_add_values(log, n_args, args);
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t ev3dev_DataLog_log(size_t n_args, const mp_obj_t *args) {
+    ev3dev_DataLog_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    row_add_values(ev3dev_DataLog_get_log(self), n_args - 1, args + 1);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR(ev3dev_DataLog_log_obj, 1, ev3dev_DataLog_log);
+
+STATIC mp_obj_t ev3dev_DataLog_flush(mp_obj_t self_in) {
+    ev3dev_DataLog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    datalog_t *log = ev3dev_DataLog_get_log(self);
+    MP_THREAD_GIL_EXIT();
+    datalog_flush(log);
+    MP_THREAD_GIL_ENTER();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ev3dev_DataLog_flush_obj, ev3dev_DataLog_flush);
+
+STATIC mp_obj_t ev3dev_DataLog_close(mp_obj_t self_in) {
+    ev3dev_DataLog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->log) {
+        datalog_t *log = self->log;
+        self->log = NULL;
+        MP_THREAD_GIL_EXIT();
+        datalog_close(log);
+        MP_THREAD_GIL_ENTER();
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ev3dev_DataLog_close_obj, ev3dev_DataLog_close);
+
+// The finaliser runs during garbage collection, so it keeps the GIL
+STATIC mp_obj_t ev3dev_DataLog___del__(mp_obj_t self_in) {
+    ev3dev_DataLog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->log) {
+        datalog_close(self->log);
+        self->log = NULL;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ev3dev_DataLog___del___obj, ev3dev_DataLog___del__);
+
+STATIC void ev3dev_DataLog_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    ev3dev_DataLog_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    datalog_t *log = ev3dev_DataLog_get_log(self);
+
+    // Like before, printing the log shows the contents of the file
+    MP_THREAD_GIL_EXIT();
+    datalog_flush(log);
+    MP_THREAD_GIL_ENTER();
+
+    int fd = open(log->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        mp_raise_OSError(errno);
+    }
+    char buf[256];
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        mp_print_strn(print, buf, len, 0, 0, 0);
+    }
+    close(fd);
+}
+
+STATIC const mp_rom_map_elem_t ev3dev_DataLog_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&ev3dev_DataLog___del___obj) },
+    { MP_ROM_QSTR(MP_QSTR_log), MP_ROM_PTR(&ev3dev_DataLog_log_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&ev3dev_DataLog_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&ev3dev_DataLog_close_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(ev3dev_DataLog_locals_dict, ev3dev_DataLog_locals_dict_table);
+
+const mp_obj_type_t pb_type_ev3dev_DataLog = {
+    { &mp_type_type },
+    .name = MP_QSTR_DataLog,
+    .print = ev3dev_DataLog_print,
+    .make_new = ev3dev_DataLog_make_new,
+    .locals_dict = (mp_obj_dict_t*)&ev3dev_DataLog_locals_dict,
+};
@@ -22,6 +22,7 @@
 
 #include "modparameters.h"
 #include "pb_ev3dev_types.h"
+#include "pbinit.h"
 #include "pbkwarg.h"
 #include "pbobj.h"
 
@@ -91,6 +92,9 @@ STATIC mp_obj_t ev3dev_Image_new(GrxContext* context) {
 }
 
 STATIC mp_obj_t ev3dev_Image_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    // Images use the pixel format of the screen, so graphics must be set up
+    pybricks_init_display();
+
     enum { ARG_source, ARG_sub, ARG_x1, ARG_y1, ARG_x2, ARG_y2 };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_source, MP_ARG_REQUIRED | MP_ARG_OBJ },
@@ -176,6 +180,8 @@ STATIC mp_obj_t ev3dev_Image_make_new(const mp_obj_type_t *type, size_t n_args,
 }
 
 STATIC mp_obj_t ev3dev_Image_empty(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    pybricks_init_display();
+
     enum { ARG_width, ARG_height };
     const mp_arg_t allowed_args[] = {
         { MP_QSTR_width, MP_ARG_OBJ, { .u_obj = mp_obj_new_int(grx_get_screen_width())} },
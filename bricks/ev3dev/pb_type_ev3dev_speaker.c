@@ -30,6 +30,7 @@
 #include "py/runtime.h"
 
 #include "pb_ev3dev_types.h"
+#include "pbinit.h"
 #include "pbkwarg.h"
 #include "pbobj.h"
 
@@ -38,6 +39,7 @@
 typedef struct _ev3dev_Speaker_obj_t {
     mp_obj_base_t base;
     bool intialized;
+    bool volume_pending;
     int beep_fd;
     char language[10];
     char voice[10];
@@ -71,24 +73,40 @@ STATIC mp_obj_t ev3dev_Speaker_make_new(const mp_obj_type_t *type, size_t n_args
         strncpy(self->speed, "130", sizeof(self->speed));
         strncpy(self->pitch, "50", sizeof(self->pitch));
 
-        nlr_buf_t nlr;
-        if (nlr_push(&nlr) == 0) {
-            mp_obj_t dest[4];
-            mp_load_method(self, MP_QSTR_set_volume, dest);
-            dest[2] = MP_OBJ_NEW_SMALL_INT(100);
-            dest[3] = MP_ROM_QSTR(MP_QSTR__default_);
-            mp_call_method_n_kw(2, 0, dest);
-            nlr_pop();
-        }
-        else {
-            // ignore error
-        }
+        // The default volume is set on first use, see ev3dev_Speaker_init_volume()
+        self->volume_pending = true;
 
         self->intialized = true;
     }
     return MP_OBJ_FROM_PTR(self);
 }
 
+// Sets the default volume, unless this was done already. Spawning amixer
+// takes a while, so this is skipped for programs that never make a sound.
+STATIC void ev3dev_Speaker_init_volume(ev3dev_Speaker_obj_t *self) {
+    if (!self->volume_pending) {
+        return;
+    }
+    self->volume_pending = false;
+
+    uint32_t start = pybricks_startup_usecs();
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t dest[4];
+        mp_load_method(self, MP_QSTR_set_volume, dest);
+        dest[2] = MP_OBJ_NEW_SMALL_INT(100);
+        dest[3] = MP_ROM_QSTR(MP_QSTR__default_);
+        mp_call_method_n_kw(2, 0, dest);
+        nlr_pop();
+    }
+    else {
+        // ignore error
+    }
+
+    pybricks_startup_record("sound", start);
+}
+
 static int set_beep_frequency(ev3dev_Speaker_obj_t *self, int32_t freq) {
     struct input_event event = {
         .type = EV_SND,
@@ -117,6 +135,8 @@ STATIC mp_obj_t ev3dev_Speaker_beep(size_t n_args, const mp_obj_t *pos_args, mp_
         PB_ARG_DEFAULT_INT(duration, 100)
     );
 
+    ev3dev_Speaker_init_volume(self);
+
     mp_int_t freq = pb_obj_get_int(frequency);
     mp_int_t ms = pb_obj_get_int(duration);
 
@@ -329,6 +349,8 @@ STATIC mp_obj_t ev3dev_Speaker_play_notes(size_t n_args, const mp_obj_t *pos_arg
         PB_ARG_DEFAULT_INT(tempo, 120)
     );
 
+    ev3dev_Speaker_init_volume(self);
+
     // length of whole note in milliseconds = 4 quarter/whole * 60 s/min * 1000 ms/s / tempo quarter/min
     int duration = 4 * 60 * 1000 / pb_obj_get_int(tempo);
 
@@ -367,6 +389,8 @@ STATIC mp_obj_t ev3dev_Speaker_play_file(size_t n_args, const mp_obj_t *pos_args
         PB_ARG_REQUIRED(file)
     );
 
+    ev3dev_Speaker_init_volume(self);
+
     const char *path = mp_obj_str_get_str(file);
 
     // FIXME: This function needs to be protected agains re-entrancy to make it
@@ -457,6 +481,8 @@ STATIC mp_obj_t ev3dev_Speaker_say(size_t n_args, const mp_obj_t *pos_args, mp_m
         PB_ARG_REQUIRED(text)
     );
 
+    ev3dev_Speaker_init_volume(self);
+
     const char *text_ = mp_obj_str_get_str(text);
 
     // FIXME: This function needs to be protected agains re-entrancy to make it
@@ -606,7 +632,7 @@ STATIC mp_obj_t ev3dev_Speaker_set_volume(size_t n_args, const mp_obj_t *pos_arg
         PB_ARG_DEFAULT_QSTR(which, _all_)
     );
 
-    (void)self; // unused
+    ev3dev_Speaker_init_volume(self);
 
     mp_int_t volume_ = pb_obj_get_int(volume);
     const char *which_ = mp_obj_str_get_str(which);
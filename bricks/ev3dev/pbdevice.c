@@ -15,6 +15,7 @@
 
 #include <pbio/port.h>
 #include <pbio/iodev.h>
+#include <pbio/record.h>
 
 #include <ev3dev_stretch/lego_sensor.h>
 #include <ev3dev_stretch/nxtcolor.h>
@@ -150,6 +151,25 @@ static pbio_error_t get_values(pbdevice_t *pbdev, uint8_t mode, int32_t *values)
         return err;
     }
 
+    #if PBIO_CONFIG_RECORD
+    uint8_t value_size = 1;
+    switch (pbdev->data_type) {
+        case LEGO_SENSOR_DATA_TYPE_INT16:
+        case LEGO_SENSOR_DATA_TYPE_UINT16:
+        case LEGO_SENSOR_DATA_TYPE_INT16_BE:
+            value_size = 2;
+            break;
+        case LEGO_SENSOR_DATA_TYPE_INT32:
+        case LEGO_SENSOR_DATA_TYPE_UINT32:
+        case LEGO_SENSOR_DATA_TYPE_FLOAT:
+            value_size = 4;
+            break;
+        default:
+            break;
+    }
+    _pbio_record_iodev_data(pbdev->port - PBIO_PORT_1, pbdev->mode, data, pbdev->data_len * value_size);
+    #endif
+
     for (uint8_t i = 0; i < pbdev->data_len; i++) {
         switch (pbdev->data_type) {
             case LEGO_SENSOR_DATA_TYPE_UINT8:
@@ -20,8 +20,11 @@
 #include <pbio/light.h>
 
 #include "py/mpconfig.h"
+#include "py/misc.h"
+#include "py/mphal.h"
 #include "py/mpthread.h"
 
+#include "pb_ev3dev_types.h"
 #include "pbinit.h"
 
 // Flag that indicates whether we are busy stopping the thread
@@ -45,8 +48,57 @@ static void *task_caller(void *arg) {
     return NULL;
 }
 
-// Pybricks initialization tasks
-void pybricks_init() {
+// Startup time report, printed at exit if PYBRICKS_STARTUP_REPORT is set
+typedef struct _startup_step_t {
+    const char *name;
+    uint32_t start;
+    uint32_t duration;
+} startup_step_t;
+
+static startup_step_t startup_steps[8];
+static uint32_t startup_num_steps;
+static struct timespec startup_time;
+
+// Microseconds since pybricks_init() was called
+uint32_t pybricks_startup_usecs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - startup_time.tv_sec) * 1000000 + (now.tv_nsec - startup_time.tv_nsec) / 1000;
+}
+
+// Records the duration of an initialization step that began at start
+void pybricks_startup_record(const char *name, uint32_t start) {
+    if (startup_num_steps < MP_ARRAY_SIZE(startup_steps)) {
+        startup_step_t *step = &startup_steps[startup_num_steps++];
+        step->name = name;
+        step->start = start;
+        step->duration = pybricks_startup_usecs() - start;
+    }
+}
+
+static void startup_report(void) {
+    if (!getenv("PYBRICKS_STARTUP_REPORT")) {
+        return;
+    }
+    fprintf(stderr, "%-12s %10s %10s\n", "step", "start (us)", "time (us)");
+    for (uint32_t i = 0; i < startup_num_steps; i++) {
+        startup_step_t *step = &startup_steps[i];
+        fprintf(stderr, "%-12s %10u %10u\n", step->name, step->start, step->duration);
+    }
+    fprintf(stderr, "%-12s %10u\n", "exit", pybricks_startup_usecs());
+}
+
+// Sets up graphics mode and draws the splash screen. This is done on first
+// use of the screen, since it takes a while and many programs don't need it.
+void pybricks_init_display(void) {
+    static bool initialized;
+    if (initialized) {
+        return;
+    }
+    initialized = true;
+
+    uint32_t start = pybricks_startup_usecs();
+
     GError *error = NULL;
     if (!grx_set_mode_default_graphics(FALSE, &error)) {
         fprintf(stderr, "Could not initialize graphics. Be sure to run using `brickrun -r -- pybricks-micropython`.\n");
@@ -91,7 +143,17 @@ void pybricks_init() {
     };
     grx_draw_filled_convex_polygon(3, triangle, GRX_COLOR_BLACK);
 
+    pybricks_startup_record("display", start);
+}
+
+// Pybricks initialization tasks
+void pybricks_init() {
+    clock_gettime(CLOCK_MONOTONIC, &startup_time);
+
+    uint32_t start = pybricks_startup_usecs();
     pbio_init();
+    pybricks_startup_record("pbio", start);
+
     pbio_light_on_with_pattern(PBIO_PORT_SELF, PBIO_LIGHT_COLOR_GREEN, PBIO_LIGHT_PATTERN_BREATHE); // TODO: define PBIO_LIGHT_PATTERN_EV3_RUN (Or, discuss if we want to use breathe for EV3, too)
     pthread_create(&task_caller_thread, NULL, task_caller, NULL);
 }
@@ -102,9 +164,13 @@ void pybricks_deinit(){
     stopping_thread = true;
     pthread_join(task_caller_thread, NULL);
     pbio_deinit();
+    pb_type_ev3dev_DataLog_close_all();
+    mp_hal_stdout_flush();
+    startup_report();
 }
 
 void pybricks_unhandled_exception() {
+    mp_hal_stdout_flush();
     extern void _pbio_motorpoll_reset_all();
     _pbio_motorpoll_reset_all();
     extern void _pb_ev3dev_speaker_beep_off();
@@ -4,8 +4,16 @@
 #ifndef MICROPY_INCLUDED_PBINIT_H
 #define MICROPY_INCLUDED_PBINIT_H
 
+#include <stdint.h>
+
 void pybricks_init();
 
+void pybricks_init_display(void);
+
+uint32_t pybricks_startup_usecs(void);
+
+void pybricks_startup_record(const char *name, uint32_t start);
+
 void pybricks_deinit();
 
 #endif // MICROPY_INCLUDED_PBINIT_H
@@ -5,6 +5,13 @@
 
 #define PBIO_CONFIG_DCMOTOR                 (1)
 
+#define PBIO_CONFIG_BATTERY_COMPENSATION    (1)
+#define PBIO_CONFIG_BATTERY_NOMINAL_MV      (7500)
+
 #define PBIO_CONFIG_SERIAL                  (1)
 
 #define PBIO_CONFIG_TACHO                   (1)
+
+#define PBIO_CONFIG_RECORD                  (1)
+
+#define PBIO_CONFIG_LOOPSTATS               (1)
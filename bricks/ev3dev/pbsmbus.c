@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <fcntl.h>
 
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 #include <sys/ioctl.h>
 // i2ctools v4 moved smbus functions to a new header file
@@ -15,6 +16,7 @@
 #endif
 
 #include <pbio/error.h>
+#include <pbio/i2c.h>
 
 #include "pbsmbus.h"
 
@@ -154,3 +156,31 @@ pbio_error_t pb_smbus_write_quick(smbus_t *bus, uint8_t address) {
 
     return PBIO_SUCCESS;
 }
+
+pbio_error_t pb_smbus_transfer(void *context, pbio_i2c_msg_t *msgs, uint32_t num_msgs) {
+
+    smbus_t *bus = context;
+    struct i2c_msg i2c_msgs[PBIO_I2C_MAX_MSGS];
+
+    if (num_msgs > PBIO_I2C_MAX_MSGS) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    for (uint32_t i = 0; i < num_msgs; i++) {
+        i2c_msgs[i].addr = msgs[i].address;
+        i2c_msgs[i].flags = msgs[i].flags & PBIO_I2C_MSG_READ ? I2C_M_RD : 0;
+        i2c_msgs[i].len = msgs[i].len;
+        i2c_msgs[i].buf = msgs[i].buf;
+    }
+
+    // All messages go in one combined transaction with repeated starts
+    struct i2c_rdwr_ioctl_data data = {
+        .msgs = i2c_msgs,
+        .nmsgs = num_msgs,
+    };
+    if (ioctl(bus->file, I2C_RDWR, &data) != (int)num_msgs) {
+        return PBIO_ERROR_IO;
+    }
+
+    return PBIO_SUCCESS;
+}
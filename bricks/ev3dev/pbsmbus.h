@@ -11,6 +11,7 @@
 #include <linux/i2c-dev.h>
 #endif
 #include <pbio/error.h>
+#include <pbio/i2c.h>
 
 #define PB_SMBUS_BLOCK_MAX I2C_SMBUS_BLOCK_MAX
 
@@ -30,4 +31,7 @@ pbio_error_t pb_smbus_read_quick(smbus_t *bus, uint8_t address);
 
 pbio_error_t pb_smbus_write_quick(smbus_t *bus, uint8_t address);
 
+// Bus backend for pbio_i2c_dev_t, with the smbus_t as context
+pbio_error_t pb_smbus_transfer(void *context, pbio_i2c_msg_t *msgs, uint32_t num_msgs);
+
 #endif /* _PBSMBUS_H_ */
@@ -4,7 +4,7 @@
 #define MICROPY_HW_BOARD_NAME           "LEGO MINDSTORMS NXT Brick"
 #define MICROPY_HW_MCU_NAME             "AT91SAM7S256"
 
-#define PYBRICKS_HEAP_KB                32 // half of RAM
+#define PYBRICKS_HEAP_KB                28 // half of RAM minus 4 KB for PBIO_CONFIG_ARENA_KB
 
 #define PYBRICKS_HUB_NXT                (1)
 
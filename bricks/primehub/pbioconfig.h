@@ -13,3 +13,5 @@
 
 #define PBIO_CONFIG_ENABLE_DEINIT           (1)
 #define PBIO_CONFIG_ENABLE_SYS              (1)
+
+#define PBIO_CONFIG_ARENA_KB                (64)
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <pbio/button.h>
+#include <pbio/download.h>
 #include <pbio/main.h>
 #include <pbio/light.h>
 #include <pbsys/sys.h>
@@ -23,16 +24,6 @@
 
 #include "py/mphal.h"
 
-// FIXME: Decide whether or not to pre-allocate
-// memory for logging instead or just disable
-// logging altogether on some constrained ports.
-void *malloc(size_t n) {
-    return m_malloc(n);
-}
-void free(void *p) {
-    m_free(p);
-}
-
 static char *stack_top;
 #if MICROPY_ENABLE_GC
 static char heap[PYBRICKS_HEAP_KB * 1024];
@@ -141,6 +132,28 @@ pbio_error_t get_message(uint8_t *buf, uint32_t rx_len, bool clear, int32_t time
     }
 }
 
+// Block numbers are 16 bits, so this limits the program size
+#if MPY_MAX_BYTES > 0xFFFF * PBIO_DOWNLOAD_BLOCK_SIZE
+#error "MPY_MAX_BYTES is too big for the block protocol"
+#endif
+
+// Receive a program of known length with the block protocol
+static pbio_error_t get_blocks(uint8_t *buf, uint32_t len) {
+
+    uint8_t *received = m_new(uint8_t, PBIO_DOWNLOAD_RECEIVED_SIZE(len));
+
+    pbio_download_t dl;
+    pbio_download_init(&dl, buf, len, received, mp_hal_ticks_ms());
+
+    pbio_error_t err;
+    while ((err = pbio_download_poll(&dl, pbsys_stdin_get_char, pbsys_stdout_put_char, mp_hal_ticks_ms())) == PBIO_ERROR_AGAIN) {
+        MICROPY_EVENT_POLL_HOOK
+    }
+
+    m_del(uint8_t, received, PBIO_DOWNLOAD_RECEIVED_SIZE(len));
+    return err;
+}
+
 extern uint32_t __user_flash_start;
 
 // If user says they want to send an MPY file this big (19 MB),
@@ -182,6 +195,20 @@ static uint32_t get_user_program(uint8_t **buf, bool *free_reader) {
         return REPL_LEN;
     }
 
+    // The host may ask for the block protocol, followed by the actual length
+    bool use_blocks = len == PBIO_DOWNLOAD_MAGIC;
+    if (use_blocks) {
+        err = get_message(len_buf, 4, false, 500);
+        if (err != PBIO_SUCCESS) {
+            *buf = NULL;
+            return 0;
+        }
+        len = ((uint32_t) len_buf[0]) << 24 |
+              ((uint32_t) len_buf[1]) << 16 |
+              ((uint32_t) len_buf[2]) << 8 |
+              ((uint32_t) len_buf[3]);
+    }
+
     // Assert that the length is allowed
     if (len > MPY_MAX_BYTES) {
         return 0;
@@ -194,7 +221,11 @@ static uint32_t get_user_program(uint8_t **buf, bool *free_reader) {
     }
 
     // Get the program
-    err = get_message(mpy, len, false, 500);
+    if (use_blocks) {
+        err = get_blocks(mpy, len);
+    } else {
+        err = get_message(mpy, len, false, 500);
+    }
 
     // Did not receive a whole program, so discard it
     if (err != PBIO_SUCCESS) {
@@ -208,6 +208,7 @@ PBIO_SRC_C = $(addprefix ports/pybricks/lib/pbio/,\
 	drv/adc/adc_stm32_hal.c \
 	drv/adc/adc_stm32f0.c \
 	drv/battery/battery_adc.c \
+	drv/bluetooth/bluetooth_tx.c \
 	drv/button/button_adc.c \
 	drv/button/button_gpio.c \
 	drv/counter/counter_core.c \
@@ -221,18 +222,27 @@ PBIO_SRC_C = $(addprefix ports/pybricks/lib/pbio/,\
 	platform/$(PBIO_PLATFORM)/clock.c \
 	platform/$(PBIO_PLATFORM)/platform.c \
 	platform/$(PBIO_PLATFORM)/sys.c \
+	src/arena.c \
+	src/battery.c \
 	src/control.c \
 	src/drivebase.c \
+	src/follow.c \
 	src/error.c \
 	src/dcmotor.c \
+	src/download.c \
 	src/iodev.c \
 	src/light.c \
 	src/logger.c \
+	src/loopstats.c \
 	src/main.c \
 	src/math.c \
+	src/motiongroup.c \
 	src/motorpoll.c \
+	src/record.c \
 	src/servo.c \
+	src/stream.c \
 	src/tacho.c \
+	src/trace.c \
 	src/trajectory.c \
 	src/trajectory_ext.c \
 	src/integrator.c \
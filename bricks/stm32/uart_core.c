@@ -23,13 +23,19 @@ int mp_hal_stdin_rx_chr(void) {
 
 // Send string of given length
 void mp_hal_stdout_tx_strn(const char *str, mp_uint_t len) {
-    uint8_t c;
-
-    while (len--) {
-        c = *str++;
-        while (pbsys_stdout_put_char(c) == PBIO_ERROR_AGAIN) {
+    while (len) {
+        uint32_t size = len;
+        pbio_error_t err = pbsys_stdout_write((const uint8_t *)str, &size);
+        if (err == PBIO_ERROR_AGAIN) {
             // only run pbio events here - don't want keyboard interrupt in middle of printf()
             MICROPY_VM_HOOK_LOOP
+            continue;
+        }
+        if (err != PBIO_SUCCESS) {
+            // no stdout (e.g. not connected), drop the rest
+            return;
         }
+        str += size;
+        len -= size;
     }
 }
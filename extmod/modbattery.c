@@ -8,6 +8,7 @@
 #include "py/obj.h"
 #include <pberror.h>
 #include <pbdrv/battery.h>
+#include <pbio/battery.h>
 
 STATIC mp_obj_t battery_voltage(void) {
     uint16_t volt;
@@ -23,12 +24,25 @@ STATIC mp_obj_t battery_current(void) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(battery_current_obj, battery_current);
 
+#if PBIO_CONFIG_BATTERY_COMPENSATION
+STATIC mp_obj_t battery_compensate(mp_obj_t enable_in) {
+    // Scale motor duty cycles with the battery voltage, so that motors
+    // behave the same with a full or a nearly empty battery
+    pbio_battery_set_compensation(mp_obj_is_true(enable_in));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(battery_compensate_obj, battery_compensate);
+#endif // PBIO_CONFIG_BATTERY_COMPENSATION
+
 /* battery module tables */
 
 STATIC const mp_rom_map_elem_t battery_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_battery)        },
     { MP_ROM_QSTR(MP_QSTR_voltage),     MP_ROM_PTR(&battery_voltage_obj)    },
     { MP_ROM_QSTR(MP_QSTR_current),     MP_ROM_PTR(&battery_current_obj)    },
+#if PBIO_CONFIG_BATTERY_COMPENSATION
+    { MP_ROM_QSTR(MP_QSTR_compensate),  MP_ROM_PTR(&battery_compensate_obj) },
+#endif
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_battery_globals, battery_globals_table);
 
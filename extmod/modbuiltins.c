@@ -135,9 +135,9 @@ mp_obj_t builtins_Control_obj_make_new(pbio_control_t *control) {
     self->control = control;
 
     #if MICROPY_PY_BUILTINS_FLOAT
-    self->scale = mp_obj_new_float(fix16_to_float(control->settings.counts_per_unit));
+    self->scale = mp_obj_new_float(fix16_to_float(control->settings.counts_per_unit.scale));
     #else
-    self->scale = mp_obj_new_int(fix16_to_int(control->settings.counts_per_unit));
+    self->scale = mp_obj_new_int(fix16_to_int(control->settings.counts_per_unit.scale));
     #endif
 
     return self;
@@ -6,6 +6,7 @@
 #include <pbdrv/adc.h>
 #include <pbdrv/button.h>
 #include <pbdrv/uart.h>
+#include <pbio/trace.h>
 
 #include "py/obj.h"
 #include "py/runtime.h"
@@ -100,6 +101,38 @@ STATIC mp_obj_t debug_uart_write(mp_obj_t id_obj, mp_obj_t bytes_obj) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(debug_uart_write_obj, debug_uart_write);
 
+#if PROCESS_CONF_TRACE
+// Prints the scheduler trace buffer. Use tools/trace2chrome.py to convert it.
+STATIC mp_obj_t debug_trace_dump() {
+    uint32_t count = pbio_trace_get_count();
+    pbio_trace_event_t event;
+
+    mp_printf(&mp_plat_print, "trace begin %u\n", (unsigned int)count);
+
+    // Names of the processes that appear in the trace
+    for (int id = 0; id < PBIO_TRACE_ID_OTHER; id++) {
+        const char *name = pbio_trace_get_name(id);
+        if (name != NULL) {
+            mp_printf(&mp_plat_print, "proc %d %s\n", id, name);
+        }
+    }
+
+    // The events as hex encoded binary records, one per line
+    for (uint32_t i = 0; pbio_trace_get_event(i, &event); i++) {
+        const uint8_t *data = (const uint8_t *)&event;
+        for (size_t j = 0; j < sizeof(event); j++) {
+            mp_printf(&mp_plat_print, "%02x", data[j]);
+        }
+        mp_printf(&mp_plat_print, "\n");
+    }
+
+    mp_printf(&mp_plat_print, "trace end\n");
+    pbio_trace_clear();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(debug_trace_dump_obj, debug_trace_dump);
+#endif // PROCESS_CONF_TRACE
+
 STATIC const mp_rom_map_elem_t debug_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),        MP_ROM_QSTR(MP_QSTR_debug)          },
     { MP_ROM_QSTR(MP_QSTR_read_adc),        MP_ROM_PTR(&debug_read_adc_obj)     },
@@ -107,6 +140,9 @@ STATIC const mp_rom_map_elem_t debug_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_uart_baud),       MP_ROM_PTR(&debug_uart_baud_obj)    },
     { MP_ROM_QSTR(MP_QSTR_uart_read),       MP_ROM_PTR(&debug_uart_read_obj)    },
     { MP_ROM_QSTR(MP_QSTR_uart_write),      MP_ROM_PTR(&debug_uart_write_obj)   },
+    #if PROCESS_CONF_TRACE
+    { MP_ROM_QSTR(MP_QSTR_trace_dump),      MP_ROM_PTR(&debug_trace_dump_obj)   },
+    #endif // PROCESS_CONF_TRACE
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_debug_globals, debug_globals_table);
 
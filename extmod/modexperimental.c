@@ -16,10 +16,20 @@
 #include <signal.h>
 #endif // PYBRICKS_HUB_EV3
 
+#include <pbio/arena.h>
+#include <pbio/loopstats.h>
+#include <pbio/record.h>
+
 #include "py/mpthread.h"
 #include "py/obj.h"
 #include "py/runtime.h"
 
+#include "pberror.h"
+
+#if PBIO_CONFIG_RECORD
+#include <stdio.h>
+#endif // PBIO_CONFIG_RECORD
+
 #if PYBRICKS_HUB_EV3
 STATIC void sighandler() {
     // we just want the signal to interrupt system calls
@@ -48,10 +58,110 @@ STATIC mp_obj_t mod_experimental_pthread_raise(mp_obj_t thread_id_in, mp_obj_t e
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_experimental_pthread_raise_obj, mod_experimental_pthread_raise);
 
+#if PBIO_CONFIG_LOOPSTATS
+// Makes a tuple of (count, min, max, mean, histogram) from loop statistics
+STATIC mp_obj_t loop_stats_tuple(const pbio_loopstats_t *stats) {
+    mp_obj_t bins[PBIO_LOOPSTATS_NUM_BINS];
+    for (int i = 0; i < PBIO_LOOPSTATS_NUM_BINS; i++) {
+        bins[i] = mp_obj_new_int_from_uint(stats->bins[i]);
+    }
+    mp_obj_t ret[5];
+    ret[0] = mp_obj_new_int_from_uint(stats->count);
+    ret[1] = mp_obj_new_int_from_uint(stats->count ? stats->min : 0);
+    ret[2] = mp_obj_new_int_from_uint(stats->max);
+    ret[3] = mp_obj_new_int_from_uint(pbio_loopstats_get_mean(stats));
+    ret[4] = mp_obj_new_tuple(PBIO_LOOPSTATS_NUM_BINS, bins);
+    return mp_obj_new_tuple(5, ret);
+}
+
+STATIC mp_obj_t mod_experimental_loop_stats(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t dict = mp_obj_new_dict(6);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_period),
+        loop_stats_tuple(pbio_loopstats_get(PBIO_LOOPSTATS_PERIOD)));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_servo),
+        loop_stats_tuple(pbio_loopstats_get(PBIO_LOOPSTATS_SERVO)));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_drivebase),
+        loop_stats_tuple(pbio_loopstats_get(PBIO_LOOPSTATS_DRIVEBASE)));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_motiongroup),
+        loop_stats_tuple(pbio_loopstats_get(PBIO_LOOPSTATS_MOTIONGROUP)));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_process),
+        loop_stats_tuple(pbio_loopstats_get(PBIO_LOOPSTATS_PROCESS)));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_overruns),
+        mp_obj_new_int_from_uint(pbio_loopstats_get_overruns()));
+
+    // Optionally start collecting new statistics
+    if (n_args > 0 && mp_obj_is_true(args[0])) {
+        pbio_loopstats_reset();
+    }
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_experimental_loop_stats_obj, 0, 1, mod_experimental_loop_stats);
+#endif // PBIO_CONFIG_LOOPSTATS
+
+#if PBIO_CONFIG_ARENA_KB
+STATIC mp_obj_t mod_experimental_arena_stats(void) {
+    pbio_arena_stats_t stats;
+    pbio_arena_get_stats(&stats);
+
+    mp_obj_t dict = mp_obj_new_dict(5);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_size), mp_obj_new_int_from_uint(stats.size));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_used), mp_obj_new_int_from_uint(stats.used));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_peak), mp_obj_new_int_from_uint(stats.peak));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_largest_free), mp_obj_new_int_from_uint(stats.largest_free));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_num_free), mp_obj_new_int_from_uint(stats.num_free));
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mod_experimental_arena_stats_obj, mod_experimental_arena_stats);
+#endif // PBIO_CONFIG_ARENA_KB
+
+#if PBIO_CONFIG_RECORD
+STATIC mp_obj_t mod_experimental_record_start(mp_obj_t size_in) {
+    pb_assert(pbio_record_start(mp_obj_get_int(size_in)));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_experimental_record_start_obj, mod_experimental_record_start);
+
+STATIC mp_obj_t mod_experimental_record_save(mp_obj_t path_in) {
+    const uint8_t *data;
+    uint32_t size;
+
+    // Stop recording and get what we have so far
+    pbio_record_stop();
+    pb_assert(pbio_record_get_data(&data, &size));
+
+    FILE *file = fopen(mp_obj_str_get_str(path_in), "wb");
+    if (file == NULL) {
+        pb_assert(PBIO_ERROR_IO);
+    }
+    pbio_error_t err = PBIO_SUCCESS;
+    if (fwrite(data, 1, size, file) != size) {
+        err = PBIO_ERROR_IO;
+    }
+    if (fclose(file) != 0) {
+        err = PBIO_ERROR_IO;
+    }
+    pb_assert(err);
+
+    // Tell the user if the recording is incomplete
+    return mp_obj_new_bool(!pbio_record_is_full());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_experimental_record_save_obj, mod_experimental_record_save);
+#endif // PBIO_CONFIG_RECORD
+
 STATIC const mp_rom_map_elem_t mod_experimental_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_experimental_c) },
     { MP_ROM_QSTR(MP_QSTR___init__), MP_ROM_PTR(&mod_experimental___init___obj) },
     { MP_ROM_QSTR(MP_QSTR_pthread_raise), MP_ROM_PTR(&mod_experimental_pthread_raise_obj) },
+    #if PBIO_CONFIG_LOOPSTATS
+    { MP_ROM_QSTR(MP_QSTR_loop_stats), MP_ROM_PTR(&mod_experimental_loop_stats_obj) },
+    #endif // PBIO_CONFIG_LOOPSTATS
+    #if PBIO_CONFIG_ARENA_KB
+    { MP_ROM_QSTR(MP_QSTR_arena_stats), MP_ROM_PTR(&mod_experimental_arena_stats_obj) },
+    #endif // PBIO_CONFIG_ARENA_KB
+    #if PBIO_CONFIG_RECORD
+    { MP_ROM_QSTR(MP_QSTR_record_start), MP_ROM_PTR(&mod_experimental_record_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_record_save), MP_ROM_PTR(&mod_experimental_record_save_obj) },
+    #endif // PBIO_CONFIG_RECORD
 };
 STATIC MP_DEFINE_CONST_DICT(mod_experimental_globals, mod_experimental_globals_table);
 
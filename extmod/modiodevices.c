@@ -15,6 +15,7 @@
 #include "modmotor.h"
 #include "modparameters.h"
 
+#include <pbio/i2c.h>
 #include <pbio/iodev.h>
 #include <pbio/serial.h>
 #include <pberror.h>
@@ -134,6 +135,40 @@ STATIC const mp_obj_type_t iodevices_LUMPDevice_type = {
 
 #define UART_MAX_LEN (32*1024)
 
+// Longest time to wait for serial data before checking for Ctrl-C
+#define UART_WAIT_MAX_MS (100)
+
+// Reads len bytes into buf, or raises an exception on timeout
+STATIC void iodevices_serial_read(pbio_serial_t *serial, uint8_t *buf, size_t len) {
+    pbio_error_t err;
+    while ((err = pbio_serial_read(serial, buf, len)) == PBIO_ERROR_AGAIN) {
+        // Sleep until data arrives, instead of polling the port
+        MP_THREAD_GIL_EXIT();
+        err = pbio_serial_wait(serial, UART_WAIT_MAX_MS);
+        MP_THREAD_GIL_ENTER();
+        pb_assert(err);
+        mp_handle_pending();
+    }
+    // Raise io/timeout error if needed.
+    pb_assert(err);
+}
+
+// Reads len bytes into a new bytes object
+STATIC mp_obj_t iodevices_serial_read_bytes(pbio_serial_t *serial, size_t len) {
+
+    if (len > UART_MAX_LEN) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+
+    // Read straight into the memory of the bytes object that is returned
+    vstr_t vstr;
+    vstr_init_len(&vstr, len);
+    if (len > 0) {
+        iodevices_serial_read(serial, (uint8_t *)vstr.buf, len);
+    }
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+
 // pybricks.iodevices.AnalogSensor class object
 typedef struct _iodevices_AnalogSensor_obj_t {
     mp_obj_base_t base;
@@ -230,6 +265,7 @@ typedef struct _iodevices_I2CDevice_obj_t {
     pbdevice_t *pbdev;
     smbus_t *bus;
     int8_t address;
+    pbio_i2c_dev_t i2c;
 } iodevices_I2CDevice_obj_t;
 
 // pybricks.iodevices.I2CDevice.__init__
@@ -257,6 +293,9 @@ STATIC mp_obj_t iodevices_I2CDevice_make_new(const mp_obj_type_t *otype, size_t
     // Get the smbus, which on ev3dev is zero based sensor port number + 3.
     pb_assert(pb_smbus_get(&self->bus, port_num - PBIO_PORT_1 + 3));
 
+    // Batched and cached register access goes through the same bus
+    pbio_i2c_dev_init(&self->i2c, pb_smbus_transfer, self->bus, self->address);
+
     return MP_OBJ_FROM_PTR(self);
 }
 
@@ -302,12 +341,105 @@ STATIC mp_obj_t iodevices_I2CDevice_read(size_t n_args, const mp_obj_t *pos_args
     // Read the given amount of bytes
     uint8_t buf[PB_SMBUS_BLOCK_MAX];
 
+    // Registers that were marked as cached come from the cache after the
+    // first read, which is done the same way as a batch
+    if (len > 0 && len <= PBIO_I2C_MAX_DATA && self->i2c.num_cached > 0) {
+        pbio_i2c_batch_t batch;
+        pbio_i2c_batch_init(&batch, &self->i2c);
+        pb_assert(pbio_i2c_batch_read(&batch, regist, buf, len));
+        pb_assert(pbio_i2c_batch_submit(&batch));
+        return mp_obj_new_bytes(buf, len);
+    }
+
     pb_assert(pb_smbus_read_bytes(self->bus, self->address, regist, len, buf));
 
     return mp_obj_new_bytes(buf, len);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_I2CDevice_read_obj, 1, iodevices_I2CDevice_read);
 
+// pybricks.iodevices.I2CDevice.transfer
+STATIC mp_obj_t iodevices_I2CDevice_transfer(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        iodevices_I2CDevice_obj_t, self,
+        PB_ARG_REQUIRED(operations)
+    );
+
+    // Each operation is (reg, length) to read or (reg, data) to write
+    size_t num_ops;
+    mp_obj_t *ops;
+    mp_obj_get_array(operations, &num_ops, &ops);
+    if (num_ops > PBIO_I2C_MAX_MSGS / 2) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+
+    pbio_i2c_batch_t batch;
+    pbio_i2c_batch_init(&batch, &self->i2c);
+
+    uint8_t bufs[PBIO_I2C_MAX_MSGS / 2][PBIO_I2C_MAX_DATA];
+    uint8_t lens[PBIO_I2C_MAX_MSGS / 2];
+    size_t num_reads = 0;
+
+    for (size_t i = 0; i < num_ops; i++) {
+        mp_obj_t *op;
+        mp_obj_get_array_fixed_n(ops[i], 2, &op);
+
+        mp_int_t regist = mp_obj_get_int(op[0]);
+        if (regist < 0 || regist > 255) {
+            pb_assert(PBIO_ERROR_INVALID_ARG);
+        }
+
+        if (mp_obj_is_int(op[1])) {
+            mp_int_t len = mp_obj_get_int(op[1]);
+            if (len < 1 || len > PBIO_I2C_MAX_DATA) {
+                pb_assert(PBIO_ERROR_INVALID_ARG);
+            }
+            lens[num_reads] = len;
+            pb_assert(pbio_i2c_batch_read(&batch, regist, bufs[num_reads], len));
+            num_reads++;
+        } else {
+            mp_buffer_info_t bufinfo;
+            mp_get_buffer_raise(op[1], &bufinfo, MP_BUFFER_READ);
+            if (bufinfo.len > PBIO_I2C_MAX_DATA) {
+                pb_assert(PBIO_ERROR_INVALID_ARG);
+            }
+            pb_assert(pbio_i2c_batch_write(&batch, regist, bufinfo.buf, bufinfo.len));
+        }
+    }
+
+    // Everything goes to the device as one combined transaction
+    pb_assert(pbio_i2c_batch_submit(&batch));
+
+    // Return the data that was read, in order
+    mp_obj_t results[PBIO_I2C_MAX_MSGS / 2];
+    for (size_t i = 0; i < num_reads; i++) {
+        results[i] = mp_obj_new_bytes(bufs[i], lens[i]);
+    }
+    return mp_obj_new_tuple(num_reads, results);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_I2CDevice_transfer_obj, 1, iodevices_I2CDevice_transfer);
+
+// pybricks.iodevices.I2CDevice.cache
+STATIC mp_obj_t iodevices_I2CDevice_cache(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        iodevices_I2CDevice_obj_t, self,
+        PB_ARG_REQUIRED(reg),
+        PB_ARG_DEFAULT_INT(length, 1)
+    );
+
+    // Mark these registers as read-only, so they are read from the device once
+    mp_int_t regist = mp_obj_get_int(reg);
+    mp_int_t len = mp_obj_get_int(length);
+    if (regist < 0 || regist > 255 || len < 1 || len > PBIO_I2C_MAX_DATA) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+    pb_assert(pbio_i2c_dev_set_cached(&self->i2c, regist, len));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_I2CDevice_cache_obj, 1, iodevices_I2CDevice_cache);
+
 // pybricks.iodevices.I2CDevice.write
 STATIC mp_obj_t iodevices_I2CDevice_write(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
@@ -356,6 +488,9 @@ STATIC mp_obj_t iodevices_I2CDevice_write(size_t n_args, const mp_obj_t *pos_arg
 
     // Otherwise send a block of data
     pb_assert(pb_smbus_write_bytes(self->bus, self->address, regist, len, bytes));
+
+    // Cached values of these registers are out of date now
+    pbio_i2c_dev_invalidate(&self->i2c, regist, len);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_I2CDevice_write_obj, 1, iodevices_I2CDevice_write);
@@ -365,6 +500,8 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_I2CDevice_write_obj, 1, iodevices_I2
 STATIC const mp_rom_map_elem_t iodevices_I2CDevice_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_read),    MP_ROM_PTR(&iodevices_I2CDevice_read_obj)    },
     { MP_ROM_QSTR(MP_QSTR_write),   MP_ROM_PTR(&iodevices_I2CDevice_write_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_transfer), MP_ROM_PTR(&iodevices_I2CDevice_transfer_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cache),   MP_ROM_PTR(&iodevices_I2CDevice_cache_obj)    },
 };
 STATIC MP_DEFINE_CONST_DICT(iodevices_I2CDevice_locals_dict, iodevices_I2CDevice_locals_dict_table);
 
@@ -443,41 +580,6 @@ STATIC mp_obj_t iodevices_UARTDevice_waiting(mp_obj_t self_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(iodevices_UARTDevice_waiting_obj, iodevices_UARTDevice_waiting);
 
-// pybricks.iodevices.UARTDevice._read_internal
-STATIC mp_obj_t iodevices_UARTDevice_read_internal(iodevices_UARTDevice_obj_t *self, size_t len) {
-
-    if (len > UART_MAX_LEN) {
-        pb_assert(PBIO_ERROR_INVALID_ARG);
-    }
-
-    // If we don't need to read anything, return empty bytearray
-    if (len < 1) {
-        uint8_t none = 0;
-        return mp_obj_new_bytes(&none, 0);
-    }
-
-    // Read data into buffer
-    uint8_t *buf = m_malloc(len);
-    if (buf == NULL) {
-        pb_assert(PBIO_ERROR_FAILED);
-    }
-
-    // Read up to the timeout
-    pbio_error_t err;
-    while ((err = pbio_serial_read(self->serial, buf, len)) == PBIO_ERROR_AGAIN) {
-        mp_hal_delay_ms(10);
-    }
-    // Raise io/timeout error if needed.
-    pb_assert(err);
-
-    // Convert to bytes
-    mp_obj_t ret = mp_obj_new_bytes(buf, len);
-
-    // Free internal buffer and return bytes
-    m_free(buf, len);
-    return ret;
-}
-
 // pybricks.iodevices.UARTDevice.read
 STATIC mp_obj_t iodevices_UARTDevice_read(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
@@ -487,7 +589,7 @@ STATIC mp_obj_t iodevices_UARTDevice_read(size_t n_args, const mp_obj_t *pos_arg
     );
 
     size_t len = mp_obj_get_int(length);
-    return iodevices_UARTDevice_read_internal(self, len);
+    return iodevices_serial_read_bytes(self->serial, len);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_UARTDevice_read_obj, 1, iodevices_UARTDevice_read);
 
@@ -499,10 +601,29 @@ STATIC mp_obj_t iodevices_UARTDevice_read_all(mp_obj_t self_in) {
     size_t len;
     pb_assert(pbio_serial_in_waiting(self->serial, &len));
 
-    return iodevices_UARTDevice_read_internal(self, len);
+    return iodevices_serial_read_bytes(self->serial, len);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(iodevices_UARTDevice_read_all_obj, iodevices_UARTDevice_read_all);
 
+// pybricks.iodevices.UARTDevice.read_into
+STATIC mp_obj_t iodevices_UARTDevice_read_into(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        iodevices_UARTDevice_obj_t, self,
+        PB_ARG_REQUIRED(buffer)
+    );
+
+    // Fill the whole buffer, without allocating any memory
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_WRITE);
+    if (bufinfo.len > 0) {
+        iodevices_serial_read(self->serial, bufinfo.buf, bufinfo.len);
+    }
+
+    return mp_obj_new_int(bufinfo.len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_UARTDevice_read_into_obj, 1, iodevices_UARTDevice_read_into);
+
 // pybricks.iodevices.UARTDevice.clear
 STATIC mp_obj_t iodevices_UARTDevice_clear(mp_obj_t self_in) {
     iodevices_UARTDevice_obj_t *self = MP_OBJ_TO_PTR(self_in);
@@ -515,6 +636,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(iodevices_UARTDevice_clear_obj, iodevices_UARTD
 STATIC const mp_rom_map_elem_t iodevices_UARTDevice_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_read),  MP_ROM_PTR(&iodevices_UARTDevice_read_obj) },
     { MP_ROM_QSTR(MP_QSTR_read_all),  MP_ROM_PTR(&iodevices_UARTDevice_read_all_obj) },
+    { MP_ROM_QSTR(MP_QSTR_read_into),  MP_ROM_PTR(&iodevices_UARTDevice_read_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_write),  MP_ROM_PTR(&iodevices_UARTDevice_write_obj) },
     { MP_ROM_QSTR(MP_QSTR_waiting),MP_ROM_PTR(&iodevices_UARTDevice_waiting_obj) },
     { MP_ROM_QSTR(MP_QSTR_clear),MP_ROM_PTR(&iodevices_UARTDevice_clear_obj) },
@@ -729,41 +851,6 @@ STATIC mp_obj_t iodevices_LEGODevice_waiting(mp_obj_t self_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(iodevices_LEGODevice_waiting_obj, iodevices_LEGODevice_waiting);
 
-// pybricks.iodevices.LEGODevice._read_internal
-STATIC mp_obj_t iodevices_LEGODevice_read_internal(iodevices_LEGODevice_obj_t *self, size_t len) {
-
-    if (len > UART_MAX_LEN) {
-        pb_assert(PBIO_ERROR_INVALID_ARG);
-    }
-
-    // If we don't need to read anything, return empty bytearray
-    if (len < 1) {
-        uint8_t none = 0;
-        return mp_obj_new_bytes(&none, 0);
-    }
-
-    // Read data into buffer
-    uint8_t *buf = m_malloc(len);
-    if (buf == NULL) {
-        pb_assert(PBIO_ERROR_FAILED);
-    }
-
-    // Read up to the timeout
-    pbio_error_t err;
-    while ((err = pbio_serial_read(self->serial, buf, len)) == PBIO_ERROR_AGAIN) {
-        mp_hal_delay_ms(10);
-    }
-    // Raise io/timeout error if needed.
-    pb_assert(err);
-
-    // Convert to bytes
-    mp_obj_t ret = mp_obj_new_bytes(buf, len);
-
-    // Free internal buffer and return bytes
-    m_free(buf, len);
-    return ret;
-}
-
 // pybricks.iodevices.LEGODevice.read
 STATIC mp_obj_t iodevices_LEGODevice_read(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
@@ -773,7 +860,7 @@ STATIC mp_obj_t iodevices_LEGODevice_read(size_t n_args, const mp_obj_t *pos_arg
     );
 
     size_t len = mp_obj_get_int(length);
-    return iodevices_LEGODevice_read_internal(self, len);
+    return iodevices_serial_read_bytes(self->serial, len);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_LEGODevice_read_obj, 1, iodevices_LEGODevice_read);
 
@@ -785,7 +872,7 @@ STATIC mp_obj_t iodevices_LEGODevice_read_all(mp_obj_t self_in) {
     size_t len;
     pb_assert(pbio_serial_in_waiting(self->serial, &len));
 
-    return iodevices_LEGODevice_read_internal(self, len);
+    return iodevices_serial_read_bytes(self->serial, len);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(iodevices_LEGODevice_read_all_obj, iodevices_LEGODevice_read_all);
 
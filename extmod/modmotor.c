@@ -6,6 +6,7 @@
 #if PBDRV_CONFIG_NUM_MOTOR_CONTROLLER != 0
 
 #include <inttypes.h>
+#include <string.h>
 
 #include <pbio/servo.h>
 #include <pbio/motorpoll.h>
@@ -466,6 +467,61 @@ STATIC mp_obj_t motor_Motor_track_target(size_t n_args, const mp_obj_t *pos_args
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(motor_Motor_track_target_obj, 1, motor_Motor_track_target);
 
+// pybricks.builtins.Motor.stream
+STATIC mp_obj_t motor_Motor_stream(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        motor_Motor_obj_t, self,
+        PB_ARG_REQUIRED(target_angle),
+        PB_ARG_DEFAULT_NONE(time),
+        PB_ARG_DEFAULT_INT(delay, 50)
+    );
+
+    // Without a time stamp, the setpoint is for the time it arrives here
+    mp_int_t time_arg = time == mp_const_none ? mp_hal_ticks_ms() : pb_obj_get_int(time);
+
+    pb_assert(pbio_servo_stream_target(self->srv, pb_obj_get_int(target_angle), time_arg, pb_obj_get_int(delay)));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(motor_Motor_stream_obj, 1, motor_Motor_stream);
+
+// pybricks.builtins.Motor.follow
+STATIC mp_obj_t motor_Motor_follow(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        motor_Motor_obj_t, self,
+        PB_ARG_REQUIRED(leader),
+        PB_ARG_DEFAULT_INT(ratio, 1),
+        PB_ARG_DEFAULT_NONE(offset),
+        PB_ARG_DEFAULT_NONE(cam),
+        PB_ARG_DEFAULT_INT(cam_period, 360)
+    );
+
+    pbio_servo_t *leader_srv = ((motor_Motor_obj_t*) pb_obj_get_base_class_obj(leader, &motor_Motor_type))->srv;
+
+    // Without an offset, the motors keep their current relative position
+    bool relative = offset == mp_const_none;
+    mp_int_t offset_arg = relative ? 0 : pb_obj_get_int(offset);
+
+    // Get the optional cam profile
+    int32_t cam_arg[PBIO_FOLLOW_CAM_SIZE_MAX];
+    size_t cam_size = 0;
+    if (cam != mp_const_none) {
+        mp_obj_t *cam_objs;
+        mp_obj_get_array(cam, &cam_size, &cam_objs);
+        if (cam_size > PBIO_FOLLOW_CAM_SIZE_MAX) {
+            pb_assert(PBIO_ERROR_INVALID_ARG);
+        }
+        for (size_t i = 0; i < cam_size; i++) {
+            cam_arg[i] = pb_obj_get_int(cam_objs[i]);
+        }
+    }
+
+    pb_assert(pbio_servo_follow(self->srv, leader_srv, pb_obj_get_fix16(ratio), offset_arg, relative, cam_arg, cam_size, pb_obj_get_int(cam_period)));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(motor_Motor_follow_obj, 1, motor_Motor_follow);
+
 // dir(pybricks.builtins.Motor)
 STATIC const mp_rom_map_elem_t motor_Motor_locals_dict_table[] = {
     //
@@ -487,6 +543,8 @@ STATIC const mp_rom_map_elem_t motor_Motor_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_run_angle), MP_ROM_PTR(&motor_Motor_run_angle_obj) },
     { MP_ROM_QSTR(MP_QSTR_run_target), MP_ROM_PTR(&motor_Motor_run_target_obj) },
     { MP_ROM_QSTR(MP_QSTR_track_target), MP_ROM_PTR(&motor_Motor_track_target_obj) },
+    { MP_ROM_QSTR(MP_QSTR_follow), MP_ROM_PTR(&motor_Motor_follow_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stream), MP_ROM_PTR(&motor_Motor_stream_obj) },
     { MP_ROM_QSTR(MP_QSTR_log), MP_ROM_ATTRIBUTE_OFFSET(motor_Motor_obj_t, logger) },
     { MP_ROM_QSTR(MP_QSTR_control), MP_ROM_ATTRIBUTE_OFFSET(motor_Motor_obj_t, control) },
 };
@@ -501,4 +559,183 @@ const mp_obj_type_t motor_Motor_type = {
     .locals_dict = (mp_obj_dict_t*)&motor_Motor_locals_dict,
 };
 
+// pybricks.robotics.MotorGroup class object
+typedef struct _motor_MotorGroup_obj_t {
+    mp_obj_base_t base;
+    uint8_t num_motors;
+    pbio_servo_t *srv[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+} motor_MotorGroup_obj_t;
+
+// pybricks.robotics.MotorGroup.__init__
+STATIC mp_obj_t motor_MotorGroup_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args){
+    PB_PARSE_ARGS_CLASS(n_args, n_kw, args,
+        PB_ARG_REQUIRED(motors)
+    );
+
+    size_t num_motors;
+    mp_obj_t *motors_objs;
+    mp_obj_get_array(motors, &num_motors, &motors_objs);
+    if (num_motors < 1 || num_motors > PBDRV_CONFIG_NUM_MOTOR_CONTROLLER) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+
+    motor_MotorGroup_obj_t *self = m_new_obj(motor_MotorGroup_obj_t);
+    self->base.type = (mp_obj_type_t*) type;
+    self->num_motors = num_motors;
+    for (size_t i = 0; i < num_motors; i++) {
+        self->srv[i] = ((motor_Motor_obj_t*) pb_obj_get_base_class_obj(motors_objs[i], &motor_Motor_type))->srv;
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Gets one value per motor from a list, a tuple, or an array('i')
+STATIC void motor_MotorGroup_get_values(motor_MotorGroup_obj_t *self, mp_obj_t values_in, int32_t *values) {
+    mp_buffer_info_t bufinfo;
+
+    // Arrays are copied as they are, without making int objects
+    if (mp_get_buffer(values_in, &bufinfo, MP_BUFFER_READ)) {
+        if (bufinfo.typecode != 'i' || bufinfo.len != self->num_motors * sizeof(int32_t)) {
+            pb_assert(PBIO_ERROR_INVALID_ARG);
+        }
+        memcpy(values, bufinfo.buf, bufinfo.len);
+        return;
+    }
+
+    size_t num_values;
+    mp_obj_t *values_objs;
+    mp_obj_get_array(values_in, &num_values, &values_objs);
+    if (num_values != self->num_motors) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+    for (size_t i = 0; i < num_values; i++) {
+        values[i] = pb_obj_get_int(values_objs[i]);
+    }
+}
+
+// Returns one value per motor in a new tuple, or in the given list or array('i')
+STATIC mp_obj_t motor_MotorGroup_return_values(motor_MotorGroup_obj_t *self, size_t n_args, const mp_obj_t *args, const int32_t *values) {
+    // Without an output argument, make a new tuple
+    if (n_args < 2) {
+        mp_obj_t ret[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+        for (uint8_t i = 0; i < self->num_motors; i++) {
+            ret[i] = mp_obj_new_int(values[i]);
+        }
+        return mp_obj_new_tuple(self->num_motors, ret);
+    }
+
+    // Otherwise fill the preallocated output, so that loops don't allocate
+    mp_buffer_info_t bufinfo;
+    if (mp_get_buffer(args[1], &bufinfo, MP_BUFFER_WRITE)) {
+        if (bufinfo.typecode != 'i' || bufinfo.len != self->num_motors * sizeof(int32_t)) {
+            pb_assert(PBIO_ERROR_INVALID_ARG);
+        }
+        memcpy(bufinfo.buf, values, bufinfo.len);
+        return args[1];
+    }
+
+    size_t num_values;
+    mp_obj_t *values_objs;
+    mp_obj_list_get(args[1], &num_values, &values_objs);
+    if (num_values != self->num_motors) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+    for (uint8_t i = 0; i < self->num_motors; i++) {
+        values_objs[i] = mp_obj_new_int(values[i]);
+    }
+    return args[1];
+}
+
+// pybricks.robotics.MotorGroup.angles
+STATIC mp_obj_t motor_MotorGroup_angles(size_t n_args, const mp_obj_t *args) {
+    motor_MotorGroup_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    int32_t angles[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+    for (uint8_t i = 0; i < self->num_motors; i++) {
+        pb_assert(pbio_tacho_get_angle(self->srv[i]->tacho, &angles[i]));
+    }
+    return motor_MotorGroup_return_values(self, n_args, args, angles);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(motor_MotorGroup_angles_obj, 1, 2, motor_MotorGroup_angles);
+
+// pybricks.robotics.MotorGroup.speeds
+STATIC mp_obj_t motor_MotorGroup_speeds(size_t n_args, const mp_obj_t *args) {
+    motor_MotorGroup_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    int32_t speeds[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+    for (uint8_t i = 0; i < self->num_motors; i++) {
+        pb_assert(pbio_tacho_get_angular_rate(self->srv[i]->tacho, &speeds[i]));
+    }
+    return motor_MotorGroup_return_values(self, n_args, args, speeds);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(motor_MotorGroup_speeds_obj, 1, 2, motor_MotorGroup_speeds);
+
+// pybricks.robotics.MotorGroup.dc
+STATIC mp_obj_t motor_MotorGroup_dc(mp_obj_t self_in, mp_obj_t duties_in) {
+    motor_MotorGroup_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    int32_t duties[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+    motor_MotorGroup_get_values(self, duties_in, duties);
+    for (uint8_t i = 0; i < self->num_motors; i++) {
+        pb_assert(pbio_servo_set_duty_cycle(self->srv[i], duties[i]));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(motor_MotorGroup_dc_obj, motor_MotorGroup_dc);
+
+// pybricks.robotics.MotorGroup.run
+STATIC mp_obj_t motor_MotorGroup_run(mp_obj_t self_in, mp_obj_t speeds_in) {
+    motor_MotorGroup_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    int32_t speeds[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+    motor_MotorGroup_get_values(self, speeds_in, speeds);
+    for (uint8_t i = 0; i < self->num_motors; i++) {
+        pb_assert(pbio_servo_run(self->srv[i], speeds[i]));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(motor_MotorGroup_run_obj, motor_MotorGroup_run);
+
+// pybricks.robotics.MotorGroup.track_target
+STATIC mp_obj_t motor_MotorGroup_track_target(mp_obj_t self_in, mp_obj_t targets_in) {
+    motor_MotorGroup_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    int32_t targets[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+    motor_MotorGroup_get_values(self, targets_in, targets);
+    for (uint8_t i = 0; i < self->num_motors; i++) {
+        pb_assert(pbio_servo_track_target(self->srv[i], targets[i]));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(motor_MotorGroup_track_target_obj, motor_MotorGroup_track_target);
+
+// pybricks.robotics.MotorGroup.stop
+STATIC mp_obj_t motor_MotorGroup_stop(mp_obj_t self_in) {
+    motor_MotorGroup_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    for (uint8_t i = 0; i < self->num_motors; i++) {
+        pb_assert(pbio_servo_stop(self->srv[i], PBIO_ACTUATION_COAST));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(motor_MotorGroup_stop_obj, motor_MotorGroup_stop);
+
+// dir(pybricks.robotics.MotorGroup)
+STATIC const mp_rom_map_elem_t motor_MotorGroup_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_angles), MP_ROM_PTR(&motor_MotorGroup_angles_obj) },
+    { MP_ROM_QSTR(MP_QSTR_speeds), MP_ROM_PTR(&motor_MotorGroup_speeds_obj) },
+    { MP_ROM_QSTR(MP_QSTR_dc), MP_ROM_PTR(&motor_MotorGroup_dc_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run), MP_ROM_PTR(&motor_MotorGroup_run_obj) },
+    { MP_ROM_QSTR(MP_QSTR_track_target), MP_ROM_PTR(&motor_MotorGroup_track_target_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&motor_MotorGroup_stop_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(motor_MotorGroup_locals_dict, motor_MotorGroup_locals_dict_table);
+
+// type(pybricks.robotics.MotorGroup)
+const mp_obj_type_t motor_MotorGroup_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_MotorGroup,
+    .make_new = motor_MotorGroup_make_new,
+    .locals_dict = (mp_obj_dict_t*)&motor_MotorGroup_locals_dict,
+};
+
 #endif // PBDRV_CONFIG_NUM_MOTOR_CONTROLLER
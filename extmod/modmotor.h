@@ -25,4 +25,6 @@ typedef struct _motor_DCMotor_obj_t {
 
 const mp_obj_type_t motor_DCMotor_type;
 
+const mp_obj_type_t motor_MotorGroup_type;
+
 #endif // PBDRV_CONFIG_NUM_MOTOR_CONTROLLER
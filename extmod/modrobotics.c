@@ -6,6 +6,7 @@
 #include <math.h>
 
 #include <pbio/drivebase.h>
+#include <pbio/motiongroup.h>
 #include <pbio/motorpoll.h>
 
 #include "py/mphal.h"
@@ -277,10 +278,74 @@ STATIC const mp_obj_type_t robotics_DriveBase_type = {
     .locals_dict = (mp_obj_dict_t*)&robotics_DriveBase_locals_dict,
 };
 
+STATIC void wait_for_completion_motiongroup(pbio_motiongroup_t *group) {
+    pbio_error_t err;
+    while ((err = pbio_motorpoll_get_motiongroup_status(group)) == PBIO_ERROR_AGAIN && !pbio_motiongroup_is_done(group)) {
+        // Raise errors of individual servos, such as a disconnected motor
+        for (uint8_t i = 0; i < group->num_axes; i++) {
+            pbio_error_t srv_err = pbio_motorpoll_get_servo_status(group->axes[i]);
+            if (srv_err != PBIO_ERROR_AGAIN) {
+                pb_assert(srv_err);
+            }
+        }
+        mp_hal_delay_ms(5);
+    }
+    if (err != PBIO_ERROR_AGAIN) {
+        pb_assert(err);
+    }
+}
+
+// pybricks.robotics.run_targets
+STATIC mp_obj_t robotics_run_targets(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
+        PB_ARG_REQUIRED(motors),
+        PB_ARG_REQUIRED(speed),
+        PB_ARG_REQUIRED(target_angles),
+        PB_ARG_DEFAULT_OBJ(then, pb_Stop_HOLD_obj),
+        PB_ARG_DEFAULT_TRUE(wait)
+    );
+
+    // Get motors and targets
+    size_t num_motors, num_targets;
+    mp_obj_t *motors_objs, *targets_objs;
+    mp_obj_get_array(motors, &num_motors, &motors_objs);
+    mp_obj_get_array(target_angles, &num_targets, &targets_objs);
+    if (num_motors != num_targets || num_motors > PBDRV_CONFIG_NUM_MOTOR_CONTROLLER) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+
+    pbio_servo_t *servos[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    int32_t targets[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    for (size_t i = 0; i < num_motors; i++) {
+        servos[i] = ((motor_Motor_obj_t*) pb_obj_get_base_class_obj(motors_objs[i], &motor_Motor_type))->srv;
+        targets[i] = pb_obj_get_int(targets_objs[i]);
+    }
+    mp_int_t speed_arg = pb_obj_get_int(speed);
+    pbio_actuation_t after_stop = pb_type_enum_get_value(then, &pb_enum_type_Stop);
+
+    // Set up the motion group and start moving all motors together. The
+    // group is not polled until it is ready, and earlier errors are cleared.
+    pbio_motiongroup_t *group;
+    pb_assert(pbio_motorpoll_get_motiongroup(&group));
+    pb_assert(pbio_motorpoll_set_motiongroup_status(group, PBIO_SUCCESS));
+    pb_assert(pbio_motiongroup_setup(group, servos, num_motors));
+    pb_assert(pbio_motiongroup_run_target(group, speed_arg, targets, after_stop));
+    pb_assert(pbio_motorpoll_set_motiongroup_status(group, PBIO_ERROR_AGAIN));
+
+    if (mp_obj_is_true(wait)) {
+        wait_for_completion_motiongroup(group);
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(robotics_run_targets_obj, 0, robotics_run_targets);
+
 // dir(pybricks.robotics)
 STATIC const mp_rom_map_elem_t robotics_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_robotics)         },
     { MP_ROM_QSTR(MP_QSTR_DriveBase),   MP_ROM_PTR(&robotics_DriveBase_type)  },
+    { MP_ROM_QSTR(MP_QSTR_MotorGroup),  MP_ROM_PTR(&motor_MotorGroup_type)    },
+    { MP_ROM_QSTR(MP_QSTR_run_targets), MP_ROM_PTR(&robotics_run_targets_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_robotics_globals, robotics_globals_table);
 
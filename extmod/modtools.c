@@ -7,6 +7,10 @@
 #include "pbobj.h"
 #include "pbkwarg.h"
 
+#if PYBRICKS_HUB_EV3
+#include "pb_ev3dev_types.h"
+#endif
+
 STATIC mp_obj_t tools_wait(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
         PB_ARG_REQUIRED(time)
@@ -102,6 +106,9 @@ STATIC const mp_rom_map_elem_t tools_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_tools)         },
     { MP_ROM_QSTR(MP_QSTR_wait),        MP_ROM_PTR(&tools_wait_obj)  },
     { MP_ROM_QSTR(MP_QSTR_StopWatch),   MP_ROM_PTR(&tools_StopWatch_type)  },
+    #if PYBRICKS_HUB_EV3
+    { MP_ROM_QSTR(MP_QSTR_DataLog),     MP_ROM_PTR(&pb_type_ev3dev_DataLog)  },
+    #endif
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_tools_globals, tools_globals_table);
 
@@ -71,8 +71,11 @@ bStatus_t ATT_WriteRsp(uint16_t connHandle) {
     return HCI_sendHCICommand(ATT_CMD_WRITE_RSP, buf, 2);
 }
 
+// Largest notification value that fits in one HCI command
+#define ATT_NOTI_MAX_LEN (255 - 5)
+
 bStatus_t ATT_HandleValueNoti(uint16_t connHandle, attHandleValueNoti_t *pNoti) {
-    uint8_t buf[32];
+    uint8_t buf[5 + ATT_NOTI_MAX_LEN];
 
     buf[0] = connHandle & 0xFF;
     buf[1] = (connHandle >> 8) & 0xFF;
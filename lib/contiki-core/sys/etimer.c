@@ -118,6 +118,8 @@ PROCESS_THREAD(etimer_process, ev, data)
       if(timer_expired(&t->timer)) {
 	if(process_post(t->p, PROCESS_EVENT_TIMER, t) == PROCESS_ERR_OK) {
 
+	  PROCESS_TRACE(PROCESS_TRACE_TIMER, t->p, PROCESS_EVENT_TIMER, clock_usecs());
+
 	  /* Reset the process ID of the event timer, to signal that the
 	     etimer has expired. This is later checked in the
 	     etimer_expired() function. */
@@ -48,6 +48,7 @@
 
 #include "sys/process.h"
 #include "sys/arg.h"
+#include "sys/clock.h"
 
 /*
  * Pointer to the currently running process structure.
@@ -66,14 +67,31 @@ struct event_data {
   struct process *p;
 };
 
-static process_num_events_t nevents, fevent;
-static struct event_data events[PROCESS_CONF_NUMEVENTS];
+/*
+ * Ring buffer of events. There is one queue for each priority class.
+ */
+struct event_queue {
+  process_num_events_t nevents, fevent;
+  const process_num_events_t size;
+  struct event_data *const events;
+};
+
+static struct event_data events_normal[PROCESS_CONF_NUMEVENTS];
+static struct event_data events_high[PROCESS_CONF_NUMEVENTS_HIGH];
+
+static struct event_queue queues[PROCESS_PRIORITY_NUM] = {
+  [PROCESS_PRIORITY_NORMAL] = { 0, 0, PROCESS_CONF_NUMEVENTS, events_normal },
+  [PROCESS_PRIORITY_HIGH] = { 0, 0, PROCESS_CONF_NUMEVENTS_HIGH, events_high },
+};
 
 #if PROCESS_CONF_STATS
 process_num_events_t process_maxevents;
 #endif
 
-static volatile unsigned char poll_requested;
+static volatile unsigned char poll_requested[PROCESS_PRIORITY_NUM];
+
+/* Number of process_run() calls in a row that passed over a lower class */
+static unsigned char skipped;
 
 #define PROCESS_STATE_NONE        0
 #define PROCESS_STATE_RUNNING     1
@@ -176,6 +194,9 @@ static void
 call_process(struct process *p, process_event_t ev, process_data_t data)
 {
   int ret;
+#if PROCESS_CONF_TRACE
+  unsigned long start;
+#endif /* PROCESS_CONF_TRACE */
 
 #if DEBUG
   if(p->state == PROCESS_STATE_CALLED) {
@@ -188,7 +209,11 @@ call_process(struct process *p, process_event_t ev, process_data_t data)
     PRINTF("process: calling process '%s' with event 0x%02X\n", PROCESS_NAME_STRING(p), ev);
     process_current = p;
     p->state = PROCESS_STATE_CALLED;
+#if PROCESS_CONF_TRACE
+    start = clock_usecs();
+#endif /* PROCESS_CONF_TRACE */
     ret = p->thread(&p->pt, ev, data);
+    PROCESS_TRACE(PROCESS_TRACE_CALL, p, ev, start);
     if(ret == PT_EXITED ||
        ret == PT_ENDED ||
        ev == PROCESS_EVENT_EXIT) {
@@ -208,9 +233,15 @@ process_exit(struct process *p)
 void
 process_init(void)
 {
+  int prio;
+
   lastevent = PROCESS_EVENT_MAX;
 
-  nevents = fevent = 0;
+  for(prio = 0; prio < PROCESS_PRIORITY_NUM; prio++) {
+    queues[prio].nevents = queues[prio].fevent = 0;
+    poll_requested[prio] = 0;
+  }
+  skipped = 0;
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
 #endif /* PROCESS_CONF_STATS */
@@ -219,18 +250,18 @@ process_init(void)
 }
 /*---------------------------------------------------------------------------*/
 /*
- * Call each process' poll handler.
+ * Call the poll handler of each process in the given priority class.
  */
 /*---------------------------------------------------------------------------*/
 static void
-do_poll(void)
+do_poll(int prio)
 {
   struct process *p;
 
-  poll_requested = 0;
+  poll_requested[prio] = 0;
   /* Call the processes that needs to be polled. */
   for(p = process_list; p != NULL; p = p->next) {
-    if(p->needspoll) {
+    if(p->needspoll && p->priority == prio) {
       p->state = PROCESS_STATE_RUNNING;
       p->needspoll = 0;
       call_process(p, PROCESS_EVENT_POLL, NULL);
@@ -239,12 +270,28 @@ do_poll(void)
 }
 /*---------------------------------------------------------------------------*/
 /*
- * Process the next event in the event queue and deliver it to
- * listening processes.
+ * Call the poll handlers of all processes, highest priority first.
+ */
+/*---------------------------------------------------------------------------*/
+static void
+do_all_polls(void)
+{
+  int prio;
+
+  for(prio = PROCESS_PRIORITY_NUM - 1; prio >= 0; prio--) {
+    if(poll_requested[prio]) {
+      do_poll(prio);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Process the next event in the event queue of the given priority
+ * class and deliver it to listening processes.
  */
 /*---------------------------------------------------------------------------*/
 static void
-do_event(void)
+do_event(struct event_queue *q)
 {
   process_event_t ev;
   process_data_t data;
@@ -259,18 +306,18 @@ do_event(void)
    * call the poll handlers inbetween.
    */
 
-  if(nevents > 0) {
+  if(q->nevents > 0) {
 
     /* There are events that we should deliver. */
-    ev = events[fevent].ev;
+    ev = q->events[q->fevent].ev;
 
-    data = events[fevent].data;
-    receiver = events[fevent].p;
+    data = q->events[q->fevent].data;
+    receiver = q->events[q->fevent].p;
 
     /* Since we have seen the new event, we move pointer upwards
        and decrease the number of events. */
-    fevent = (fevent + 1) % PROCESS_CONF_NUMEVENTS;
-    --nevents;
+    q->fevent = (q->fevent + 1) % q->size;
+    --q->nevents;
 
     /* If this is a broadcast event, we deliver it to all events, in
        order of their priority. */
@@ -279,9 +326,7 @@ do_event(void)
 
 	/* If we have been requested to poll a process, we do this in
 	   between processing the broadcast event. */
-	if(poll_requested) {
-	  do_poll();
-	}
+	do_all_polls();
 	call_process(p, ev, data);
       }
     } else {
@@ -302,38 +347,68 @@ do_event(void)
 int
 process_run(void)
 {
-  /* Process poll events. */
-  if(poll_requested) {
-    do_poll();
+  int prio, highest = -1, lowest = -1;
+
+  for(prio = PROCESS_PRIORITY_NUM - 1; prio >= 0; prio--) {
+    if(poll_requested[prio] || queues[prio].nevents > 0) {
+      if(highest < 0) {
+        highest = prio;
+      }
+      lowest = prio;
+    }
   }
 
-  /* Process one event from the queue */
-  do_event();
+  /* Serve the highest priority class that has work to do, unless a
+     lower class has been waiting too long. Within a class, poll events
+     come before one event from the queue. Other classes wait for the
+     next call. */
+  if(highest >= 0) {
+    if(lowest != highest && skipped >= PROCESS_CONF_MAX_SKIPPED) {
+      prio = lowest;
+      skipped = 0;
+    } else {
+      prio = highest;
+      skipped = lowest != highest ? skipped + 1 : 0;
+    }
+    if(poll_requested[prio]) {
+      do_poll(prio);
+    }
+    do_event(&queues[prio]);
+  }
 
-  return nevents + poll_requested;
+  return process_nevents();
 }
 /*---------------------------------------------------------------------------*/
 int
 process_nevents(void)
 {
-  return nevents + poll_requested;
+  int prio, n = 0;
+
+  for(prio = 0; prio < PROCESS_PRIORITY_NUM; prio++) {
+    n += queues[prio].nevents + poll_requested[prio];
+  }
+  return n;
 }
 /*---------------------------------------------------------------------------*/
 int
 process_post(struct process *p, process_event_t ev, process_data_t data)
 {
   process_num_events_t snum;
+  struct event_queue *q;
 
   if(PROCESS_CURRENT() == NULL) {
     PRINTF("process_post: NULL process posts event 0x%02X to process '%s', nevents %d\n",
-	   ev,PROCESS_NAME_STRING(p), nevents);
+	   ev,PROCESS_NAME_STRING(p), process_nevents());
   } else {
     PRINTF("process_post: Process '%s' posts event 0x%02X to process '%s', nevents %d\n",
 	   PROCESS_NAME_STRING(PROCESS_CURRENT()), ev,
-	   p == PROCESS_BROADCAST? "<broadcast>": PROCESS_NAME_STRING(p), nevents);
+	   p == PROCESS_BROADCAST? "<broadcast>": PROCESS_NAME_STRING(p), process_nevents());
   }
 
-  if(nevents == PROCESS_CONF_NUMEVENTS) {
+  /* Broadcast events are always handled in the normal priority class. */
+  q = &queues[p == PROCESS_BROADCAST ? PROCESS_PRIORITY_NORMAL : p->priority];
+
+  if(q->nevents == q->size) {
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
       printf("soft panic: event queue is full when broadcast event %d was posted from %s\n", ev, PROCESS_NAME_STRING(process_current));
@@ -344,15 +419,17 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
     return PROCESS_ERR_FULL;
   }
 
-  snum = (process_num_events_t)(fevent + nevents) % PROCESS_CONF_NUMEVENTS;
-  events[snum].ev = ev;
-  events[snum].data = data;
-  events[snum].p = p;
-  ++nevents;
+  snum = (process_num_events_t)(q->fevent + q->nevents) % q->size;
+  q->events[snum].ev = ev;
+  q->events[snum].data = data;
+  q->events[snum].p = p;
+  ++q->nevents;
+
+  PROCESS_TRACE(PROCESS_TRACE_POST, p, ev, clock_usecs());
 
 #if PROCESS_CONF_STATS
-  if(nevents > process_maxevents) {
-    process_maxevents = nevents;
+  if(q->nevents > process_maxevents) {
+    process_maxevents = q->nevents;
   }
 #endif /* PROCESS_CONF_STATS */
 
@@ -375,7 +452,7 @@ process_poll(struct process *p)
     if(p->state == PROCESS_STATE_RUNNING ||
        p->state == PROCESS_STATE_CALLED) {
       p->needspoll = 1;
-      poll_requested = 1;
+      poll_requested[p->priority] = 1;
     }
   }
 }
@@ -89,6 +89,32 @@ typedef unsigned char process_num_events_t;
 #define PROCESS_CONF_NUMEVENTS 32
 #endif /* PROCESS_CONF_NUMEVENTS */
 
+/* Size of the event queue for high priority processes */
+#ifndef PROCESS_CONF_NUMEVENTS_HIGH
+#define PROCESS_CONF_NUMEVENTS_HIGH 8
+#endif /* PROCESS_CONF_NUMEVENTS_HIGH */
+
+/* Number of process_run() calls in a row that may pass over a lower
+   priority class that has work, before it gets a turn */
+#ifndef PROCESS_CONF_MAX_SKIPPED
+#define PROCESS_CONF_MAX_SKIPPED 4
+#endif /* PROCESS_CONF_MAX_SKIPPED */
+
+/**
+ * \name Priority classes
+ *
+ * Polls and events for processes in a higher class are handled before
+ * those of lower classes. A lower class that was passed over
+ * PROCESS_CONF_MAX_SKIPPED times in a row is served next, so that a busy
+ * higher class can't starve it. Broadcast events always use the normal
+ * class.
+ * @{
+ */
+#define PROCESS_PRIORITY_NORMAL 0 /**< Default class for housekeeping */
+#define PROCESS_PRIORITY_HIGH   1 /**< Class for time-critical data paths */
+#define PROCESS_PRIORITY_NUM    2 /**< Number of priority classes */
+/** @} */
+
 #define PROCESS_EVENT_NONE            0x80
 #define PROCESS_EVENT_INIT            0x81
 #define PROCESS_EVENT_POLL            0x82
@@ -294,8 +320,12 @@ static PT_THREAD(process_thread_##name(struct pt *process_pt,	\
  * and a human readable string name, which is used when debugging.
  * A configuration option allows removal of the readable name to save RAM.
  *
+ * PROCESS_PRIO() does the same, but also sets the priority class of
+ * the process. Processes declared with PROCESS() have normal priority.
+ *
  * \param name The variable name of the process structure.
  * \param strname The string representation of the process' name.
+ * \param prio The priority class, e.g. PROCESS_PRIORITY_HIGH.
  *
  * \hideinitializer
  */
@@ -304,11 +334,21 @@ static PT_THREAD(process_thread_##name(struct pt *process_pt,	\
   PROCESS_THREAD(name, ev, data);			\
   struct process name = { NULL,		        \
                           process_thread_##name }
+#define PROCESS_PRIO(name, strname, prio)		\
+  PROCESS_THREAD(name, ev, data);			\
+  struct process name = { NULL,		        \
+                          process_thread_##name,	\
+                          { 0 }, 0, 0, prio }
 #else
 #define PROCESS(name, strname)				\
   PROCESS_THREAD(name, ev, data);			\
   struct process name = { NULL, strname,		\
                           process_thread_##name }
+#define PROCESS_PRIO(name, strname, prio)		\
+  PROCESS_THREAD(name, ev, data);			\
+  struct process name = { NULL, strname,		\
+                          process_thread_##name,	\
+                          { 0 }, 0, 0, prio }
 #endif
 
 /** @} */
@@ -323,7 +363,7 @@ struct process {
 #endif
   PT_THREAD((* thread)(struct pt *, process_event_t, process_data_t));
   struct pt pt;
-  unsigned char state, needspoll;
+  unsigned char state, needspoll, priority;
 };
 
 /**
@@ -522,6 +562,40 @@ int process_nevents(void);
 
 /** @} */
 
+/**
+ * \name Scheduler tracing
+ * @{
+ */
+
+#ifndef PROCESS_CONF_TRACE
+#define PROCESS_CONF_TRACE 0
+#endif /* PROCESS_CONF_TRACE */
+
+#define PROCESS_TRACE_POST    0 /**< An event was posted to a process */
+#define PROCESS_TRACE_CALL    1 /**< A process handled an event */
+#define PROCESS_TRACE_TIMER   2 /**< An event timer expired */
+
+#if PROCESS_CONF_TRACE
+/**
+ * Records a scheduler event in the trace buffer.
+ *
+ * This function must be implemented by the platform if tracing
+ * is enabled with PROCESS_CONF_TRACE.
+ *
+ * \param type  The kind of trace event, e.g. PROCESS_TRACE_CALL.
+ * \param p     The process that receives or handles the event.
+ * \param ev    The event.
+ * \param start The value of clock_usecs() when the traced operation began.
+ */
+CCIF void process_trace(unsigned char type, struct process *p,
+                        process_event_t ev, unsigned long start);
+#define PROCESS_TRACE(type, p, ev, start) process_trace(type, p, ev, start)
+#else
+#define PROCESS_TRACE(type, p, ev, start)
+#endif /* PROCESS_CONF_TRACE */
+
+/** @} */
+
 CCIF extern struct process *process_list;
 
 #define PROCESS_LIST() process_list
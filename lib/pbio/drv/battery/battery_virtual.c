@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Battery driver for the virtual hub. The battery is modeled as a voltage
+// source with internal resistance that supplies the hub and the motors.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_BATTERY_VIRTUAL
+
+#include <stdbool.h>
+
+#include <contiki.h>
+
+#include <pbio/error.h>
+
+#include "../virtual/virtual.h"
+
+// Current drawn by the hub itself in A
+#define HUB_CURRENT (0.1f)
+
+static float open_voltage;
+static float resistance;
+static float voltage;
+static float current;
+
+PROCESS(pbdrv_battery_process, "battery");
+
+void _pbdrv_virtual_battery_reset(void) {
+    pbdrv_virtual_battery_set(8000, 500);
+}
+
+float _pbdrv_virtual_battery_step(void) {
+    current = HUB_CURRENT + _pbdrv_virtual_motor_get_battery_current();
+    voltage = open_voltage - current * resistance;
+    return voltage;
+}
+
+/**
+ * Replaces the battery.
+ * @param [in]  voltage_mv      Open circuit voltage in mV
+ * @param [in]  resistance_mohm Internal resistance in mOhm
+ */
+void pbdrv_virtual_battery_set(uint16_t voltage_mv, uint16_t resistance_mohm) {
+    open_voltage = voltage_mv * 1e-3f;
+    resistance = resistance_mohm * 1e-3f;
+    _pbdrv_virtual_battery_step();
+}
+
+pbio_error_t pbdrv_battery_get_voltage_now(uint16_t *value) {
+    *value = voltage * 1000;
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_battery_get_current_now(uint16_t *value) {
+    *value = current * 1000;
+    return PBIO_SUCCESS;
+}
+
+PROCESS_THREAD(pbdrv_battery_process, ev, data) {
+    PROCESS_BEGIN();
+
+    while (true) {
+        PROCESS_WAIT_EVENT();
+    }
+
+    PROCESS_END();
+}
+
+#endif // PBDRV_CONFIG_BATTERY_VIRTUAL
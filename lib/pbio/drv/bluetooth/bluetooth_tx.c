@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Ring buffer for data sent with the Bluetooth UART service. Writers can add
+// any number of bytes at once. The driver takes out as much as fits in one
+// notification for the negotiated MTU, so that small writes are coalesced.
+
+#include <stdint.h>
+
+#include "bluetooth_tx.h"
+
+#define BUF_MASK (PBDRV_CONFIG_BLUETOOTH_TX_BUF_SIZE - 1)
+
+void pbdrv_bluetooth_tx_queue_reset(pbdrv_bluetooth_tx_queue_t *q) {
+    q->head = q->tail = 0;
+}
+
+uint32_t pbdrv_bluetooth_tx_queue_count(pbdrv_bluetooth_tx_queue_t *q) {
+    return (q->head - q->tail) & BUF_MASK;
+}
+
+/**
+ * Adds data to the queue.
+ * @param [in]  q       The queue
+ * @param [in]  data    The data to add
+ * @param [in]  size    Number of bytes in data
+ * @return              Number of bytes that fit in the queue
+ */
+uint32_t pbdrv_bluetooth_tx_queue_write(pbdrv_bluetooth_tx_queue_t *q, const uint8_t *data, uint32_t size) {
+    // One byte is kept free to tell a full buffer from an empty one
+    uint32_t space = BUF_MASK - pbdrv_bluetooth_tx_queue_count(q);
+    if (size > space) {
+        size = space;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        q->buf[q->head] = data[i];
+        q->head = (q->head + 1) & BUF_MASK;
+    }
+    return size;
+}
+
+/**
+ * Copies the oldest data in the queue into a packet, without removing it.
+ * @param [in]  q           The queue
+ * @param [out] packet      Buffer for the packet
+ * @param [in]  max_size    Maximum number of bytes in the packet
+ * @return                  Number of bytes copied
+ */
+uint32_t pbdrv_bluetooth_tx_queue_peek(pbdrv_bluetooth_tx_queue_t *q, uint8_t *packet, uint32_t max_size) {
+    uint32_t size = pbdrv_bluetooth_tx_queue_count(q);
+    if (size > max_size) {
+        size = max_size;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        packet[i] = q->buf[(q->tail + i) & BUF_MASK];
+    }
+    return size;
+}
+
+/**
+ * Removes data from the queue once it has been sent. If the queue was reset
+ * while the data was being sent, there is nothing left to remove.
+ * @param [in]  q       The queue
+ * @param [in]  size    Number of bytes to remove
+ */
+void pbdrv_bluetooth_tx_queue_drop(pbdrv_bluetooth_tx_queue_t *q, uint32_t size) {
+    uint32_t count = pbdrv_bluetooth_tx_queue_count(q);
+    if (size > count) {
+        size = count;
+    }
+    q->tail = (q->tail + size) & BUF_MASK;
+}
@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Outgoing data queue for the Bluetooth UART service, shared by the drivers
+
+#ifndef _PBDRV_BLUETOOTH_BLUETOOTH_TX_H_
+#define _PBDRV_BLUETOOTH_BLUETOOTH_TX_H_
+
+#include <stdint.h>
+
+#include <pbdrv/config.h>
+
+// Size of the outgoing ring buffer - must be power of 2!
+#ifndef PBDRV_CONFIG_BLUETOOTH_TX_BUF_SIZE
+#define PBDRV_CONFIG_BLUETOOTH_TX_BUF_SIZE (256)
+#endif
+
+// Payload of a notification for the default ATT MTU of 23
+#define PBDRV_BLUETOOTH_TX_MIN_PAYLOAD (20)
+
+typedef struct {
+    uint8_t buf[PBDRV_CONFIG_BLUETOOTH_TX_BUF_SIZE];
+    uint16_t head;
+    uint16_t tail;
+} pbdrv_bluetooth_tx_queue_t;
+
+void pbdrv_bluetooth_tx_queue_reset(pbdrv_bluetooth_tx_queue_t *q);
+uint32_t pbdrv_bluetooth_tx_queue_write(pbdrv_bluetooth_tx_queue_t *q, const uint8_t *data, uint32_t size);
+uint32_t pbdrv_bluetooth_tx_queue_count(pbdrv_bluetooth_tx_queue_t *q);
+uint32_t pbdrv_bluetooth_tx_queue_peek(pbdrv_bluetooth_tx_queue_t *q, uint8_t *packet, uint32_t max_size);
+void pbdrv_bluetooth_tx_queue_drop(pbdrv_bluetooth_tx_queue_t *q, uint32_t size);
+
+#endif // _PBDRV_BLUETOOTH_BLUETOOTH_TX_H_
@@ -17,8 +17,9 @@
 #include "counter_nxt.h"
 #include "counter_ev3dev_stretch_iio.h"
 #include "counter_stm32f0_gpio_quad_enc.h"
+#include "counter_virtual.h"
 
-PROCESS(pbdrv_counter_process, "counter driver");
+PROCESS_PRIO(pbdrv_counter_process, "counter driver", PROCESS_PRIORITY_HIGH);
 
 static pbdrv_counter_dev_t *pbdrv_counters[PBDRV_CONFIG_COUNTER_NUM_DEV];
 
@@ -105,6 +106,9 @@ static void pbdrv_counter_process_exit() {
 #if PBDRV_CONFIG_COUNTER_STM32F0_GPIO_QUAD_ENC
     pbdrv_counter_stm32f0_gpio_quad_enc_drv.exit();
 #endif
+#if PBDRV_CONFIG_COUNTER_VIRTUAL
+    pbdrv_counter_virtual_drv.exit();
+#endif
 }
 
 PROCESS_THREAD(pbdrv_counter_process, ev, data) {
@@ -121,6 +125,9 @@ PROCESS_THREAD(pbdrv_counter_process, ev, data) {
 #if PBDRV_CONFIG_COUNTER_STM32F0_GPIO_QUAD_ENC
     pbdrv_counter_stm32f0_gpio_quad_enc_drv.init();
 #endif
+#if PBDRV_CONFIG_COUNTER_VIRTUAL
+    pbdrv_counter_virtual_drv.init();
+#endif
 
     while (true) {
         PROCESS_WAIT_EVENT();
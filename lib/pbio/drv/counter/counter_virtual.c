@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Quadrature encoders on the simulated motors of the virtual hub.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_COUNTER_VIRTUAL
+
+#include <math.h>
+#include <stdint.h>
+
+#include <pbio/util.h>
+#include <pbio/port.h>
+#include "counter.h"
+
+#include "../virtual/virtual.h"
+
+typedef struct {
+    pbdrv_counter_dev_t dev;
+    pbio_port_t port;
+} private_data_t;
+
+static private_data_t private_data[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+static pbio_error_t pbdrv_counter_virtual_get_count(pbdrv_counter_dev_t *dev, int32_t *count) {
+    private_data_t *data = PBIO_CONTAINER_OF(dev, private_data_t, dev);
+    float angle, speed, current;
+
+    pbio_error_t err = pbdrv_virtual_motor_get_state(data->port, &angle, &speed, &current);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Like a real encoder, only count whole steps
+    *count = floorf(angle * PBDRV_CONFIG_COUNTER_COUNTS_PER_DEGREE);
+
+    return PBIO_SUCCESS;
+}
+
+static pbio_error_t pbdrv_counter_virtual_get_rate(pbdrv_counter_dev_t *dev, int32_t *rate) {
+    private_data_t *data = PBIO_CONTAINER_OF(dev, private_data_t, dev);
+    float angle, speed, current;
+
+    pbio_error_t err = pbdrv_virtual_motor_get_state(data->port, &angle, &speed, &current);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    *rate = lroundf(speed * PBDRV_CONFIG_COUNTER_COUNTS_PER_DEGREE);
+
+    return PBIO_SUCCESS;
+}
+
+static pbio_error_t counter_virtual_init() {
+    for (int i = 0; i < PBIO_ARRAY_SIZE(private_data); i++) {
+        private_data_t *data = &private_data[i];
+
+        data->port = PBDRV_CONFIG_FIRST_MOTOR_PORT + i;
+        data->dev.get_count = pbdrv_counter_virtual_get_count;
+        data->dev.get_rate = pbdrv_counter_virtual_get_rate;
+        data->dev.initalized = true;
+
+        // Counter IDs of the motor ports come first, see pbio_tacho_get()
+        pbdrv_counter_register(i, &data->dev);
+    }
+
+    return PBIO_SUCCESS;
+}
+
+static pbio_error_t counter_virtual_exit() {
+    for (int i = 0; i < PBIO_ARRAY_SIZE(private_data); i++) {
+        private_data_t *data = &private_data[i];
+
+        data->dev.initalized = false;
+        pbdrv_counter_unregister(&data->dev);
+    }
+    return PBIO_SUCCESS;
+}
+
+const pbdrv_counter_drv_t pbdrv_counter_virtual_drv = {
+    .init   = counter_virtual_init,
+    .exit   = counter_virtual_exit,
+};
+
+#endif // PBDRV_CONFIG_COUNTER_VIRTUAL
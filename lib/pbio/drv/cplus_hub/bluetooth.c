@@ -22,6 +22,7 @@
 #include "sys/process.h"
 #include "sys/pt.h"
 #include "../../src/processes.h"
+#include "../bluetooth/bluetooth_tx.h"
 
 #include <stm32l4xx_hal.h>
 
@@ -62,7 +63,8 @@
 #define NO_CONNECTION           0xFFFF
 
 // max data size for nRF UART characteristics
-#define NRF_CHAR_SIZE 20
+// ATT MTU that we support
+#define SERVER_RX_MTU 158
 
 
 // Tx buffer for SPI writes
@@ -98,12 +100,14 @@ static uint16_t pybricks_service_handle, pybricks_service_end_handle, pybricks_c
 static uint16_t uart_service_handle, uart_service_end_handle, uart_rx_char_handle, uart_tx_char_handle;
 // nRF UART tx notifications enabled
 static bool uart_tx_notify_en;
-// nRF UART tx is in progress
-static bool uart_tx_busy;
-// buffer to queue UART tx data
-static uint8_t uart_tx_buf[NRF_CHAR_SIZE];
+// queue of UART tx data waiting to be sent
+static pbdrv_bluetooth_tx_queue_t uart_tx_queue;
+// buffer for the UART tx notification that is being sent
+static uint8_t uart_tx_buf[SERVER_RX_MTU - 3];
 // bytes used in uart_tx_buf
 static uint8_t uart_tx_buf_size;
+// maximum notification size for the MTU of the current connection
+static uint8_t uart_tx_max_size = PBDRV_BLUETOOTH_TX_MIN_PAYLOAD;
 
 // 6e400001-b5a3-f393-e0a-9e50e24dcca9e
 static const uint8_t pybricks_service_uuid[] = {
@@ -339,9 +343,13 @@ static void handle_event(uint8_t *packet) {
             case ATT_EVENT_EXCHANGE_MTU_REQ:
                 {
                     attExchangeMTURsp_t rsp;
+                    uint16_t client_rx_mtu = (data[7] << 8) | data[6];
 
-                    rsp.serverRxMTU = 158;
+                    rsp.serverRxMTU = SERVER_RX_MTU;
                     ATT_ExchangeMTURsp(connection_handle, &rsp);
+
+                    // notifications can use the smaller of both MTUs, minus the ATT header
+                    uart_tx_max_size = (client_rx_mtu < SERVER_RX_MTU ? client_rx_mtu : SERVER_RX_MTU) - 3;
                 }
                 break;
             case ATT_EVENT_READ_BY_TYPE_REQ:
@@ -625,6 +633,8 @@ static void handle_event(uint8_t *packet) {
                     if (conn_handle == connection_handle) {
                         conn_handle = NO_CONNECTION;
                         uart_tx_notify_en = false;
+                        uart_tx_max_size = PBDRV_BLUETOOTH_TX_MIN_PAYLOAD;
+                        pbdrv_bluetooth_tx_queue_reset(&uart_tx_queue);
                     }
                 }
                 break;
@@ -1162,30 +1172,30 @@ static PT_THREAD(set_discoverable(struct pt *pt)) {
     PT_END(pt);
 }
 
-pbio_error_t pbdrv_bluetooth_tx(uint8_t c) {
+pbio_error_t pbdrv_bluetooth_tx_buf(const uint8_t *data, uint32_t *size) {
     // make sure we have a Bluetooth connection
     if (!uart_tx_notify_en) {
         return PBIO_ERROR_INVALID_OP;
     }
 
-    // can't add the the buffer if tx is in progress or buffer is full
-    if (uart_tx_busy || uart_tx_buf_size == NRF_CHAR_SIZE) {
+    // queue as much as fits
+    *size = pbdrv_bluetooth_tx_queue_write(&uart_tx_queue, data, *size);
+    if (*size == 0) {
         return PBIO_ERROR_AGAIN;
     }
 
-    // append the char
-    uart_tx_buf[uart_tx_buf_size] = c;
-    uart_tx_buf_size++;
-
     // poke the process to start tx soon-ish. This way, we can accumulate up to
-    // NRF_CHAR_SIZE bytes before actually transmitting
-    // TODO: it probably would be better to poll here instead of using events
-    // so that we don't fill up the event queue with 20 events
-    process_post(&pbdrv_bluetooth_hci_process, PROCESS_EVENT_MSG, NULL);
+    // uart_tx_max_size bytes before actually transmitting
+    process_poll(&pbdrv_bluetooth_hci_process);
 
     return PBIO_SUCCESS;
 }
 
+pbio_error_t pbdrv_bluetooth_tx(uint8_t c) {
+    uint32_t size = 1;
+    return pbdrv_bluetooth_tx_buf(&c, &size);
+}
+
 static PT_THREAD(uart_service_send_data(struct pt *pt))
 {
     PT_BEGIN(pt);
@@ -1281,11 +1291,11 @@ PROCESS_THREAD(pbdrv_bluetooth_hci_process, ev, data) {
                 // just occasionally checking to see if we are still connected
                 continue;
             }
-            if (ev == PROCESS_EVENT_MSG && uart_tx_buf_size) {
-                uart_tx_busy = true;
+            // send queued data, including anything added while sending
+            while (pbdrv_bluetooth_tx_queue_count(&uart_tx_queue)) {
+                uart_tx_buf_size = pbdrv_bluetooth_tx_queue_peek(&uart_tx_queue, uart_tx_buf, uart_tx_max_size);
                 PROCESS_PT_SPAWN(&child_pt, uart_service_send_data(&child_pt));
-                uart_tx_busy = false;
-                uart_tx_buf_size = 0;
+                pbdrv_bluetooth_tx_queue_drop(&uart_tx_queue, uart_tx_buf_size);
             }
         }
 
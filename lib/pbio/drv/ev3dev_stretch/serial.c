@@ -6,6 +6,7 @@
 
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <termios.h>
 #include <unistd.h>
@@ -153,6 +154,28 @@ pbio_error_t pbdrv_serial_read(pbdrv_serial_t *ser, uint8_t *buf, size_t count,
     return PBIO_SUCCESS;
 }
 
+pbio_error_t pbdrv_serial_wait(pbdrv_serial_t *ser, int timeout) {
+    struct pollfd fds = {
+        .fd = ser->file,
+        .events = POLLIN,
+    };
+    int ret = poll(&fds, 1, timeout);
+    if (ret < 0) {
+        // Interrupted by a signal, so let the caller check for it
+        if (errno == EINTR) {
+            return PBIO_ERROR_AGAIN;
+        }
+        return PBIO_ERROR_IO;
+    }
+    if (ret == 0) {
+        return PBIO_ERROR_TIMEDOUT;
+    }
+    if (fds.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        return PBIO_ERROR_IO;
+    }
+    return PBIO_SUCCESS;
+}
+
 pbio_error_t pbdrv_serial_clear(pbdrv_serial_t *ser) {
     if (tcflush(ser->file, TCIOFLUSH) != 0) {
         return PBIO_ERROR_IO;
@@ -27,6 +27,7 @@ typedef struct {
 } ev3dev_port_t;
 
 static ev3dev_port_t *ev3dev_ports;
+static bool started;
 
 PROCESS(pbdrv_ioport_ev3dev_stretch_process, "ev3dev-stretch I/O port");
 
@@ -98,6 +99,13 @@ pbio_error_t pbdrv_ioport_ev3dev_get_syspath(pbio_port_t port, const char **sysp
         return PBIO_ERROR_INVALID_PORT;
     }
 
+    // Scanning udev takes a while, so it is done on first use instead of
+    // at startup. Starting the process enumerates the ports right away.
+    if (!started) {
+        started = true;
+        process_start(&pbdrv_ioport_ev3dev_stretch_process, NULL);
+    }
+
     p = find_port(name);
     if (!p) {
         return PBIO_ERROR_NO_DEV;
@@ -17,6 +17,7 @@
 #include "pbio/event.h"
 #include "pbsys/sys.h"
 #include "../../src/processes.h"
+#include "../bluetooth/bluetooth_tx.h"
 
 #include "bluenrg_aci.h"
 #include "bluenrg_gap.h"
@@ -73,9 +74,9 @@ static uint16_t pybricks_service_handle, pybricks_char_handle;
 
 // nRF UART GATT service handles
 static uint16_t uart_service_handle, uart_rx_char_handle, uart_tx_char_handle;
-// nRF UART tx is in progress
-static bool uart_tx_busy;
-// buffer to queue UART tx data
+// queue of UART tx data waiting to be sent
+static pbdrv_bluetooth_tx_queue_t uart_tx_queue;
+// buffer for the UART tx notification that is being sent
 static uint8_t uart_tx_buf[NRF_CHAR_SIZE];
 // bytes used in uart_tx_buf
 static uint8_t uart_tx_buf_size;
@@ -301,6 +302,7 @@ static void handle_event(hci_event_pckt *event) {
             evt_disconn_complete *evt = (evt_disconn_complete *)event->data;
             if (conn_handle == evt->handle) {
                 conn_handle = 0;
+                pbdrv_bluetooth_tx_queue_reset(&uart_tx_queue);
             }
         }
         break;
@@ -618,30 +620,30 @@ static PT_THREAD(set_discoverable(struct pt *pt)) {
     PT_END(pt);
 }
 
-pbio_error_t pbdrv_bluetooth_tx(uint8_t c) {
+pbio_error_t pbdrv_bluetooth_tx_buf(const uint8_t *data, uint32_t *size) {
     // make sure we have a Bluetooth connection
     if (!conn_handle) {
         return PBIO_ERROR_INVALID_OP;
     }
 
-    // can't add the the buffer if tx is in progress or buffer is full
-    if (uart_tx_busy || uart_tx_buf_size == NRF_CHAR_SIZE) {
+    // queue as much as fits
+    *size = pbdrv_bluetooth_tx_queue_write(&uart_tx_queue, data, *size);
+    if (*size == 0) {
         return PBIO_ERROR_AGAIN;
     }
 
-    // append the char
-    uart_tx_buf[uart_tx_buf_size] = c;
-    uart_tx_buf_size++;
-
     // poke the process to start tx soon-ish. This way, we can accumulate up to
     // NRF_CHAR_SIZE bytes before actually transmitting
-    // TODO: it probably would be better to poll here instead of using events
-    // so that we don't fill up the event queue with 20 events
-    process_post(&pbdrv_bluetooth_hci_process, PROCESS_EVENT_MSG, NULL);
+    process_poll(&pbdrv_bluetooth_hci_process);
 
     return PBIO_SUCCESS;
 }
 
+pbio_error_t pbdrv_bluetooth_tx(uint8_t c) {
+    uint32_t size = 1;
+    return pbdrv_bluetooth_tx_buf(&c, &size);
+}
+
 static PT_THREAD(uart_service_send_data(struct pt *pt))
 {
     tBleStatus ret;
@@ -703,11 +705,11 @@ PROCESS_THREAD(pbdrv_bluetooth_hci_process, ev, data) {
                 // just occasionally checking to see if we are still connected
                 continue;
             }
-            if (ev == PROCESS_EVENT_MSG && uart_tx_buf_size) {
-                uart_tx_busy = true;
+            // send queued data, including anything added while sending
+            while (pbdrv_bluetooth_tx_queue_count(&uart_tx_queue)) {
+                uart_tx_buf_size = pbdrv_bluetooth_tx_queue_peek(&uart_tx_queue, uart_tx_buf, NRF_CHAR_SIZE);
                 PROCESS_PT_SPAWN(&child_pt, uart_service_send_data(&child_pt));
-                uart_tx_busy = false;
-                uart_tx_buf_size = 0;
+                pbdrv_bluetooth_tx_queue_drop(&uart_tx_queue, uart_tx_buf_size);
             }
         }
 
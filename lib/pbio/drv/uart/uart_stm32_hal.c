@@ -32,7 +32,7 @@ typedef struct {
 
 static pbdrv_uart_t pbdrv_uart[PBDRV_CONFIG_UART_STM32_HAL_NUM_UART];
 
-PROCESS(pbdrv_uart_process, "UART");
+PROCESS_PRIO(pbdrv_uart_process, "UART", PROCESS_PRIORITY_HIGH);
 
 pbio_error_t pbdrv_uart_get(uint8_t id, pbdrv_uart_dev_t **uart_dev) {
     if (id >= PBDRV_CONFIG_UART_STM32_HAL_NUM_UART) {
@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// UART driver for the virtual hub. Instead of a wire, the other end of each
+// UART is a simulated device that exchanges whole byte arrays with the hub.
+// Like on a real UART, received bytes are buffered until they are read.
+
+#include "pbdrv/config.h"
+
+#if PBDRV_CONFIG_UART_VIRTUAL
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <contiki.h>
+
+#include <pbdrv/uart.h>
+#include <pbio/error.h>
+#include <pbio/util.h>
+
+#include "../../src/processes.h"
+#include "../virtual/virtual.h"
+
+#define UART_RING_BUF_SIZE 512  // must be a power of 2!
+
+typedef struct {
+    pbdrv_uart_dev_t uart_dev;
+    uint8_t rx_ring_buf[UART_RING_BUF_SIZE];
+    uint16_t rx_ring_buf_head;
+    uint16_t rx_ring_buf_tail;
+    uint8_t *rx_buf;
+    uint8_t rx_buf_size;
+    uint8_t rx_buf_index;
+    uint8_t *tx_buf;
+    struct etimer rx_timer;
+    pbio_error_t rx_result;
+    pbio_error_t tx_result;
+    uint32_t baud;
+    bool initalized;
+} pbdrv_uart_t;
+
+static pbdrv_uart_t pbdrv_uart[PBDRV_CONFIG_UART_VIRTUAL_NUM_UART];
+
+PROCESS_PRIO(pbdrv_uart_process, "UART", PROCESS_PRIORITY_HIGH);
+
+void _pbdrv_virtual_uart_reset(void) {
+    for (int i = 0; i < PBDRV_CONFIG_UART_VIRTUAL_NUM_UART; i++) {
+        pbdrv_uart[i].rx_ring_buf_head = 0;
+        pbdrv_uart[i].rx_ring_buf_tail = 0;
+    }
+}
+
+/**
+ * Sends bytes from the simulated device to the hub.
+ * @param [in]  uart_id     The UART
+ * @param [in]  speed       Baud rate used by the device
+ * @param [in]  data        The bytes
+ * @param [in]  size        Number of bytes
+ */
+void _pbdrv_virtual_uart_send(uint8_t uart_id, uint32_t speed, const uint8_t *data, uint8_t size) {
+    pbdrv_uart_t *uart = &pbdrv_uart[uart_id];
+
+    // The hub can't make sense of bytes sent at a different baud rate
+    if (speed != uart->baud) {
+        return;
+    }
+
+    for (int i = 0; i < size; i++) {
+        uint16_t next = (uart->rx_ring_buf_head + 1) & (UART_RING_BUF_SIZE - 1);
+        if (next == uart->rx_ring_buf_tail) {
+            // overrun, drop the rest like the hardware would
+            break;
+        }
+        uart->rx_ring_buf[uart->rx_ring_buf_head] = data[i];
+        uart->rx_ring_buf_head = next;
+    }
+
+    process_poll(&pbdrv_uart_process);
+}
+
+pbio_error_t pbdrv_uart_get(uint8_t id, pbdrv_uart_dev_t **uart_dev) {
+    if (id >= PBDRV_CONFIG_UART_VIRTUAL_NUM_UART) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (!pbdrv_uart[id].initalized) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    *uart_dev = &pbdrv_uart[id].uart_dev;
+
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_uart_read_begin(pbdrv_uart_dev_t *uart_dev, uint8_t *msg, uint8_t length, uint32_t timeout) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    if (!msg || !length) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (uart->rx_buf) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    uart->rx_buf = msg;
+    uart->rx_buf_size = length;
+    uart->rx_buf_index = 0;
+    uart->rx_result = PBIO_ERROR_AGAIN;
+
+    etimer_set(&uart->rx_timer, clock_from_msec(timeout));
+
+    process_poll(&pbdrv_uart_process);
+
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_uart_read_end(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+    pbio_error_t err = uart->rx_result;
+
+    if (uart->rx_buf == NULL) {
+        // begin was not called first
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    if (err != PBIO_ERROR_AGAIN) {
+        etimer_stop(&uart->rx_timer);
+        uart->rx_buf = NULL;
+    } else if (etimer_expired(&uart->rx_timer)) {
+        err = PBIO_ERROR_TIMEDOUT;
+        uart->rx_buf = NULL;
+    }
+
+    return err;
+}
+
+void pbdrv_uart_read_cancel(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    uart->rx_result = PBIO_ERROR_CANCELED;
+}
+
+pbio_error_t pbdrv_uart_write_begin(pbdrv_uart_dev_t *uart_dev, uint8_t *msg, uint8_t length, uint32_t timeout) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    if (!msg || !length) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (uart->tx_buf) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    // The simulated device receives the whole message at once
+    uart->tx_buf = msg;
+    uart->tx_result = PBIO_SUCCESS;
+    _pbdrv_virtual_lump_receive(uart - pbdrv_uart, uart->baud, msg, length);
+
+    process_poll(&pbdrv_uart_process);
+
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_uart_write_end(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    if (uart->tx_buf == NULL) {
+        // begin was not called first
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    uart->tx_buf = NULL;
+
+    return uart->tx_result;
+}
+
+void pbdrv_uart_write_cancel(pbdrv_uart_dev_t *uart_dev) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    uart->tx_result = PBIO_ERROR_CANCELED;
+}
+
+pbio_error_t pbdrv_uart_set_baud_rate(pbdrv_uart_dev_t *uart_dev, uint32_t baud) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    if (uart->tx_buf || uart->rx_buf) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    uart->baud = baud;
+
+    return PBIO_SUCCESS;
+}
+
+static void handle_poll() {
+    bool done = false;
+
+    for (int i = 0; i < PBDRV_CONFIG_UART_VIRTUAL_NUM_UART; i++) {
+        pbdrv_uart_t *uart = &pbdrv_uart[i];
+
+        // if receive is pending and we have not received all bytes yet...
+        if (uart->rx_buf && uart->rx_result == PBIO_ERROR_AGAIN) {
+            // copy all available bytes to rx_buf
+            while (uart->rx_ring_buf_head != uart->rx_ring_buf_tail) {
+                uart->rx_buf[uart->rx_buf_index++] = uart->rx_ring_buf[uart->rx_ring_buf_tail];
+                uart->rx_ring_buf_tail = (uart->rx_ring_buf_tail + 1) & (UART_RING_BUF_SIZE - 1);
+                if (uart->rx_buf_index == uart->rx_buf_size) {
+                    uart->rx_result = PBIO_SUCCESS;
+                    done = true;
+                    break;
+                }
+            }
+        }
+
+        if (uart->tx_buf) {
+            done = true;
+        }
+    }
+
+    // notify waiting processes, like the interrupt driven drivers do
+    if (done) {
+        process_post(PROCESS_BROADCAST, PROCESS_EVENT_COM, NULL);
+    }
+}
+
+PROCESS_THREAD(pbdrv_uart_process, ev, data) {
+    PROCESS_POLLHANDLER(handle_poll());
+
+    PROCESS_BEGIN();
+
+    for (int i = 0; i < PBDRV_CONFIG_UART_VIRTUAL_NUM_UART; i++) {
+        pbdrv_uart[i].initalized = true;
+    }
+
+    while (true) {
+        PROCESS_WAIT_EVENT();
+    }
+
+    PROCESS_END();
+}
+
+#endif // PBDRV_CONFIG_UART_VIRTUAL
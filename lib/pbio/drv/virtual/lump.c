@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Simulated sensors that speak the LEGO UART Messaging Protocol (LUMP).
+//
+// Like real sensors, they send their mode information at 2400 baud until the
+// hub acknowledges it, or at once at 115200 baud if the hub asks for it with
+// a SPEED command. After that they send data for the selected mode at a fixed
+// rate and go back to the start if the hub stops sending keep alive messages.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_VIRTUAL
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <lego_uart.h>
+
+#include <pbio/iodev.h>
+#include <pbio/util.h>
+
+#include "virtual.h"
+
+#define SPEED_SYNC      (2400)
+#define SPEED_DATA      (115200)
+
+// Time between repeats of the mode information until the hub replies
+#define SYNC_REPEAT     (250000)
+
+// Time without keep alive message after which the sensor starts over
+#define KEEP_ALIVE_TIMEOUT (600000)
+
+static const pbdrv_virtual_lump_mode_t ev3_ultrasonic_modes[] = {
+    { .name = "US-DIST-CM", .units = "cm", .raw_max = 2550, .si_max = 255,
+      .num_values = 1, .data_type = PBIO_IODEV_DATA_TYPE_INT16, .digits = 5, .decimals = 1 },
+    { .name = "US-DIST-IN", .units = "inch", .raw_max = 1000, .si_max = 100,
+      .num_values = 1, .data_type = PBIO_IODEV_DATA_TYPE_INT16, .digits = 5, .decimals = 1 },
+    { .name = "US-LISTEN", .units = "", .raw_max = 1, .si_max = 1,
+      .num_values = 1, .data_type = PBIO_IODEV_DATA_TYPE_INT8, .digits = 1, .decimals = 0 },
+};
+
+// LEGO MINDSTORMS EV3 Ultrasonic Sensor, without the single shot modes
+const pbdrv_virtual_lump_device_t pbdrv_virtual_lump_ev3_ultrasonic = {
+    .type_id = PBIO_IODEV_TYPE_ID_EV3_ULTRASONIC_SENSOR,
+    .num_modes = PBIO_ARRAY_SIZE(ev3_ultrasonic_modes),
+    .modes = ev3_ultrasonic_modes,
+    .data_period = 10000,
+};
+
+typedef enum {
+    STATE_DISCONNECTED,
+    STATE_SYNC,
+    STATE_DATA,
+} lump_state_t;
+
+typedef struct {
+    const pbdrv_virtual_lump_device_t *device;
+    lump_state_t state;
+    uint32_t speed;
+    uint8_t mode;
+    uint32_t next_time;
+    uint32_t keep_alive_time;
+    uint8_t data[LUMP_MAX_MODE + 1][LUMP_MAX_MSG_SIZE];
+    uint8_t rx_msg[LUMP_MAX_MSG_SIZE + 3];
+    uint8_t rx_size;
+} lump_t;
+
+static lump_t sensors[PBDRV_CONFIG_UART_VIRTUAL_NUM_UART];
+
+static void send(uint8_t uart_id, uint32_t speed, uint8_t header, int info, const void *payload, uint8_t len) {
+    uint8_t msg[LUMP_MAX_MSG_SIZE + 3];
+    uint8_t size = 0;
+    uint8_t padded;
+
+    // Payloads are padded to the next power of two
+    for (padded = 1; padded < len; padded <<= 1) {
+        header += 1 << 3;
+    }
+
+    msg[size++] = header;
+    if (info >= 0) {
+        msg[size++] = info;
+    }
+    memset(&msg[size], 0, padded);
+    memcpy(&msg[size], payload, len);
+    size += padded;
+
+    uint8_t checksum = 0xFF;
+    for (int i = 0; i < size; i++) {
+        checksum ^= msg[i];
+    }
+    msg[size++] = checksum;
+
+    _pbdrv_virtual_uart_send(uart_id, speed, msg, size);
+}
+
+static void send_sys(uint8_t uart_id, uint32_t speed, uint8_t cmd) {
+    _pbdrv_virtual_uart_send(uart_id, speed, &cmd, 1);
+}
+
+static void send_info_float(uint8_t uart_id, uint32_t speed, uint8_t mode, uint8_t info, float min, float max) {
+    float range[2] = { min, max };
+    send(uart_id, speed, LUMP_MSG_TYPE_INFO | mode, info, range, sizeof(range));
+}
+
+static void send_mode_info(uint8_t uart_id) {
+    lump_t *s = &sensors[uart_id];
+    const pbdrv_virtual_lump_device_t *dev = s->device;
+    uint8_t payload[4];
+    uint32_t speed = SPEED_DATA;
+
+    payload[0] = dev->type_id;
+    send(uart_id, s->speed, LUMP_MSG_TYPE_CMD | LUMP_CMD_TYPE, -1, payload, 1);
+    payload[0] = dev->num_modes - 1;
+    send(uart_id, s->speed, LUMP_MSG_TYPE_CMD | LUMP_CMD_MODES, -1, payload, 1);
+    send(uart_id, s->speed, LUMP_MSG_TYPE_CMD | LUMP_CMD_SPEED, -1, &speed, sizeof(speed));
+
+    // Modes are described starting from the highest one
+    for (int mode = dev->num_modes - 1; mode >= 0; mode--) {
+        const pbdrv_virtual_lump_mode_t *m = &dev->modes[mode];
+
+        send(uart_id, s->speed, LUMP_MSG_TYPE_INFO | mode, LUMP_INFO_NAME, m->name, strlen(m->name));
+        send_info_float(uart_id, s->speed, mode, LUMP_INFO_RAW, 0, m->raw_max);
+        send_info_float(uart_id, s->speed, mode, LUMP_INFO_PCT, 0, 100);
+        send_info_float(uart_id, s->speed, mode, LUMP_INFO_SI, 0, m->si_max);
+        if (m->units[0]) {
+            send(uart_id, s->speed, LUMP_MSG_TYPE_INFO | mode, LUMP_INFO_UNITS, m->units, strlen(m->units));
+        }
+        payload[0] = m->num_values;
+        payload[1] = m->data_type;
+        payload[2] = m->digits;
+        payload[3] = m->decimals;
+        send(uart_id, s->speed, LUMP_MSG_TYPE_INFO | mode, LUMP_INFO_FORMAT, payload, 4);
+    }
+
+    send_sys(uart_id, s->speed, LUMP_SYS_ACK);
+}
+
+static void send_data(uint8_t uart_id) {
+    lump_t *s = &sensors[uart_id];
+    const pbdrv_virtual_lump_mode_t *m = &s->device->modes[s->mode];
+
+    send(uart_id, s->speed, LUMP_MSG_TYPE_DATA | s->mode, -1, s->data[s->mode],
+        m->num_values * pbio_iodev_size_of(m->data_type));
+}
+
+static void start_sync(uint8_t uart_id, uint32_t now) {
+    lump_t *s = &sensors[uart_id];
+
+    s->state = STATE_SYNC;
+    s->speed = SPEED_SYNC;
+    s->mode = 0;
+    s->next_time = now;
+}
+
+void _pbdrv_virtual_lump_reset(void) {
+    memset(sensors, 0, sizeof(sensors));
+}
+
+void _pbdrv_virtual_lump_step(uint32_t now) {
+    for (int i = 0; i < PBDRV_CONFIG_UART_VIRTUAL_NUM_UART; i++) {
+        lump_t *s = &sensors[i];
+
+        switch (s->state) {
+            case STATE_DISCONNECTED:
+                break;
+            case STATE_SYNC:
+                if ((int32_t)(now - s->next_time) >= 0) {
+                    send_mode_info(i);
+                    s->next_time = now + SYNC_REPEAT;
+                }
+                break;
+            case STATE_DATA:
+                if ((int32_t)(now - s->keep_alive_time) > KEEP_ALIVE_TIMEOUT) {
+                    start_sync(i, now);
+                    break;
+                }
+                if ((int32_t)(now - s->next_time) >= 0) {
+                    send_data(i);
+                    s->next_time += s->device->data_period;
+                }
+                break;
+        }
+    }
+}
+
+static void handle_msg(uint8_t uart_id, uint32_t speed) {
+    lump_t *s = &sensors[uart_id];
+    uint32_t now = pbdrv_virtual_get_time();
+    uint8_t header = s->rx_msg[0];
+
+    // Devices listen for a speed change at the fast rate, so the hub can
+    // skip the slow synchronization
+    if (header == (LUMP_MSG_TYPE_CMD | LUMP_MSG_SIZE_4 | LUMP_CMD_SPEED)) {
+        if (speed == SPEED_DATA) {
+            s->state = STATE_SYNC;
+            s->speed = SPEED_DATA;
+            s->mode = 0;
+            send_sys(uart_id, s->speed, LUMP_SYS_ACK);
+            send_mode_info(uart_id);
+            s->next_time = now + SYNC_REPEAT;
+        }
+        return;
+    }
+
+    // Anything else must be sent at the current speed
+    if (speed != s->speed) {
+        return;
+    }
+
+    switch (header) {
+        case LUMP_SYS_ACK:
+            if (s->state == STATE_SYNC) {
+                s->state = STATE_DATA;
+                s->speed = SPEED_DATA;
+                s->keep_alive_time = now;
+                // The hub changes the speed 10 ms after its ACK
+                s->next_time = now + 10000 + s->device->data_period;
+            }
+            break;
+        case LUMP_SYS_NACK:
+            s->keep_alive_time = now;
+            break;
+        case LUMP_MSG_TYPE_CMD | LUMP_MSG_SIZE_1 | LUMP_CMD_SELECT:
+            if (s->state == STATE_DATA && s->rx_msg[1] < s->device->num_modes) {
+                s->mode = s->rx_msg[1];
+                send_data(uart_id);
+            }
+            break;
+        default:
+            // Writing to the sensor is not simulated
+            break;
+    }
+}
+
+/**
+ * Receives bytes sent by the hub on a sensor port.
+ * @param [in]  uart_id     The UART
+ * @param [in]  speed       Baud rate used by the hub
+ * @param [in]  data        The bytes
+ * @param [in]  size        Number of bytes
+ */
+void _pbdrv_virtual_lump_receive(uint8_t uart_id, uint32_t speed, const uint8_t *data, uint8_t size) {
+    lump_t *s = &sensors[uart_id];
+
+    if (s->state == STATE_DISCONNECTED) {
+        return;
+    }
+
+    for (int i = 0; i < size; i++) {
+        s->rx_msg[s->rx_size++] = data[i];
+
+        uint8_t header = s->rx_msg[0];
+        uint8_t msg_size = 1;
+        if ((header & LUMP_MSG_TYPE_MASK) != LUMP_MSG_TYPE_SYS) {
+            msg_size = LUMP_MSG_SIZE(header) + 2;
+        }
+
+        if (s->rx_size == msg_size) {
+            handle_msg(uart_id, speed);
+            s->rx_size = 0;
+        }
+    }
+}
+
+/**
+ * Plugs a simulated sensor into a port. It starts talking to the hub right
+ * away.
+ * @param [in]  port        The sensor port
+ * @param [in]  device      The sensor
+ * @return                  ::PBIO_SUCCESS or ::PBIO_ERROR_INVALID_PORT
+ */
+pbio_error_t pbdrv_virtual_lump_connect(pbio_port_t port, const pbdrv_virtual_lump_device_t *device) {
+    if (port < PBIO_PORT_1 || port >= PBIO_PORT_1 + PBDRV_CONFIG_UART_VIRTUAL_NUM_UART) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+
+    uint8_t uart_id = port - PBIO_PORT_1;
+    lump_t *s = &sensors[uart_id];
+
+    memset(s->data, 0, sizeof(s->data));
+    s->device = device;
+    start_sync(uart_id, pbdrv_virtual_get_time());
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Sets the values that a simulated sensor sends in a mode.
+ * @param [in]  port        The sensor port
+ * @param [in]  mode        The mode
+ * @param [in]  data        The values in the format of the mode
+ * @return                  ::PBIO_SUCCESS, ::PBIO_ERROR_INVALID_PORT or
+ *                          ::PBIO_ERROR_INVALID_ARG if the mode does not exist
+ */
+pbio_error_t pbdrv_virtual_lump_set_data(pbio_port_t port, uint8_t mode, const void *data) {
+    if (port < PBIO_PORT_1 || port >= PBIO_PORT_1 + PBDRV_CONFIG_UART_VIRTUAL_NUM_UART) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+
+    lump_t *s = &sensors[port - PBIO_PORT_1];
+    if (!s->device || mode >= s->device->num_modes) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    const pbdrv_virtual_lump_mode_t *m = &s->device->modes[mode];
+    memcpy(s->data[mode], data, m->num_values * pbio_iodev_size_of(m->data_type));
+
+    return PBIO_SUCCESS;
+}
+
+#endif // PBDRV_CONFIG_VIRTUAL
@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Simulated motors: an H-bridge driving a DC motor with back EMF, inertia,
+// Coulomb and viscous friction and an optional external load.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_VIRTUAL
+
+#include <math.h>
+#include <stdbool.h>
+
+#include <pbdrv/motor.h>
+#include <pbio/config.h>
+
+#include "virtual.h"
+
+// Roughly a LEGO MINDSTORMS EV3 Large Motor
+const pbdrv_virtual_motor_params_t pbdrv_virtual_motor_ev3_large = {
+    .resistance = 6.8f,
+    .back_emf = 0.47f,
+    .inertia = 0.002f,
+    .friction = 0.02f,
+    .damping = 0.0005f,
+};
+
+typedef struct {
+    pbdrv_virtual_motor_params_t params;
+    float load_inertia;
+    float load_torque;
+    float angle;
+    float speed;
+    float current;
+    int16_t duty_cycle;
+    bool coast;
+} motor_t;
+
+static motor_t motors[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+static motor_t *get_motor(pbio_port_t port) {
+    if (port < PBDRV_CONFIG_FIRST_MOTOR_PORT || port > PBDRV_CONFIG_LAST_MOTOR_PORT) {
+        return NULL;
+    }
+    return &motors[port - PBDRV_CONFIG_FIRST_MOTOR_PORT];
+}
+
+void _pbdrv_virtual_motor_reset(void) {
+    for (int i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        motors[i] = (motor_t) {
+            .params = pbdrv_virtual_motor_ev3_large,
+            .coast = true,
+        };
+    }
+}
+
+static void motor_step(motor_t *m, float dt, float voltage) {
+    const pbdrv_virtual_motor_params_t *p = &m->params;
+
+    // An open H-bridge carries no current. Otherwise the PWM average of the
+    // supply voltage is applied.
+    if (m->coast) {
+        m->current = 0;
+    } else {
+        m->current = (voltage * m->duty_cycle / PBDRV_MAX_DUTY - p->back_emf * m->speed) / p->resistance;
+    }
+
+    float torque = p->back_emf * m->current - p->damping * m->speed - m->load_torque;
+    float inertia = p->inertia + m->load_inertia;
+
+    // Static friction holds the motor until the torque overcomes it
+    if (m->speed == 0) {
+        if (fabsf(torque) <= p->friction) {
+            return;
+        }
+        torque -= copysignf(p->friction, torque);
+    } else {
+        torque -= copysignf(p->friction, m->speed);
+    }
+
+    float speed = m->speed + torque / inertia * dt;
+
+    // Stop when crossing zero speed, so the static friction check above
+    // decides whether the motor starts turning the other way
+    if (speed * m->speed < 0) {
+        speed = 0;
+    }
+
+    m->angle += (m->speed + speed) / 2 * dt;
+    m->speed = speed;
+}
+
+void _pbdrv_virtual_motor_step(float dt, float voltage) {
+    for (int i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        motor_step(&motors[i], dt, voltage);
+    }
+}
+
+float _pbdrv_virtual_motor_get_battery_current(void) {
+    float current = 0;
+    for (int i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        // The battery only supplies current while the PWM output is on
+        current += fabsf(motors[i].current * motors[i].duty_cycle / PBDRV_MAX_DUTY);
+    }
+    return current;
+}
+
+/**
+ * Sets the electrical and mechanical properties of a motor.
+ * @param [in]  port        The motor port
+ * @param [in]  params      The properties
+ * @return                  ::PBIO_SUCCESS or ::PBIO_ERROR_INVALID_PORT
+ */
+pbio_error_t pbdrv_virtual_motor_set_params(pbio_port_t port, const pbdrv_virtual_motor_params_t *params) {
+    motor_t *m = get_motor(port);
+    if (!m) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+    m->params = *params;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Attaches a load to the output shaft of a motor.
+ * @param [in]  port        The motor port
+ * @param [in]  inertia     Added moment of inertia in kg m^2
+ * @param [in]  torque      Constant torque against positive rotation in Nm
+ * @return                  ::PBIO_SUCCESS or ::PBIO_ERROR_INVALID_PORT
+ */
+pbio_error_t pbdrv_virtual_motor_set_load(pbio_port_t port, float inertia, float torque) {
+    motor_t *m = get_motor(port);
+    if (!m) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+    m->load_inertia = inertia;
+    m->load_torque = torque;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Gets the exact state of a motor, without encoder quantization.
+ * @param [in]  port        The motor port
+ * @param [out] angle       Angle in degrees
+ * @param [out] speed       Speed in degrees per second
+ * @param [out] current     Current in A
+ * @return                  ::PBIO_SUCCESS or ::PBIO_ERROR_INVALID_PORT
+ */
+pbio_error_t pbdrv_virtual_motor_get_state(pbio_port_t port, float *angle, float *speed, float *current) {
+    motor_t *m = get_motor(port);
+    if (!m) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+    *angle = m->angle * (180 / (float)M_PI);
+    *speed = m->speed * (180 / (float)M_PI);
+    *current = m->current;
+    return PBIO_SUCCESS;
+}
+
+void _pbdrv_motor_init(void) {
+}
+
+#if PBIO_CONFIG_ENABLE_DEINIT
+void _pbdrv_motor_deinit(void) {
+    for (int i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        motors[i].coast = true;
+    }
+}
+#endif
+
+pbio_error_t pbdrv_motor_coast(pbio_port_t port) {
+    motor_t *m = get_motor(port);
+    if (!m) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+    m->coast = true;
+    m->duty_cycle = 0;
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_motor_set_duty_cycle(pbio_port_t port, int16_t duty_cycle) {
+    motor_t *m = get_motor(port);
+    if (!m) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+    if (duty_cycle > PBDRV_MAX_DUTY || duty_cycle < -PBDRV_MAX_DUTY) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    m->coast = false;
+    m->duty_cycle = duty_cycle;
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_motor_get_id(pbio_port_t port, pbio_iodev_type_id_t *id) {
+    if (!get_motor(port)) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+    *id = PBIO_IODEV_TYPE_ID_EV3_LARGE_MOTOR;
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbdrv_motor_setup(pbio_port_t port, bool is_servo) {
+    if (!get_motor(port)) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+    return PBIO_SUCCESS;
+}
+
+#endif // PBDRV_CONFIG_VIRTUAL
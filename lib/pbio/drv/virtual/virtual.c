@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Virtual clock and stepping of the simulation models.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_VIRTUAL
+
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include "virtual.h"
+
+#include "../../src/processes.h"
+
+// Time step of the motor and battery models in us
+#define MODEL_STEP (50)
+
+static uint32_t now;
+
+/**
+ * Sets the virtual clock to zero and puts all models in their initial state.
+ * Must be called before pbio_init().
+ */
+void pbdrv_virtual_reset(void) {
+    now = 0;
+    _pbdrv_virtual_motor_reset();
+    _pbdrv_virtual_battery_reset();
+    _pbdrv_virtual_uart_reset();
+    _pbdrv_virtual_lump_reset();
+}
+
+/**
+ * Advances the virtual clock. Processes that are waiting for timers or data
+ * run on the next calls to pbio_do_one_event().
+ * @param [in]  duration    Time to advance in us
+ */
+void pbdrv_virtual_step(uint32_t duration) {
+    uint32_t end = now + duration;
+
+    while (now != end) {
+        uint32_t dt = end - now < MODEL_STEP ? end - now : MODEL_STEP;
+        float voltage = _pbdrv_virtual_battery_step();
+        _pbdrv_virtual_motor_step(dt * 1e-6f, voltage);
+        now += dt;
+        _pbdrv_virtual_lump_step(now);
+    }
+
+    etimer_request_poll();
+}
+
+/**
+ * Gets the virtual time.
+ * @return                  Time since pbdrv_virtual_reset() in us
+ */
+uint32_t pbdrv_virtual_get_time(void) {
+    return now;
+}
+
+#endif // PBDRV_CONFIG_VIRTUAL
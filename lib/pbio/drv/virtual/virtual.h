@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Control interface of the virtual hub.
+//
+// Nothing happens on the virtual hub until the application advances the
+// virtual clock with pbdrv_virtual_step(). Each step integrates the motor,
+// battery and sensor models, and wakes up the pbio processes that are due, so
+// that programs run as fast as the host can compute them.
+
+#ifndef _PBDRV_VIRTUAL_VIRTUAL_H_
+#define _PBDRV_VIRTUAL_VIRTUAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+#include <pbio/iodev.h>
+#include <pbio/port.h>
+
+/**
+ * Parameters of a DC motor with a gear train, as seen from the output shaft.
+ */
+typedef struct _pbdrv_virtual_motor_params_t {
+    float resistance;       /**< Winding resistance in ohm */
+    float back_emf;         /**< Back EMF in V/(rad/s), also the torque constant in Nm/A */
+    float inertia;          /**< Moment of inertia in kg m^2 */
+    float friction;         /**< Coulomb friction torque in Nm */
+    float damping;          /**< Viscous friction in Nm/(rad/s) */
+} pbdrv_virtual_motor_params_t;
+
+/**
+ * One mode of a simulated LEGO UART sensor.
+ */
+typedef struct _pbdrv_virtual_lump_mode_t {
+    const char *name;                   /**< Mode name, at most 11 characters */
+    const char *units;                  /**< Units, at most 4 characters */
+    float raw_max;                      /**< Raw value at 100% */
+    float si_max;                       /**< SI value at 100% */
+    uint8_t num_values;                 /**< Number of values in a data message */
+    pbio_iodev_data_type_t data_type;   /**< Type of each value */
+    uint8_t digits;                     /**< Number of digits to show */
+    uint8_t decimals;                   /**< Number of decimals to show */
+} pbdrv_virtual_lump_mode_t;
+
+/**
+ * A simulated LEGO UART sensor.
+ */
+typedef struct _pbdrv_virtual_lump_device_t {
+    pbio_iodev_type_id_t type_id;           /**< Device type */
+    uint8_t num_modes;                      /**< Number of modes, at most 8 */
+    const pbdrv_virtual_lump_mode_t *modes; /**< Mode descriptions */
+    uint32_t data_period;                   /**< Time between data messages in us */
+} pbdrv_virtual_lump_device_t;
+
+extern const pbdrv_virtual_motor_params_t pbdrv_virtual_motor_ev3_large;
+extern const pbdrv_virtual_lump_device_t pbdrv_virtual_lump_ev3_ultrasonic;
+
+// Simulation
+void pbdrv_virtual_reset(void);
+void pbdrv_virtual_step(uint32_t duration);
+uint32_t pbdrv_virtual_get_time(void);
+
+// Motors
+pbio_error_t pbdrv_virtual_motor_set_params(pbio_port_t port, const pbdrv_virtual_motor_params_t *params);
+pbio_error_t pbdrv_virtual_motor_set_load(pbio_port_t port, float inertia, float torque);
+pbio_error_t pbdrv_virtual_motor_get_state(pbio_port_t port, float *angle, float *speed, float *current);
+
+// Battery
+void pbdrv_virtual_battery_set(uint16_t voltage_mv, uint16_t resistance_mohm);
+
+// Sensors
+pbio_error_t pbdrv_virtual_lump_connect(pbio_port_t port, const pbdrv_virtual_lump_device_t *device);
+pbio_error_t pbdrv_virtual_lump_set_data(pbio_port_t port, uint8_t mode, const void *data);
+
+// Used between the virtual drivers
+void _pbdrv_virtual_motor_reset(void);
+void _pbdrv_virtual_motor_step(float dt, float voltage);
+float _pbdrv_virtual_motor_get_battery_current(void);
+void _pbdrv_virtual_battery_reset(void);
+float _pbdrv_virtual_battery_step(void);
+void _pbdrv_virtual_lump_reset(void);
+void _pbdrv_virtual_lump_step(uint32_t now);
+void _pbdrv_virtual_lump_receive(uint8_t uart_id, uint32_t speed, const uint8_t *data, uint8_t size);
+void _pbdrv_virtual_uart_reset(void);
+void _pbdrv_virtual_uart_send(uint8_t uart_id, uint32_t speed, const uint8_t *data, uint8_t size);
+
+#endif // _PBDRV_VIRTUAL_VIRTUAL_H_
@@ -27,9 +27,27 @@
  */
 pbio_error_t pbdrv_bluetooth_tx(uint8_t c);
 
+/**
+ * Queues data to be transmitted via Bluetooth serial port. Data from
+ * consecutive calls is combined into notifications as large as the MTU of the
+ * connection allows.
+ * @param data [in]     the data to be sent.
+ * @param size [in,out] the number of bytes in *data*. On success, this is
+ *                      set to the number of bytes that were queued, which may
+ *                      be less than requested if the buffer is almost full.
+ * @return              ::PBIO_SUCCESS if at least one byte was queued,
+ *                      ::PBIO_ERROR_AGAIN if nothing could be queued at this
+ *                      time (e.g. buffer is full), ::PBIO_ERROR_INVALID_OP if
+ *                      there is not an active Bluetooth connection or
+ *                      ::PBIO_ERROR_NOT_SUPPORTED if this platform does not
+ *                      support Bluetooth.
+ */
+pbio_error_t pbdrv_bluetooth_tx_buf(const uint8_t *data, uint32_t *size);
+
 #else // PBDRV_CONFIG_BLUETOOTH
 
 static inline pbio_error_t pbdrv_bluetooth_tx(uint8_t c) { return PBIO_ERROR_NOT_SUPPORTED; }
+static inline pbio_error_t pbdrv_bluetooth_tx_buf(const uint8_t *data, uint32_t *size) { return PBIO_ERROR_NOT_SUPPORTED; }
 
 #endif // PBDRV_CONFIG_BLUETOOTH
 
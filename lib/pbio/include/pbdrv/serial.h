@@ -17,4 +17,6 @@ pbio_error_t pbdrv_serial_in_waiting(pbdrv_serial_t *ser, size_t *waiting);
 
 pbio_error_t pbdrv_serial_read(pbdrv_serial_t *ser, uint8_t *buf, size_t count, size_t *received);
 
+pbio_error_t pbdrv_serial_wait(pbdrv_serial_t *ser, int timeout);
+
 pbio_error_t pbdrv_serial_clear(pbdrv_serial_t *ser);
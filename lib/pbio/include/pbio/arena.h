@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_ARENA_H_
+#define _PBIO_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <pbio/config.h>
+
+/**
+ * Memory for buffers owned by pbio, such as logs.
+ *
+ * On bricks with PBIO_CONFIG_ARENA_KB set, buffers come from a fixed region
+ * that is separate from the MicroPython heap, so they neither fragment it nor
+ * get scanned by the garbage collector. Otherwise they come from malloc().
+ */
+
+typedef struct _pbio_arena_stats_t {
+    uint32_t size;          /**< Total number of bytes available */
+    uint32_t used;          /**< Bytes allocated now, including overhead */
+    uint32_t peak;          /**< Highest value of used so far */
+    uint32_t largest_free;  /**< Largest block that can be allocated now */
+    uint32_t num_free;      /**< Number of free blocks */
+} pbio_arena_stats_t;
+
+#if PBIO_CONFIG_ARENA_KB
+
+void *pbio_arena_alloc(size_t size);
+void pbio_arena_free(void *ptr);
+void pbio_arena_get_stats(pbio_arena_stats_t *stats);
+void _pbio_arena_reset(void);
+
+#else // PBIO_CONFIG_ARENA_KB
+
+static inline void *pbio_arena_alloc(size_t size) { return malloc(size); }
+static inline void pbio_arena_free(void *ptr) { free(ptr); }
+static inline void pbio_arena_get_stats(pbio_arena_stats_t *stats) {
+    *stats = (pbio_arena_stats_t) { 0 };
+}
+static inline void _pbio_arena_reset(void) { }
+
+#endif // PBIO_CONFIG_ARENA_KB
+
+#endif // _PBIO_ARENA_H_
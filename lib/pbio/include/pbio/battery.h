@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_BATTERY_H_
+#define _PBIO_BATTERY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <pbio/config.h>
+
+/**
+ * Battery voltage compensation of motor duty cycles.
+ *
+ * Control gains are tuned at PBIO_CONFIG_BATTERY_NOMINAL_MV. When enabled
+ * with pbio_battery_set_compensation(),
+ * duty cycles are scaled by the ratio of the nominal voltage to a filtered
+ * battery voltage, so that a motor gets the same average voltage whether the
+ * battery is full or nearly empty.
+ */
+
+#if PBIO_CONFIG_BATTERY_COMPENSATION
+
+void pbio_battery_set_compensation(bool enable);
+uint16_t pbio_battery_get_average_voltage(void);
+int32_t pbio_battery_compensate_duty(int32_t duty);
+
+void _pbio_battery_reset(void);
+void _pbio_battery_update(uint16_t voltage);
+void _pbio_battery_poll(clock_time_t now);
+
+#else // PBIO_CONFIG_BATTERY_COMPENSATION
+
+static inline void pbio_battery_set_compensation(bool enable) { }
+static inline uint16_t pbio_battery_get_average_voltage(void) { return 0; }
+static inline int32_t pbio_battery_compensate_duty(int32_t duty) { return duty; }
+
+static inline void _pbio_battery_reset(void) { }
+static inline void _pbio_battery_poll(clock_time_t now) { }
+
+#endif // PBIO_CONFIG_BATTERY_COMPENSATION
+
+#endif // _PBIO_BATTERY_H_
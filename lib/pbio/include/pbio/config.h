@@ -15,13 +15,44 @@
 #define PBIO_CONFIG_ENABLE_DEINIT (1)
 #endif
 
+// size of the memory region for pbio buffers such as logs, or 0 to use malloc().
+// This sets how long a log can be, see pbio/logger.h.
+#ifndef PBIO_CONFIG_ARENA_KB
+#define PBIO_CONFIG_ARENA_KB (0)
+#endif
+
 // polling interval for updating servo controller
 #ifndef PBIO_CONFIG_SERVO_PERIOD_MS
 #define PBIO_CONFIG_SERVO_PERIOD_MS (6)
 #endif
 
+// timing statistics of the control loop and process handling, for debugging
+#ifndef PBIO_CONFIG_LOOPSTATS
+#define PBIO_CONFIG_LOOPSTATS (0)
+#endif
+
+// number of events in the scheduler trace buffer, if PROCESS_CONF_TRACE is enabled
+#ifndef PBIO_CONFIG_TRACE_NUM_EVENTS
+#define PBIO_CONFIG_TRACE_NUM_EVENTS (256)
+#endif
+
+// scaling of motor duty cycles with the battery voltage
+#ifndef PBIO_CONFIG_BATTERY_COMPENSATION
+#define PBIO_CONFIG_BATTERY_COMPENSATION (0)
+#endif
+
+// battery voltage in mV at which the control gains were tuned
+#ifndef PBIO_CONFIG_BATTERY_NOMINAL_MV
+#define PBIO_CONFIG_BATTERY_NOMINAL_MV (7200)
+#endif
+
 #ifndef PBIO_CONFIG_UARTDEV
 #define PBIO_CONFIG_UARTDEV (0)
 #endif
 
+// recording of control loop inputs for replay on a PC
+#ifndef PBIO_CONFIG_RECORD
+#define PBIO_CONFIG_RECORD (0)
+#endif
+
 #endif // _PBIO_CONFIG_H_
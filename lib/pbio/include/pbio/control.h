@@ -13,6 +13,7 @@
 #include <pbio/port.h>
 #include <pbio/trajectory.h>
 #include <pbio/integrator.h>
+#include <pbio/math.h>
 
 #include <pbio/iodev.h>
 
@@ -20,7 +21,7 @@
  * Control settings
  */
 typedef struct _pbio_control_settings_t {
-    fix16_t counts_per_unit;        /**< Conversion between user units (degree, mm, etc) and integer counts used internally by controller */
+    pbio_math_scale_t counts_per_unit; /**< Conversion between user units (degree, mm, etc) and integer counts used internally by controller */
     int32_t stall_rate_limit;       /**< If this speed cannnot be reached even with the maximum duty value (equal to stall_torque_limit), the motor is considered to be stalled */
     int32_t stall_time;             /**< Minimum stall time before the run_stalled action completes */
     int32_t max_rate;               /**< Soft limit on the reference encoder rate in all run commands */
@@ -65,6 +66,22 @@ typedef enum {
     PBIO_CONTROL_ANGLE,  /**< Run to an angle */
 } pbio_control_type_t;
 
+/**
+ * Intermediate results of the most recent control update, kept for logging
+ */
+typedef struct _pbio_control_state_t {
+    int32_t time_ref;               /**< Time at which the reference was evaluated */
+    int32_t count_ref;              /**< Reference count */
+    int32_t rate_ref;               /**< Reference rate */
+    int32_t err;                    /**< Count error for angle control, rate error for timed control */
+    int32_t err_integral;           /**< Integral of the error above */
+    int32_t duty_proportional;      /**< Proportional part of the duty */
+    int32_t duty_integral;          /**< Integral part of the duty */
+    int32_t duty_derivative;        /**< Derivative part of the duty */
+    int32_t duty_feedforward;       /**< Feedforward part of the duty */
+    bool windup;                    /**< Whether integration was paused because the duty limit was reached */
+} pbio_control_state_t;
+
 typedef struct _pbio_control_t {
     pbio_control_type_t type;
     pbio_control_settings_t settings;
@@ -75,6 +92,7 @@ typedef struct _pbio_control_t {
     pbio_control_on_target_t on_target_func;
     bool stalled;
     bool on_target;
+    pbio_control_state_t state;
 } pbio_control_t;
 
 // Convert control units (counts, rate) and physical user units (deg or mm, deg/s or mm/s)
@@ -98,13 +116,16 @@ int32_t pbio_control_get_ref_time(pbio_control_t *ctl, int32_t time_now);
 
 void pbio_control_stop(pbio_control_t *ctl);
 pbio_error_t pbio_control_start_angle_control(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t target_count, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_actuation_t after_stop);
+pbio_error_t pbio_control_start_synchronized_angle_control(pbio_control_t *ctl, const pbio_trajectory_t *master, int32_t count_start, int32_t count_start_ext, int32_t target_count, pbio_actuation_t after_stop);
 pbio_error_t pbio_control_start_relative_angle_control(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t relative_target_count, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_actuation_t after_stop);
 pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_now, int32_t duration, int32_t count_now, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_control_on_target_t stop_func, pbio_actuation_t after_stop);
 pbio_error_t pbio_control_start_hold_control(pbio_control_t *ctl, int32_t time_now, int32_t target_count);
+pbio_error_t pbio_control_start_follow_control(pbio_control_t *ctl, int32_t time_now, int32_t target_count, int32_t target_count_ext, int32_t target_rate);
 
 
 bool pbio_control_is_stalled(pbio_control_t *ctl);
 bool pbio_control_is_done(pbio_control_t *ctl);
+bool pbio_control_is_following(pbio_control_t *ctl);
 
 void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t rate_now, pbio_actuation_t *actuation_type, int32_t *control);
 
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_DOWNLOAD_H_
+#define _PBIO_DOWNLOAD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+
+/**
+ * Block based program download with CRC32 checks and selective retransmit.
+ *
+ * The host sends blocks of the form:
+ *
+ *     seq (2 bytes, big endian) | data | crc32 (4 bytes, big endian)
+ *
+ * where data is PBIO_DOWNLOAD_BLOCK_SIZE bytes, except for the last block,
+ * and the CRC covers seq and data. The host may send several blocks before
+ * waiting for a reply. Each valid block is acknowledged with:
+ *
+ *     PBIO_DOWNLOAD_ACK | seq (2 bytes, big endian)
+ *
+ * If a block is corrupted or incomplete, the receiver discards data until the
+ * line is idle and then replies with PBIO_DOWNLOAD_NAK and the sequence number
+ * of the first block that is still missing. The host resends that block, and
+ * any other block that was not acknowledged in time.
+ */
+
+// Value of the program length message that selects the block protocol
+#define PBIO_DOWNLOAD_MAGIC (0x50424C4B) // "PBLK"
+
+// Number of program bytes in each block
+#define PBIO_DOWNLOAD_BLOCK_SIZE (64)
+
+// Reply types
+#define PBIO_DOWNLOAD_ACK (0x06)
+#define PBIO_DOWNLOAD_NAK (0x15)
+
+// Idle time after which a partial or corrupted block is discarded
+#define PBIO_DOWNLOAD_RESYNC_MS (20)
+
+// Idle time after which the download is aborted
+#define PBIO_DOWNLOAD_TIMEOUT_MS (500)
+
+// Size of the buffer that keeps track of received blocks
+#define PBIO_DOWNLOAD_NUM_BLOCKS(len) (((len) + PBIO_DOWNLOAD_BLOCK_SIZE - 1) / PBIO_DOWNLOAD_BLOCK_SIZE)
+#define PBIO_DOWNLOAD_RECEIVED_SIZE(len) ((PBIO_DOWNLOAD_NUM_BLOCKS(len) + 7) / 8)
+
+// Functions to read or write one byte, like pbsys_stdin_get_char()
+typedef pbio_error_t (*pbio_download_get_char_t)(uint8_t *c);
+typedef pbio_error_t (*pbio_download_put_char_t)(uint8_t c);
+
+typedef struct _pbio_download_t {
+    uint8_t *buf;                                   /**< Buffer for the program */
+    uint32_t len;                                   /**< Length of the program */
+    uint8_t *received;                              /**< Bit for each block that was received */
+    uint32_t num_blocks;                            /**< Total number of blocks */
+    uint32_t num_received;                          /**< Number of blocks received so far */
+    uint8_t frame[PBIO_DOWNLOAD_BLOCK_SIZE + 6];    /**< Block currently being received */
+    uint32_t frame_len;                             /**< Number of bytes of the current block so far */
+    uint32_t frame_size;                            /**< Expected size of the current block */
+    bool discard;                                   /**< Discard data until the line is idle */
+    uint32_t time_last;                             /**< Time of the last received byte (ms) */
+    uint8_t reply[3];                               /**< Reply to be sent */
+    uint8_t reply_len;                              /**< Size of the reply to be sent */
+    uint8_t reply_sent;                             /**< Number of reply bytes sent so far */
+} pbio_download_t;
+
+void pbio_download_init(pbio_download_t *dl, uint8_t *buf, uint32_t len, uint8_t *received, uint32_t time_now);
+pbio_error_t pbio_download_poll(pbio_download_t *dl, pbio_download_get_char_t get_char, pbio_download_put_char_t put_char, uint32_t time_now);
+uint32_t pbio_download_crc32(uint32_t crc, const uint8_t *data, uint32_t len);
+
+#endif // _PBIO_DOWNLOAD_H_
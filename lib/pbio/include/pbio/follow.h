@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_FOLLOW_H_
+#define _PBIO_FOLLOW_H_
+
+#include <stdint.h>
+
+#include <fixmath.h>
+
+#define PBIO_FOLLOW_CAM_SIZE_MAX (16)
+
+struct _pbio_servo_t;
+
+/**
+ * Electronic gearing settings of a servo that follows another servo
+ */
+typedef struct _pbio_follow_t {
+    struct _pbio_servo_t *leader;           /**< Servo to follow, or NULL if not following */
+    fix16_t ratio;                          /**< Follower counts per leader count */
+    int32_t offset;                         /**< Follower count when the leader count is zero */
+    int32_t cam_period;                     /**< Leader counts per revolution of the cam profile */
+    uint8_t cam_size;                       /**< Number of points in the cam profile, or 0 if there is none */
+    int32_t cam[PBIO_FOLLOW_CAM_SIZE_MAX];  /**< Follower counts added at equally spaced leader counts */
+} pbio_follow_t;
+
+void pbio_follow_get_reference(pbio_follow_t *f, int32_t leader_count, int32_t leader_rate, int32_t *count, int32_t *count_ext, int32_t *rate);
+
+void pbio_follow_set_relative(pbio_follow_t *f, int32_t leader_count, int32_t count_now);
+
+#endif // _PBIO_FOLLOW_H_
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_I2C_H_
+#define _PBIO_I2C_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+
+/**
+ * Batched register access for I2C devices.
+ *
+ * Register reads and writes are collected in a batch and then submitted to
+ * the bus as one combined transaction, like the I2C_RDWR ioctl on Linux. A
+ * register read is a write of the register followed by a read after a
+ * repeated start:
+ *
+ *     S addr+W | reg | Sr addr+R | data ... | P
+ *
+ * Blocks of registers that never change, such as identification or
+ * calibration data, can be cached so that they are read only once.
+ */
+
+// Maximum number of messages in one transaction
+#define PBIO_I2C_MAX_MSGS (32)
+
+// Maximum number of data bytes in one read or write
+#define PBIO_I2C_MAX_DATA (32)
+
+// Size of the buffer for register numbers and written data in one transaction
+#define PBIO_I2C_BATCH_DATA_SIZE (256)
+
+// Maximum number of cached register blocks per device
+#define PBIO_I2C_CACHE_SIZE (4)
+
+// Message flag to read from the device instead of writing to it
+#define PBIO_I2C_MSG_READ (0x01)
+
+typedef struct _pbio_i2c_msg_t {
+    uint8_t address;        /**< 7-bit device address */
+    uint8_t flags;          /**< ::PBIO_I2C_MSG_READ or 0 */
+    uint16_t len;           /**< Number of bytes to read or write */
+    uint8_t *buf;           /**< Data to write or buffer to read into */
+} pbio_i2c_msg_t;
+
+/**
+ * Bus backend that performs all messages as one combined transaction.
+ */
+typedef pbio_error_t (*pbio_i2c_transfer_t)(void *context, pbio_i2c_msg_t *msgs, uint32_t num_msgs);
+
+typedef struct _pbio_i2c_cache_entry_t {
+    uint8_t reg;                        /**< First register of the block */
+    uint8_t len;                        /**< Number of registers */
+    bool valid;                         /**< Whether data was read already */
+    uint8_t data[PBIO_I2C_MAX_DATA];    /**< Register values */
+} pbio_i2c_cache_entry_t;
+
+typedef struct _pbio_i2c_dev_t {
+    pbio_i2c_transfer_t transfer;                       /**< Bus backend */
+    void *context;                                      /**< Context for the backend */
+    uint8_t address;                                    /**< 7-bit device address */
+    uint32_t num_cached;                                /**< Number of cached blocks */
+    pbio_i2c_cache_entry_t cache[PBIO_I2C_CACHE_SIZE];  /**< Cached blocks */
+} pbio_i2c_dev_t;
+
+typedef struct _pbio_i2c_batch_t {
+    pbio_i2c_dev_t *dev;                                /**< Device to talk to */
+    pbio_i2c_msg_t msgs[PBIO_I2C_MAX_MSGS];             /**< Messages so far */
+    pbio_i2c_cache_entry_t *fill[PBIO_I2C_MAX_MSGS];    /**< Cache entry to fill from each message */
+    uint32_t num_msgs;                                  /**< Number of messages so far */
+    uint8_t data[PBIO_I2C_BATCH_DATA_SIZE];             /**< Register numbers and written data */
+    uint32_t data_len;                                  /**< Used size of data */
+} pbio_i2c_batch_t;
+
+void pbio_i2c_dev_init(pbio_i2c_dev_t *dev, pbio_i2c_transfer_t transfer, void *context, uint8_t address);
+pbio_error_t pbio_i2c_dev_set_cached(pbio_i2c_dev_t *dev, uint8_t reg, uint8_t len);
+void pbio_i2c_dev_invalidate(pbio_i2c_dev_t *dev, uint8_t reg, uint8_t len);
+
+void pbio_i2c_batch_init(pbio_i2c_batch_t *batch, pbio_i2c_dev_t *dev);
+pbio_error_t pbio_i2c_batch_read(pbio_i2c_batch_t *batch, uint8_t reg, uint8_t *buf, uint8_t len);
+pbio_error_t pbio_i2c_batch_write(pbio_i2c_batch_t *batch, uint8_t reg, const uint8_t *buf, uint8_t len);
+pbio_error_t pbio_i2c_batch_submit(pbio_i2c_batch_t *batch);
+
+#endif // _PBIO_I2C_H_
@@ -21,6 +21,12 @@
 // Maximum length (index) of a log
 #define MAX_LOG_LEN ((MAX_LOG_MEM_KB*1024) / MAX_LOG_VALUES)
 
+// On bricks with a pbio arena, logs are allocated from PBIO_CONFIG_ARENA_KB,
+// which all started logs share. A servo or drive base log has 16 values, so
+// it holds just under 16 samples per KB: about 0.1 s per KB at the servo
+// period of 6 ms. Starting a log that does not fit fails with
+// PBIO_ERROR_FAILED. A larger divisor gives a longer log at a lower rate.
+
 typedef struct _pbio_log_t {
     bool active;
     uint32_t skipped;
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_LOOPSTATS_H_
+#define _PBIO_LOOPSTATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <pbio/config.h>
+
+// Number of histogram bins. Bin k counts samples of 2^k up to 2^(k+1) µs.
+// The last bin also counts all longer samples.
+#define PBIO_LOOPSTATS_NUM_BINS (16)
+
+/**
+ * Timing statistics of one part of the event loop.
+ */
+typedef struct _pbio_loopstats_t {
+    uint32_t count;                           /**< Number of samples */
+    uint32_t min;                             /**< Shortest sample (µs) */
+    uint32_t max;                             /**< Longest sample (µs) */
+    uint64_t total;                           /**< Sum of all samples (µs) */
+    uint32_t bins[PBIO_LOOPSTATS_NUM_BINS];   /**< Log2 histogram of samples */
+} pbio_loopstats_t;
+
+/**
+ * Parts of the event loop that are timed.
+ */
+typedef enum {
+    PBIO_LOOPSTATS_PERIOD,       /**< Time between the start of two control loop ticks */
+    PBIO_LOOPSTATS_SERVO,        /**< Execution time of all servo updates in one tick */
+    PBIO_LOOPSTATS_DRIVEBASE,    /**< Execution time of the drivebase update in one tick */
+    PBIO_LOOPSTATS_MOTIONGROUP,  /**< Execution time of the motion group update in one tick */
+    PBIO_LOOPSTATS_PROCESS,      /**< Execution time of one round of process handling */
+    PBIO_LOOPSTATS_NUM           /**< Number of timed parts */
+} pbio_loopstats_part_t;
+
+void pbio_loopstats_clear(pbio_loopstats_t *stats);
+void pbio_loopstats_add(pbio_loopstats_t *stats, uint32_t value);
+uint32_t pbio_loopstats_get_mean(const pbio_loopstats_t *stats);
+
+#if PBIO_CONFIG_LOOPSTATS
+
+const pbio_loopstats_t *pbio_loopstats_get(pbio_loopstats_part_t part);
+uint32_t pbio_loopstats_get_overruns(void);
+void pbio_loopstats_reset(void);
+
+void _pbio_loopstats_tick(uint32_t time_now);
+void _pbio_loopstats_record(pbio_loopstats_part_t part, uint32_t time_start, uint32_t time_end);
+
+static inline uint32_t _pbio_loopstats_now(void) { return clock_usecs(); }
+
+#else
+
+static inline const pbio_loopstats_t *pbio_loopstats_get(pbio_loopstats_part_t part) { return NULL; }
+static inline uint32_t pbio_loopstats_get_overruns(void) { return 0; }
+static inline void pbio_loopstats_reset(void) { }
+
+static inline void _pbio_loopstats_tick(uint32_t time_now) { }
+static inline void _pbio_loopstats_record(pbio_loopstats_part_t part, uint32_t time_start, uint32_t time_end) { }
+
+static inline uint32_t _pbio_loopstats_now(void) { return 0; }
+
+#endif // PBIO_CONFIG_LOOPSTATS
+
+#endif // _PBIO_LOOPSTATS_H_
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_MAILBOX_H_
+#define _PBIO_MAILBOX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+
+/**
+ * Messages for EV3 mailboxes, as sent by the standard EV3 firmware:
+ *
+ *     size (2) | count (2) | 0x81 | 0x9E | name size (1) | name | payload size (2) | payload
+ *
+ * All numbers are little endian. The size does not include the size field
+ * itself. The name is zero-terminated and its size includes the terminator.
+ */
+
+// EV3 VM bytecodes
+#define PBIO_MAILBOX_SYSTEM_COMMAND_NO_REPLY (0x81)
+#define PBIO_MAILBOX_WRITEMAILBOX (0x9E)
+
+// Size of a message without the name and payload
+#define PBIO_MAILBOX_HEADER_SIZE (9)
+
+// Largest possible message, including the size field
+#define PBIO_MAILBOX_MAX_SIZE (2 + UINT16_MAX)
+
+/**
+ * One decoded message. The pointers refer to the decoder buffer and are valid
+ * until the next call to pbio_mailbox_decoder_next().
+ */
+typedef struct _pbio_mailbox_msg_t {
+    const char *name;       /**< Mailbox name, not zero-terminated */
+    size_t name_len;        /**< Name length without trailing zeros */
+    const uint8_t *payload; /**< Message payload */
+    size_t payload_len;     /**< Payload length */
+} pbio_mailbox_msg_t;
+
+/**
+ * Splits a stream of received bytes into messages.
+ */
+typedef struct _pbio_mailbox_decoder_t {
+    uint8_t *buf;           /**< Buffer for received data */
+    size_t size;            /**< Size of the buffer */
+    size_t len;             /**< Number of bytes in the buffer */
+    size_t done;            /**< Size of the message that was last returned */
+} pbio_mailbox_decoder_t;
+
+pbio_error_t pbio_mailbox_encode(uint8_t *buf, size_t size, const char *name, size_t name_len,
+    const uint8_t *payload, size_t payload_len, size_t *msg_len);
+
+void pbio_mailbox_decoder_init(pbio_mailbox_decoder_t *dec, uint8_t *buf, size_t size);
+uint8_t *pbio_mailbox_decoder_get_space(pbio_mailbox_decoder_t *dec, size_t *space);
+void pbio_mailbox_decoder_commit(pbio_mailbox_decoder_t *dec, size_t count);
+pbio_error_t pbio_mailbox_decoder_next(pbio_mailbox_decoder_t *dec, pbio_mailbox_msg_t *msg);
+
+#endif // _PBIO_MAILBOX_H_
@@ -8,9 +8,26 @@
 
 #include <fixmath.h>
 
+/**
+ * Scaling factor with cached reciprocal, so that scaling in either direction
+ * takes just one multiplication.
+ */
+typedef struct _pbio_math_scale_t {
+    fix16_t scale;      /**< Scaling factor, such as encoder counts per degree */
+    fix16_t inverse;    /**< Cached value of 1/scale */
+} pbio_math_scale_t;
+
 int32_t pbio_math_sign(int32_t a);
 int32_t pbio_math_div_i32_fix16(int32_t a, fix16_t b);
 int32_t pbio_math_mul_i32_fix16(int32_t a, fix16_t b);
 int32_t pbio_math_sqrt(int32_t n);
 
+void pbio_math_scale_set(pbio_math_scale_t *s, fix16_t scale);
+int32_t pbio_math_scale_mul(const pbio_math_scale_t *s, int32_t a);
+int32_t pbio_math_scale_div(const pbio_math_scale_t *s, int32_t a);
+
+fix16_t pbio_math_sin_deg(fix16_t angle);
+fix16_t pbio_math_cos_deg(fix16_t angle);
+fix16_t pbio_math_atan2_deg(int32_t y, int32_t x);
+
 #endif // _PBIO_MATH_H_
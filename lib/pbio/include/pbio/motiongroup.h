@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_MOTIONGROUP_H_
+#define _PBIO_MOTIONGROUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+#include <pbio/servo.h>
+
+#if PBDRV_CONFIG_NUM_MOTOR_CONTROLLER != 0
+
+/**
+ * Group of servos that move along time-synchronized trajectories
+ */
+typedef struct _pbio_motiongroup_t {
+    bool active;                                            /**< Whether a synchronized maneuver is in progress */
+    uint8_t num_axes;                                       /**< Number of servos in the group */
+    pbio_servo_t *axes[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];  /**< Servos in the group */
+    int32_t t0;                                             /**< Start time of the ongoing maneuver */
+} pbio_motiongroup_t;
+
+pbio_error_t pbio_motiongroup_setup(pbio_motiongroup_t *group, pbio_servo_t **axes, uint8_t num_axes);
+void pbio_motiongroup_release(pbio_motiongroup_t *group);
+
+pbio_error_t pbio_motiongroup_run_target(pbio_motiongroup_t *group, int32_t speed, const int32_t *targets, pbio_actuation_t after_stop);
+pbio_error_t pbio_motiongroup_stop(pbio_motiongroup_t *group, pbio_actuation_t after_stop);
+bool pbio_motiongroup_is_done(pbio_motiongroup_t *group);
+
+pbio_error_t pbio_motiongroup_update(pbio_motiongroup_t *group);
+
+#endif // PBDRV_CONFIG_NUM_MOTOR_CONTROLLER
+
+#endif // _PBIO_MOTIONGROUP_H_
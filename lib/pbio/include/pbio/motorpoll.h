@@ -6,6 +6,7 @@
 
 #include <pbio/drivebase.h>
 #include <pbio/error.h>
+#include <pbio/motiongroup.h>
 #include <pbio/servo.h>
 
 #if PBDRV_CONFIG_NUM_MOTOR_CONTROLLER != 0
@@ -18,6 +19,10 @@ pbio_error_t pbio_motorpoll_get_drivebase(pbio_drivebase_t **db);
 pbio_error_t pbio_motorpoll_get_drivebase_status(pbio_drivebase_t *db);
 pbio_error_t pbio_motorpoll_set_drivebase_status(pbio_drivebase_t *db, pbio_error_t err);
 
+pbio_error_t pbio_motorpoll_get_motiongroup(pbio_motiongroup_t **group);
+pbio_error_t pbio_motorpoll_get_motiongroup_status(pbio_motiongroup_t *group);
+pbio_error_t pbio_motorpoll_set_motiongroup_status(pbio_motiongroup_t *group, pbio_error_t err);
+
 void _pbio_motorpoll_reset_all(void);
 void _pbio_motorpoll_poll(void);
 
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_RECORD_H_
+#define _PBIO_RECORD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbdrv/config.h>
+#include <pbio/config.h>
+#include <pbio/control.h>
+#include <pbio/error.h>
+
+/**
+ * Recording and replay of the inputs of the control loop.
+ *
+ * While recording, every servo and drive base update stores the time, counts
+ * and rates it measured, the control signals it computed and a copy of its
+ * controllers whenever a command changed them. Sensor data is stored as it
+ * arrives. Everything goes into a compact binary stream that can be saved on
+ * the brick.
+ *
+ * On replay, pbio_servo_control_update() and pbio_drivebase_update() get the
+ * recorded values instead of reading the hardware, so that the controllers
+ * compute exactly what they computed on the brick. Differences between the
+ * recorded and the replayed control signals are counted as mismatches.
+ *
+ * Servos that follow another servo or stream targets are not reproduced,
+ * since their references are not part of the recording.
+ */
+
+/** Update channels: one per servo, by motor port, and one for the drive base */
+#define PBIO_RECORD_CHANNEL_DRIVEBASE (PBDRV_CONFIG_NUM_MOTOR_CONTROLLER)
+#define PBIO_RECORD_NUM_CHANNELS (PBDRV_CONFIG_NUM_MOTOR_CONTROLLER + 1)
+
+/** Largest number of controllers in one update */
+#define PBIO_RECORD_MAX_CONTROL (2)
+
+/** Largest number of measured values in one update */
+#define PBIO_RECORD_MAX_VALUES (5)
+
+#if PBIO_CONFIG_RECORD
+
+pbio_error_t pbio_record_start(uint32_t size);
+void pbio_record_stop(void);
+pbio_error_t pbio_record_get_data(const uint8_t **data, uint32_t *size);
+bool pbio_record_is_full(void);
+
+pbio_error_t pbio_record_replay_start(const uint8_t *data, uint32_t size);
+bool pbio_record_replay_next(uint8_t *channel);
+uint32_t pbio_record_replay_get_mismatches(void);
+
+void _pbio_record_begin(uint8_t channel, pbio_control_t **ctl, uint8_t num_ctl);
+void _pbio_record_values(uint8_t channel, int32_t *values, uint8_t num_values);
+void _pbio_record_output(uint8_t channel, uint8_t index, pbio_actuation_t actuation, int32_t control);
+void _pbio_record_end(uint8_t channel, pbio_control_t **ctl, uint8_t num_ctl);
+void _pbio_record_iodev_data(uint8_t index, uint8_t mode, const uint8_t *data, uint8_t size);
+
+#else // PBIO_CONFIG_RECORD
+
+static inline void _pbio_record_begin(uint8_t channel, pbio_control_t **ctl, uint8_t num_ctl) { }
+static inline void _pbio_record_values(uint8_t channel, int32_t *values, uint8_t num_values) { }
+static inline void _pbio_record_output(uint8_t channel, uint8_t index, pbio_actuation_t actuation, int32_t control) { }
+static inline void _pbio_record_end(uint8_t channel, pbio_control_t **ctl, uint8_t num_ctl) { }
+static inline void _pbio_record_iodev_data(uint8_t index, uint8_t mode, const uint8_t *data, uint8_t size) { }
+
+#endif // PBIO_CONFIG_RECORD
+
+#endif // _PBIO_RECORD_H_
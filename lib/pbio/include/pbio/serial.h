@@ -20,6 +20,8 @@ pbio_error_t pbio_serial_in_waiting(pbio_serial_t *ser, size_t *waiting);
 
 pbio_error_t pbio_serial_read(pbio_serial_t *ser, uint8_t *buf, size_t count);
 
+pbio_error_t pbio_serial_wait(pbio_serial_t *ser, int max_time);
+
 pbio_error_t pbio_serial_clear(pbio_serial_t *ser);
 
 #else // PBIO_CONFIG_SERIAL
@@ -28,6 +30,7 @@ static inline pbio_error_t pbio_serial_get(pbio_serial_t **_ser, pbio_port_t por
 static inline pbio_error_t pbio_serial_write(pbio_serial_t *ser, const void *buf, size_t count) { return PBIO_ERROR_NOT_SUPPORTED; }
 static inline pbio_error_t pbio_serial_in_waiting(pbio_serial_t *ser, size_t *waiting) { return PBIO_ERROR_NOT_SUPPORTED; }
 static inline pbio_error_t pbio_serial_read(pbio_serial_t *ser, uint8_t *buf, size_t count) { return PBIO_ERROR_NOT_SUPPORTED; }
+static inline pbio_error_t pbio_serial_wait(pbio_serial_t *ser, int max_time) { return PBIO_ERROR_NOT_SUPPORTED; }
 static inline pbio_error_t pbio_serial_clear(pbio_serial_t *ser) { return PBIO_ERROR_NOT_SUPPORTED; }
 
 #endif // PBIO_CONFIG_SERIAL
@@ -18,6 +18,8 @@
 #include <pbio/dcmotor.h>
 #include <pbio/tacho.h>
 #include <pbio/trajectory.h>
+#include <pbio/follow.h>
+#include <pbio/stream.h>
 #include <pbio/control.h>
 #include <pbio/logger.h>
 
@@ -32,6 +34,8 @@ typedef struct _pbio_servo_t {
     pbio_control_t control;
     pbio_port_t port;
     pbio_log_t log;
+    pbio_follow_t follow;
+    pbio_stream_t stream;
 } pbio_servo_t;
 
 pbio_error_t pbio_servo_setup(pbio_servo_t *srv, pbio_direction_t direction, fix16_t gear_ratio);
@@ -50,6 +54,8 @@ pbio_error_t pbio_servo_run_until_stalled(pbio_servo_t *srv, int32_t speed, pbio
 pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, int32_t speed, int32_t angle, pbio_actuation_t after_stop);
 pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, int32_t speed, int32_t target, pbio_actuation_t after_stop);
 pbio_error_t pbio_servo_track_target(pbio_servo_t *srv, int32_t target);
+pbio_error_t pbio_servo_stream_target(pbio_servo_t *srv, int32_t target, int32_t time_stamp, int32_t delay);
+pbio_error_t pbio_servo_follow(pbio_servo_t *srv, pbio_servo_t *leader, fix16_t ratio, int32_t offset, bool relative, const int32_t *cam, uint8_t cam_size, int32_t cam_period);
 
 pbio_error_t pbio_servo_control_update(pbio_servo_t *srv);
 
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_STREAM_H_
+#define _PBIO_STREAM_H_
+
+#include <stdint.h>
+
+#include <pbio/trajectory.h>
+
+#define PBIO_STREAM_SIZE (4)
+#define PBIO_STREAM_EXTRAPOLATE_MAX (100*US_PER_MS)
+#define PBIO_STREAM_LAG_MAX (200*US_PER_MS)
+
+/**
+ * Buffer of timestamped setpoints of a servo that follows a stream of targets
+ */
+typedef struct _pbio_stream_t {
+    uint8_t size;                       /**< Number of setpoints in the buffer, or 0 if not streaming */
+    uint16_t stamp;                     /**< Sender time stamp of the latest setpoint, in milliseconds */
+    int32_t time_stamp;                 /**< Hub time for that time stamp, including the playback delay, in microseconds */
+    int32_t delay;                      /**< Delay between sending and playing back setpoints, in microseconds */
+    int32_t lag;                        /**< Extra delay after setpoints that arrived late, in microseconds */
+    int32_t time[PBIO_STREAM_SIZE];     /**< Hub time at which each setpoint should be reached, oldest first */
+    int32_t count[PBIO_STREAM_SIZE];    /**< Target count of each setpoint */
+} pbio_stream_t;
+
+void pbio_stream_start(pbio_stream_t *s, int32_t time_now, int32_t count, int32_t stamp, int32_t delay);
+
+void pbio_stream_add(pbio_stream_t *s, int32_t time_now, int32_t count, int32_t stamp);
+
+void pbio_stream_get_reference(pbio_stream_t *s, int32_t time_now, int32_t *count, int32_t *count_ext, int32_t *rate);
+
+#endif // _PBIO_STREAM_H_
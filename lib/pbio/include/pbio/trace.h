@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBIO_TRACE_H_
+#define _PBIO_TRACE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <pbio/config.h>
+
+// Trace event types in addition to PROCESS_TRACE_POST/CALL/TIMER from Contiki
+#define PBIO_TRACE_MOTORPOLL (16)  /**< Servo, drivebase and motion group updates */
+#define PBIO_TRACE_LIGHTPOLL (17)  /**< Light animation updates */
+
+// Process id used for trace events that do not belong to a process
+#define PBIO_TRACE_ID_NONE (0)
+
+// Process id used for broadcast events, and when more processes were seen than fit in the table
+#define PBIO_TRACE_ID_OTHER (0xFF)
+
+/**
+ * One entry in the trace ring buffer.
+ */
+typedef struct _pbio_trace_event_t {
+    uint32_t time;      /**< Value of clock_usecs() at the start of the event */
+    uint32_t duration;  /**< Duration of the event (µs) */
+    uint8_t type;       /**< PROCESS_TRACE_* or PBIO_TRACE_* */
+    uint8_t id;         /**< Process id, see pbio_trace_get_name() */
+    uint8_t event;      /**< Contiki event */
+    uint8_t nevents;    /**< Number of events in the queue afterwards */
+} pbio_trace_event_t;
+
+#if PROCESS_CONF_TRACE
+
+void pbio_trace_record(uint8_t type, unsigned long start);
+static inline unsigned long pbio_trace_now(void) { return clock_usecs(); }
+void pbio_trace_clear(void);
+uint32_t pbio_trace_get_count(void);
+bool pbio_trace_get_event(uint32_t index, pbio_trace_event_t *event);
+const char *pbio_trace_get_name(uint8_t id);
+
+#else
+
+static inline void pbio_trace_record(uint8_t type, unsigned long start) { }
+static inline unsigned long pbio_trace_now(void) { return 0; }
+static inline void pbio_trace_clear(void) { }
+static inline uint32_t pbio_trace_get_count(void) { return 0; }
+static inline bool pbio_trace_get_event(uint32_t index, pbio_trace_event_t *event) { return false; }
+static inline const char *pbio_trace_get_name(uint8_t id) { return NULL; }
+
+#endif // PROCESS_CONF_TRACE
+
+#endif // _PBIO_TRACE_H_
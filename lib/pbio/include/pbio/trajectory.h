@@ -50,15 +50,28 @@ typedef struct _pbio_trajectory_t {
     int32_t w1;                          /**<  Encoder rate target when not accelerating */
     int32_t a0;                          /**<  Encoder acceleration during in-phase */
     int32_t a2;                          /**<  Encoder acceleration during out-phase */
+    int64_t qth0;                        /**<  Encoder count at start of in-phase, in Q16 counts */
+    int64_t qth1;                        /**<  Encoder count at start of constant speed phase, in Q16 counts */
+    int64_t qth2;                        /**<  Encoder count at start of out-phase, in Q16 counts */
+    int64_t qw0;                         /**<  Initial rate w0 in Q40 counts per microsecond */
+    int64_t qw1;                         /**<  Target rate w1 in Q40 counts per microsecond */
+    int64_t qa0;                         /**<  Half of a0 in Q64 counts per microsecond squared */
+    int64_t qa2;                         /**<  Half of a2 in Q64 counts per microsecond squared */
+    int32_t ra0;                         /**<  Acceleration a0 in Q32 counts per second per microsecond */
+    int32_t ra2;                         /**<  Acceleration a2 in Q32 counts per second per microsecond */
 } pbio_trajectory_t;
 
 // Core trajectory generators
 
-void pbio_trajectory_make_stationary(pbio_trajectory_t *ref, int32_t t0, int32_t th0);
+void pbio_trajectory_make_stationary(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th0_ext);
+
+void pbio_trajectory_make_constant(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th0_ext, int32_t w);
 
 pbio_error_t pbio_trajectory_make_time_based(pbio_trajectory_t *ref, int32_t t0, int32_t duration, int32_t th0, int32_t th0_ext, int32_t w0, int32_t wt, int32_t wmax, int32_t a, int32_t amax);
 
-pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th3, int32_t w0, int32_t wt, int32_t wmax, int32_t a, int32_t amax);
+pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th0_ext, int32_t th3, int32_t w0, int32_t wt, int32_t wmax, int32_t a, int32_t amax);
+
+pbio_error_t pbio_trajectory_make_scaled(pbio_trajectory_t *ref, const pbio_trajectory_t *master, int32_t th0, int32_t th0_ext, int32_t th3);
 
 void pbio_trajectory_get_reference(pbio_trajectory_t *traject, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref);
 
@@ -87,6 +87,18 @@ pbio_error_t pbsys_stdin_get_char(uint8_t *c);
  */
 pbio_error_t pbsys_stdout_put_char(uint8_t c);
 
+/**
+ * Write several characters to stdout.
+ * @param [in] data     The characters to write
+ * @param [in,out] size The number of characters in *data*. On success, this is
+ *                      set to the number of characters that were written.
+ * @return              ::PBIO_SUCCESS if at least one character was written,
+ *                      ::PBIO_ERROR_AGAIN if nothing could be written at this
+ *                      time or ::PBIO_ERROR_NOT_SUPPORTED if the platform does
+ *                      not have a stdout.
+ */
+pbio_error_t pbsys_stdout_write(const uint8_t *data, uint32_t *size);
+
 /**
  * Reboots the brick. This could also be considered a "hard" reset. This
  * function never returns.
@@ -109,6 +121,7 @@ static inline pbio_error_t pbsys_stdin_get_char(uint8_t *c) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
 static inline pbio_error_t pbsys_stdout_put_char(uint8_t c) { return PBIO_ERROR_NOT_SUPPORTED; }
+static inline pbio_error_t pbsys_stdout_write(const uint8_t *data, uint32_t *size) { return PBIO_ERROR_NOT_SUPPORTED; }
 static inline void pbsys_reset(void) { }
 static inline void pbsys_reboot(bool fw_update) { }
 static inline void pbsys_power_off(void) { }
@@ -20,6 +20,7 @@
 #define PBDRV_CONFIG_BATTERY_ADC_CURRENT_SCALED_MAX 2444
 
 #define PBDRV_CONFIG_BLUETOOTH                      (1)
+#define PBDRV_CONFIG_BLUETOOTH_TX_BUF_SIZE          (64)
 
 #define PBDRV_CONFIG_BUTTON                         (1)
 #define PBDRV_CONFIG_BUTTON_GPIO                    (1)
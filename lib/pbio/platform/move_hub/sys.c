@@ -102,6 +102,10 @@ pbio_error_t pbsys_stdout_put_char(uint8_t c) {
     return pbdrv_bluetooth_tx(c);
 }
 
+pbio_error_t pbsys_stdout_write(const uint8_t *data, uint32_t *size) {
+    return pbdrv_bluetooth_tx_buf(data, size);
+}
+
 void pbsys_reboot(bool fw_update) {
     if (fw_update) {
         bootloader_magic_addr = BOOTLOADER_MAGIC_VALUE;
@@ -84,6 +84,14 @@ pbio_error_t pbsys_stdout_put_char(uint8_t c) {
     return PBIO_SUCCESS;
 }
 
+pbio_error_t pbsys_stdout_write(const uint8_t *data, uint32_t *size) {
+    pbio_error_t err = pbsys_stdout_put_char(data[0]);
+    if (err == PBIO_SUCCESS) {
+        *size = 1;
+    }
+    return err;
+}
+
 void pbsys_reboot(bool fw_update) {
     // this function never returns
     NVIC_SystemReset();
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// The clock of the virtual hub only moves when the simulation is stepped.
+
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include "../../drv/virtual/virtual.h"
+
+void clock_init(void) {
+}
+
+clock_time_t clock_time() {
+    return pbdrv_virtual_get_time() / 1000;
+}
+
+unsigned long clock_usecs() {
+    return pbdrv_virtual_get_time();
+}
+
+void clock_delay_usec(uint16_t duration) {
+    // busy waiting lets the simulated world move on
+    pbdrv_virtual_step(duration);
+}
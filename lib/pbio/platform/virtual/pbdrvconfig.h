@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#ifndef _PBDRVCONFIG_H_
+#define _PBDRVCONFIG_H_
+
+// platform-specific configuration for the simulated hub that runs on a PC
+
+#define PBDRV_CONFIG_VIRTUAL                        (1)
+
+#define PBDRV_CONFIG_BATTERY                        (1)
+#define PBDRV_CONFIG_BATTERY_VIRTUAL                (1)
+
+// motor ports A-D use counters 0-3, sensor ports 1-4 use counters 4-7
+#define PBDRV_CONFIG_COUNTER                        (1)
+#define PBDRV_CONFIG_COUNTER_NUM_DEV                (8)
+#define PBDRV_CONFIG_COUNTER_VIRTUAL                (1)
+
+#define PBDRV_CONFIG_IOPORT                         (1)
+
+#define PBDRV_CONFIG_MOTOR                          (1)
+
+#define PBDRV_CONFIG_UART                           (1)
+#define PBDRV_CONFIG_UART_VIRTUAL                   (1)
+#define PBDRV_CONFIG_UART_VIRTUAL_NUM_UART          (4)
+
+#define PBDRV_CONFIG_HAS_PORT_A (1)
+#define PBDRV_CONFIG_HAS_PORT_B (1)
+#define PBDRV_CONFIG_HAS_PORT_C (1)
+#define PBDRV_CONFIG_HAS_PORT_D (1)
+#define PBDRV_CONFIG_HAS_PORT_1 (1)
+#define PBDRV_CONFIG_HAS_PORT_2 (1)
+#define PBDRV_CONFIG_HAS_PORT_3 (1)
+#define PBDRV_CONFIG_HAS_PORT_4 (1)
+
+#define PBDRV_CONFIG_FIRST_MOTOR_PORT       PBIO_PORT_A
+#define PBDRV_CONFIG_LAST_MOTOR_PORT        PBIO_PORT_D
+#define PBDRV_CONFIG_NUM_MOTOR_CONTROLLER   (4)
+
+#define PBDRV_CONFIG_FIRST_IO_PORT          PBIO_PORT_1
+#define PBDRV_CONFIG_LAST_IO_PORT           PBIO_PORT_4
+#define PBDRV_CONFIG_NUM_IO_PORT            (4)
+
+#endif // _PBDRVCONFIG_H_
@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#define PBIO_CONFIG_DCMOTOR                 (1)
+
+#define PBIO_CONFIG_BATTERY_COMPENSATION    (1)
+#define PBIO_CONFIG_BATTERY_NOMINAL_MV      (7200)
+
+#define PBIO_CONFIG_TACHO                   (1)
+
+#define PBIO_CONFIG_UARTDEV                 (1)
+#define PBIO_CONFIG_UARTDEV_NUM_DEV         (4)
+
+#define PBIO_CONFIG_ARENA_KB                (128)
+
+#define PBIO_CONFIG_RECORD                  (1)
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <pbio/error.h>
+#include <pbio/iodev.h>
+#include <pbio/port.h>
+#include <pbio/uartdev.h>
+
+// UART and counter IDs of the sensor ports 1-4
+
+const pbio_uartdev_platform_data_t pbio_uartdev_platform_data[PBIO_CONFIG_UARTDEV_NUM_DEV] = {
+    [0] = {
+        .uart_id    = 0,
+        .counter_id = 4,
+    },
+    [1] = {
+        .uart_id    = 1,
+        .counter_id = 5,
+    },
+    [2] = {
+        .uart_id    = 2,
+        .counter_id = 6,
+    },
+    [3] = {
+        .uart_id    = 3,
+        .counter_id = 7,
+    },
+};
+
+// HACK: we don't have a generic ioport interface yet so defining this function
+// in platform.c
+pbio_error_t pbdrv_ioport_get_iodev(pbio_port_t port, pbio_iodev_t **iodev) {
+    if (port < PBIO_PORT_1 || port > PBIO_PORT_4) {
+        return PBIO_ERROR_INVALID_PORT;
+    }
+
+    return pbio_uartdev_get(port - PBIO_PORT_1, iodev);
+}
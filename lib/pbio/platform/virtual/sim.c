@@ -0,0 +1,507 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Control regression tests that run the pbio library on the virtual hub.
+//
+// Each scenario starts a fresh hub, runs it as fast as the PC allows and
+// checks the result against the exact state of the simulated world. The
+// program exits with a nonzero status if any scenario fails.
+//
+// With "replay <file>", it instead replays a recording made on a hub and
+// reports where the controllers now compute something else.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/wait.h>
+
+#include <pbio/battery.h>
+#include <pbio/control.h>
+#include <pbio/drivebase.h>
+#include <pbio/iodev.h>
+#include <pbio/main.h>
+#include <pbio/motiongroup.h>
+#include <pbio/motorpoll.h>
+#include <pbio/record.h>
+#include <pbio/servo.h>
+#include <pbdrv/ioport.h>
+
+#include "../../drv/virtual/virtual.h"
+
+// Time step between calls to the event loop in us
+#define LOOP_STEP (100)
+
+// Largest recording made or replayed, in bytes
+#define RECORD_SIZE (100 * 1024)
+
+typedef bool (*scenario_t)(void);
+
+static void run_for(uint32_t ms) {
+    uint32_t end = pbdrv_virtual_get_time() + ms * 1000;
+    while ((int32_t)(pbdrv_virtual_get_time() - end) < 0) {
+        pbdrv_virtual_step(LOOP_STEP);
+        while (pbio_do_one_event()) {
+        }
+    }
+}
+
+// Runs the hub until cond is true, or gives up after timeout ms
+#define RUN_UNTIL(cond, timeout) ({ \
+        uint32_t _start = pbdrv_virtual_get_time(); \
+        bool _ok; \
+        while (!(_ok = (cond)) && pbdrv_virtual_get_time() - _start < (timeout) * 1000) { \
+            run_for(1); \
+        } \
+        _ok; \
+    })
+
+// Sets up a servo and tells the poller about it, like the Motor class does
+static pbio_error_t get_servo(pbio_port_t port, pbio_direction_t direction, pbio_servo_t **srv) {
+    pbio_error_t err = pbio_motorpoll_get_servo(port, srv);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    while ((err = pbio_servo_setup(*srv, direction, F16C(1, 0))) == PBIO_ERROR_AGAIN) {
+        run_for(1);
+    }
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    return pbio_motorpoll_set_servo_status(*srv, PBIO_ERROR_AGAIN);
+}
+
+static float get_angle(pbio_port_t port) {
+    float angle, speed, current;
+    pbdrv_virtual_motor_get_state(port, &angle, &speed, &current);
+    return angle;
+}
+
+static float get_speed(pbio_port_t port) {
+    float angle, speed, current;
+    pbdrv_virtual_motor_get_state(port, &angle, &speed, &current);
+    return speed;
+}
+
+static bool servo_run_target(void) {
+    pbio_servo_t *srv;
+
+    if (get_servo(PBIO_PORT_A, PBIO_DIRECTION_CLOCKWISE, &srv) != PBIO_SUCCESS) {
+        return false;
+    }
+    if (pbio_servo_run_target(srv, 500, 360, PBIO_ACTUATION_HOLD) != PBIO_SUCCESS) {
+        return false;
+    }
+    if (!RUN_UNTIL(pbio_control_is_done(&srv->control), 3000)) {
+        printf("  target not reached\n");
+        return false;
+    }
+    run_for(500);
+
+    float error = get_angle(PBIO_PORT_A) - 360;
+    printf("  final error %.2f deg\n", error);
+    return fabsf(error) <= 3;
+}
+
+static bool servo_follow(void) {
+    pbio_servo_t *leader, *follower;
+
+    if (get_servo(PBIO_PORT_A, PBIO_DIRECTION_CLOCKWISE, &leader) != PBIO_SUCCESS ||
+        get_servo(PBIO_PORT_B, PBIO_DIRECTION_CLOCKWISE, &follower) != PBIO_SUCCESS) {
+        return false;
+    }
+
+    // Move the leader away from zero, so a jump at the start would show
+    if (pbio_servo_run_target(leader, 500, 90, PBIO_ACTUATION_HOLD) != PBIO_SUCCESS ||
+        !RUN_UNTIL(pbio_control_is_done(&leader->control), 2000)) {
+        return false;
+    }
+    float leader_start = get_angle(PBIO_PORT_A);
+    float follower_start = get_angle(PBIO_PORT_B);
+
+    // Follow at half speed, starting from where the follower is now
+    if (pbio_servo_follow(follower, leader, F16(1) / 2, 0, true, NULL, 0, 0) != PBIO_SUCCESS) {
+        return false;
+    }
+    run_for(200);
+    float jump = get_angle(PBIO_PORT_B) - follower_start;
+
+    // The leader runs back through zero, so its count becomes negative
+    pbio_servo_run(leader, -300);
+    run_for(2000);
+    float leader_end = get_angle(PBIO_PORT_A);
+    float error = get_angle(PBIO_PORT_B) - (follower_start + (leader_end - leader_start) / 2);
+    pbio_servo_stop_force(leader);
+    pbio_servo_stop_force(follower);
+
+    printf("  start jump %.2f deg, error %.2f deg at leader %.0f deg\n", jump, error, leader_end);
+    return fabsf(jump) <= 2 && fabsf(error) <= 5 && leader_end < -300;
+}
+
+static bool drivebase_straight(void) {
+    pbio_servo_t *left, *right;
+    pbio_drivebase_t *db;
+    int32_t distance, drive_speed, angle, turn_rate;
+
+    // The right motor is mounted mirrored
+    if (get_servo(PBIO_PORT_A, PBIO_DIRECTION_COUNTERCLOCKWISE, &left) != PBIO_SUCCESS ||
+        get_servo(PBIO_PORT_B, PBIO_DIRECTION_CLOCKWISE, &right) != PBIO_SUCCESS ||
+        pbio_motorpoll_get_drivebase(&db) != PBIO_SUCCESS ||
+        pbio_drivebase_setup(db, left, right, F16C(56, 0), F16C(114, 0)) != PBIO_SUCCESS ||
+        pbio_motorpoll_set_drivebase_status(db, PBIO_ERROR_AGAIN) != PBIO_SUCCESS) {
+        return false;
+    }
+
+    // A heavier load on one side must not make the robot turn
+    pbdrv_virtual_motor_set_load(PBIO_PORT_A, 0.004f, 0.02f);
+    pbdrv_virtual_motor_set_load(PBIO_PORT_B, 0.004f, -0.05f);
+
+    if (pbio_drivebase_straight(db, 500, 200, 400) != PBIO_SUCCESS) {
+        return false;
+    }
+    if (!RUN_UNTIL(pbio_control_is_done(&db->control_distance) && pbio_control_is_done(&db->control_heading), 5000)) {
+        printf("  drive not done\n");
+        return false;
+    }
+    run_for(500);
+
+    pbio_drivebase_get_state(db, &distance, &drive_speed, &angle, &turn_rate);
+    printf("  distance %d mm, heading %d deg\n", distance, angle);
+    return abs(distance - 500) <= 5 && abs(angle) <= 3;
+}
+
+static bool motiongroup_run_target(void) {
+    pbio_servo_t *axes[2];
+    pbio_motiongroup_t *group;
+    const int32_t targets[] = { 720, 360 };
+    uint32_t time_done[] = { 0, 0 };
+
+    if (get_servo(PBIO_PORT_A, PBIO_DIRECTION_CLOCKWISE, &axes[0]) != PBIO_SUCCESS ||
+        get_servo(PBIO_PORT_B, PBIO_DIRECTION_CLOCKWISE, &axes[1]) != PBIO_SUCCESS ||
+        pbio_motorpoll_get_motiongroup(&group) != PBIO_SUCCESS) {
+        return false;
+    }
+
+    // Start like run_targets() does
+    if (pbio_motorpoll_set_motiongroup_status(group, PBIO_SUCCESS) != PBIO_SUCCESS ||
+        pbio_motiongroup_setup(group, axes, 2) != PBIO_SUCCESS ||
+        pbio_motiongroup_run_target(group, 500, targets, PBIO_ACTUATION_HOLD) != PBIO_SUCCESS ||
+        pbio_motorpoll_set_motiongroup_status(group, PBIO_ERROR_AGAIN) != PBIO_SUCCESS) {
+        return false;
+    }
+
+    // The shorter axis is held back by a load for a while, so the other one
+    // must wait for it. Both motors must still arrive at about the same time.
+    uint32_t time_start = pbdrv_virtual_get_time();
+    while (time_done[0] == 0 || time_done[1] == 0) {
+        uint32_t time = pbdrv_virtual_get_time() - time_start;
+        if (time > 5000 * 1000) {
+            printf("  targets not reached\n");
+            return false;
+        }
+        pbdrv_virtual_motor_set_load(PBIO_PORT_B, 0.004f, time > 300 * 1000 && time < 1300 * 1000 ? 0.4f : 0);
+        run_for(1);
+        for (int i = 0; i < 2; i++) {
+            if (time_done[i] == 0 && fabsf(get_angle(PBIO_PORT_A + i) - targets[i]) <= 2) {
+                time_done[i] = pbdrv_virtual_get_time();
+            }
+        }
+    }
+    int32_t time_diff = (int32_t)(time_done[0] - time_done[1]) / 1000;
+    printf("  arrived %d ms apart\n", time_diff);
+    if (abs(time_diff) > 100 || !RUN_UNTIL(pbio_motiongroup_is_done(group), 1000)) {
+        return false;
+    }
+
+    // A reset stops polling the group
+    _pbio_motorpoll_reset_all();
+    return pbio_motorpoll_get_motiongroup_status(group) == PBIO_SUCCESS;
+}
+
+static bool lump_sensor(void) {
+    pbio_iodev_t *iodev;
+    uint8_t *data;
+    int16_t cm = 1230;
+    int16_t in = 484;
+
+    pbdrv_virtual_lump_connect(PBIO_PORT_1, &pbdrv_virtual_lump_ev3_ultrasonic);
+    pbdrv_virtual_lump_set_data(PBIO_PORT_1, 0, &cm);
+    pbdrv_virtual_lump_set_data(PBIO_PORT_1, 1, &in);
+
+    if (!RUN_UNTIL(pbdrv_ioport_get_iodev(PBIO_PORT_1, &iodev) == PBIO_SUCCESS &&
+        iodev->info->type_id == PBIO_IODEV_TYPE_ID_EV3_ULTRASONIC_SENSOR, 3000)) {
+        printf("  sensor not found\n");
+        return false;
+    }
+    uint32_t connect_time = pbdrv_virtual_get_time() / 1000;
+    if (!RUN_UNTIL(pbio_iodev_get_data(iodev, &data) == PBIO_SUCCESS && *(int16_t *)data == cm, 500)) {
+        printf("  no data in mode 0\n");
+        return false;
+    }
+
+    pbio_error_t err;
+    while ((err = pbio_iodev_set_mode_begin(iodev, 1)) == PBIO_ERROR_AGAIN) {
+        run_for(1);
+    }
+    if (err == PBIO_SUCCESS) {
+        while ((err = pbio_iodev_set_mode_end(iodev)) == PBIO_ERROR_AGAIN) {
+            run_for(1);
+        }
+    }
+    if (err != PBIO_SUCCESS) {
+        printf("  mode change failed: %d\n", err);
+        return false;
+    }
+    if (!RUN_UNTIL(pbio_iodev_get_data(iodev, &data) == PBIO_SUCCESS && *(int16_t *)data == in, 500)) {
+        printf("  no data in mode 1\n");
+        return false;
+    }
+
+    // The hub must keep the connection alive
+    run_for(2000);
+    if (pbdrv_ioport_get_iodev(PBIO_PORT_1, &iodev) != PBIO_SUCCESS ||
+        iodev->info->type_id != PBIO_IODEV_TYPE_ID_EV3_ULTRASONIC_SENSOR || iodev->mode != 1) {
+        printf("  connection lost\n");
+        return false;
+    }
+
+    printf("  connected after %u ms\n", connect_time);
+    return true;
+}
+
+static bool battery_compensation(void) {
+    pbio_servo_t *srv;
+
+    pbdrv_virtual_battery_set(9000, 200);
+    pbio_battery_set_compensation(true);
+    if (get_servo(PBIO_PORT_A, PBIO_DIRECTION_CLOCKWISE, &srv) != PBIO_SUCCESS) {
+        return false;
+    }
+
+    // Same duty cycle at a full and an almost empty battery, applied after
+    // the voltage filter has settled
+    run_for(1000);
+    pbio_servo_set_duty_cycle(srv, 50);
+    run_for(1000);
+    float high = get_speed(PBIO_PORT_A);
+
+    // Full duty is scaled down like any other, so the speed does not jump
+    // near saturation: it is the same as 80% duty uncompensated at 9 V
+    pbio_servo_set_duty_cycle(srv, 100);
+    run_for(1000);
+    float full = get_speed(PBIO_PORT_A);
+    pbio_battery_set_compensation(false);
+    pbio_servo_set_duty_cycle(srv, 100 * PBIO_CONFIG_BATTERY_NOMINAL_MV / 9000);
+    run_for(1000);
+    float uncompensated = get_speed(PBIO_PORT_A);
+    pbio_battery_set_compensation(true);
+
+    pbdrv_virtual_battery_set(6000, 200);
+    run_for(4000);
+    pbio_servo_set_duty_cycle(srv, 50);
+    run_for(1000);
+    float low = get_speed(PBIO_PORT_A);
+
+    pbio_battery_set_compensation(false);
+
+    printf("  speed %.0f deg/s at 9 V, %.0f deg/s at 6 V\n", high, low);
+    printf("  full duty at 9 V: %.0f deg/s, %.0f deg/s at 80%% uncompensated\n", full, uncompensated);
+    return high > 0 && fabsf(high - low) <= high * 0.05f && fabsf(full - uncompensated) <= uncompensated * 0.02f;
+}
+
+// Recording shared by the record and replay scenarios
+static char record_path[] = "/tmp/virtual-hub-XXXXXX";
+
+// Replays a recording on servos A to D and a drive base on A and B, the same
+// way the motor poller would have updated them
+static bool replay(const uint8_t *data, uint32_t size) {
+    pbio_servo_t *srv[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    pbio_drivebase_t *db;
+    pbio_error_t err;
+    uint32_t updates = 0;
+    uint8_t channel;
+
+    // The poller is not started, so only the replay updates the servos
+    for (int i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        if (pbio_motorpoll_get_servo(PBDRV_CONFIG_FIRST_MOTOR_PORT + i, &srv[i]) != PBIO_SUCCESS) {
+            return false;
+        }
+        while ((err = pbio_servo_setup(srv[i], PBIO_DIRECTION_CLOCKWISE, F16C(1, 0))) == PBIO_ERROR_AGAIN) {
+            run_for(1);
+        }
+        if (err != PBIO_SUCCESS) {
+            return false;
+        }
+    }
+
+    // Which motors the drive base used is not recorded
+    if (pbio_motorpoll_get_drivebase(&db) != PBIO_SUCCESS ||
+        pbio_drivebase_setup(db, srv[0], srv[1], F16C(56, 0), F16C(114, 0)) != PBIO_SUCCESS) {
+        return false;
+    }
+
+    err = pbio_record_replay_start(data, size);
+    if (err != PBIO_SUCCESS) {
+        printf("  not a recording of this version: %d\n", err);
+        return false;
+    }
+
+    while (pbio_record_replay_next(&channel)) {
+        if (channel == PBIO_RECORD_CHANNEL_DRIVEBASE) {
+            pbio_drivebase_update(db);
+        } else if (channel < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER) {
+            pbio_servo_control_update(srv[channel]);
+        }
+        updates++;
+    }
+
+    uint32_t mismatches = pbio_record_replay_get_mismatches();
+    printf("  %u updates, %u mismatches\n", updates, mismatches);
+    return updates > 0 && mismatches == 0;
+}
+
+static bool record_drive(void) {
+    const uint8_t *data;
+    uint32_t size;
+
+    if (pbio_record_start(RECORD_SIZE) != PBIO_SUCCESS) {
+        return false;
+    }
+    bool ok = drivebase_straight();
+    pbio_record_stop();
+
+    if (pbio_record_get_data(&data, &size) != PBIO_SUCCESS || pbio_record_is_full()) {
+        printf("  recording failed\n");
+        return false;
+    }
+
+    FILE *file = fopen(record_path, "wb");
+    if (!file || fwrite(data, 1, size, file) != size || fclose(file) != 0) {
+        return false;
+    }
+    printf("  recorded %u bytes\n", size);
+    return ok;
+}
+
+// Replays a file on the current hub
+static bool replay_file(const char *path) {
+    static uint8_t data[RECORD_SIZE];
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        printf("  can't open %s\n", path);
+        return false;
+    }
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    return replay(data, size);
+}
+
+static bool replay_drive(void) {
+    return replay_file(record_path);
+}
+
+static const struct {
+    const char *name;
+    scenario_t run;
+} scenarios[] = {
+    { "servo/run_target", servo_run_target },
+    { "servo/follow", servo_follow },
+    { "drivebase/straight", drivebase_straight },
+    { "motiongroup/run_target", motiongroup_run_target },
+    { "lump/sensor", lump_sensor },
+    { "battery/compensation", battery_compensation },
+    { "record/drive", record_drive },
+    { "record/replay", replay_drive },
+};
+
+// Runs a scenario on a fresh hub in a child process, since the library can't
+// be started twice. The simulated time is passed back through a pipe.
+static bool run_scenario(scenario_t scenario, double *sim_time) {
+    int fd[2];
+    uint32_t time = 0;
+    int status;
+
+    fflush(stdout);
+    if (pipe(fd) < 0) {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        pbdrv_virtual_reset();
+        pbio_init();
+        bool ok = scenario();
+        time = pbdrv_virtual_get_time();
+        write(fd[1], &time, sizeof(time));
+        fflush(stdout);
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fd[1]);
+    read(fd[0], &time, sizeof(time));
+    close(fd[0]);
+    waitpid(pid, &status, 0);
+
+    *sim_time += time * 1e-6;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *replay_path;
+
+static bool replay_arg(void) {
+    return replay_file(replay_path);
+}
+
+int main(int argc, char **argv) {
+    int failed = 0;
+    double sim_time = 0;
+    double start = wall_time();
+
+    if (argc == 3 && strcmp(argv[1], "replay") == 0) {
+        replay_path = argv[2];
+        bool ok = run_scenario(replay_arg, &sim_time);
+        printf("replay: %s\n", ok ? "PASS" : "FAIL");
+        return ok ? 0 : 1;
+    }
+    if (argc != 1) {
+        printf("usage: %s [replay <file>]\n", argv[0]);
+        return 2;
+    }
+
+    int fd = mkstemp(record_path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        printf("%s\n", scenarios[i].name);
+        bool ok = run_scenario(scenarios[i].run, &sim_time);
+        printf("%s: %s\n", scenarios[i].name, ok ? "PASS" : "FAIL");
+        failed += !ok;
+    }
+
+    unlink(record_path);
+
+    double elapsed = wall_time() - start;
+    printf("%d/%d failed, %.1f s simulated in %.2f s (%.0fx real time)\n",
+        failed, (int)(sizeof(scenarios) / sizeof(scenarios[0])), sim_time, elapsed, sim_time / elapsed);
+
+    return failed ? 1 : 0;
+}
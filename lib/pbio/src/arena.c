@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <pbio/config.h>
+
+#if PBIO_CONFIG_ARENA_KB
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pbio/arena.h>
+
+// The arena is a list of adjacent blocks, each starting with a header. Blocks
+// are allocated first fit and merged with free neighbours when freed.
+
+typedef struct _block_t {
+    uint32_t size;  // Size of the block in bytes, including this header
+    uint32_t used;  // Whether the block is allocated
+} block_t;
+
+#define ARENA_SIZE (PBIO_CONFIG_ARENA_KB * 1024)
+#define ALIGN (sizeof(block_t))
+
+static union {
+    block_t first;
+    uint64_t align;  // Blocks are 8 bytes, but block_t alone is only 4-byte aligned
+    uint8_t bytes[ARENA_SIZE];
+} arena;
+
+static uint32_t used;
+static uint32_t peak;
+
+#define NEXT(b) ((block_t *)((uint8_t *)(b) + (b)->size))
+#define END ((block_t *)&arena.bytes[ARENA_SIZE])
+
+/**
+ * Frees all blocks at once.
+ */
+void _pbio_arena_reset(void) {
+    arena.first.size = ARENA_SIZE;
+    arena.first.used = false;
+    used = 0;
+    peak = 0;
+}
+
+/**
+ * Allocates memory from the arena.
+ * @param [in]  size        Number of bytes
+ * @return                  The memory, aligned to 8 bytes, or NULL if there
+ *                          is no free block large enough
+ */
+void *pbio_arena_alloc(size_t size) {
+    if (size == 0 || size > ARENA_SIZE) {
+        return NULL;
+    }
+
+    // Lazy init, so the arena also works before pbio_init()
+    if (arena.first.size == 0) {
+        _pbio_arena_reset();
+    }
+
+    uint32_t need = (sizeof(block_t) + size + ALIGN - 1) & ~(ALIGN - 1);
+
+    for (block_t *b = &arena.first; b < END; b = NEXT(b)) {
+        if (b->used || b->size < need) {
+            continue;
+        }
+
+        // Split off the rest if it can hold another allocation
+        if (b->size - need >= 2 * sizeof(block_t)) {
+            block_t *rest = (block_t *)((uint8_t *)b + need);
+            rest->size = b->size - need;
+            rest->used = false;
+            b->size = need;
+        }
+
+        b->used = true;
+        used += b->size;
+        if (used > peak) {
+            peak = used;
+        }
+        return b + 1;
+    }
+    return NULL;
+}
+
+/**
+ * Returns memory to the arena.
+ * @param [in]  ptr         Memory from ::pbio_arena_alloc or NULL
+ */
+void pbio_arena_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    block_t *b = (block_t *)ptr - 1;
+    b->used = false;
+    used -= b->size;
+
+    // Merge adjacent free blocks
+    for (b = &arena.first; b < END; b = NEXT(b)) {
+        while (!b->used && NEXT(b) < END && !NEXT(b)->used) {
+            b->size += NEXT(b)->size;
+        }
+    }
+}
+
+/**
+ * Gets the usage and fragmentation of the arena.
+ * @param [out] stats       The statistics
+ */
+void pbio_arena_get_stats(pbio_arena_stats_t *stats) {
+    if (arena.first.size == 0) {
+        _pbio_arena_reset();
+    }
+
+    stats->size = ARENA_SIZE;
+    stats->used = used;
+    stats->peak = peak;
+    stats->largest_free = 0;
+    stats->num_free = 0;
+
+    for (block_t *b = &arena.first; b < END; b = NEXT(b)) {
+        if (!b->used) {
+            stats->num_free++;
+            if (b->size - sizeof(block_t) > stats->largest_free) {
+                stats->largest_free = b->size - sizeof(block_t);
+            }
+        }
+    }
+}
+
+#endif // PBIO_CONFIG_ARENA_KB
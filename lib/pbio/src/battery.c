@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <pbio/config.h>
+
+#if PBIO_CONFIG_BATTERY_COMPENSATION
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <pbdrv/battery.h>
+#include <pbio/battery.h>
+
+// Weight of each new reading in the filtered voltage is 1 / 2^N
+#define BATTERY_FILTER_SHIFT (3)
+
+// Time between readings. Reading the voltage can be slow, as on ev3dev
+// where it comes from sysfs, so this is done less often than other polling.
+#define BATTERY_POLL_MS (100)
+
+// The duty cycle is scaled up by at most a factor of two, since a battery
+// that is this low is about to shut down anyway
+#define BATTERY_MIN_MV (PBIO_CONFIG_BATTERY_NOMINAL_MV / 2)
+
+static bool enabled;
+
+static clock_time_t prev_poll_time;
+
+// Filtered voltage in mV, scaled by 2^BATTERY_FILTER_SHIFT, or 0 if there
+// was no reading yet
+static int32_t voltage_filtered;
+
+/**
+ * Turns compensation of motor duty cycles on or off. It is off by default.
+ * @param [in]  enable      Whether to compensate for the battery voltage
+ */
+void pbio_battery_set_compensation(bool enable) {
+    enabled = enable;
+}
+
+/**
+ * Gets the filtered battery voltage.
+ * @return                  The voltage in millivolts or 0 if it was not
+ *                          measured yet
+ */
+uint16_t pbio_battery_get_average_voltage(void) {
+    return voltage_filtered >> BATTERY_FILTER_SHIFT;
+}
+
+/**
+ * Scales a duty cycle so that it gives the same average motor voltage as it
+ * would at the nominal battery voltage.
+ * @param [in]  duty        Duty cycle at the nominal voltage
+ * @return                  Duty cycle at the current voltage, not limited
+ */
+int32_t pbio_battery_compensate_duty(int32_t duty) {
+    if (!enabled || voltage_filtered == 0) {
+        return duty;
+    }
+
+    int32_t voltage = pbio_battery_get_average_voltage();
+    if (voltage < BATTERY_MIN_MV) {
+        voltage = BATTERY_MIN_MV;
+    }
+    return duty * PBIO_CONFIG_BATTERY_NOMINAL_MV / voltage;
+}
+
+void _pbio_battery_reset(void) {
+    enabled = false;
+    voltage_filtered = 0;
+}
+
+void _pbio_battery_update(uint16_t voltage) {
+    // Start from the first reading, then filter out load spikes
+    if (voltage_filtered == 0) {
+        voltage_filtered = voltage << BATTERY_FILTER_SHIFT;
+    } else {
+        voltage_filtered += (int32_t)voltage - (voltage_filtered >> BATTERY_FILTER_SHIFT);
+    }
+}
+
+void _pbio_battery_poll(clock_time_t now) {
+    // The voltage is only needed while compensating
+    if (!enabled || (voltage_filtered && now - prev_poll_time < clock_from_msec(BATTERY_POLL_MS))) {
+        return;
+    }
+    prev_poll_time = now;
+
+    uint16_t voltage;
+    if (pbdrv_battery_get_voltage_now(&voltage) == PBIO_SUCCESS && voltage > 0) {
+        _pbio_battery_update(voltage);
+    }
+}
+
+#endif // PBIO_CONFIG_BATTERY_COMPENSATION
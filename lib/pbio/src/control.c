@@ -40,8 +40,13 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
         count_err_integral = 0;
     }
 
-    // Corresponding PID control signal
+    // Corresponding PID control signal. In angle control, the proportional part
+    // includes the millicounts of the reference, for smoother motion at low
+    // speeds. In timed control, count_err is a rate integral without them.
     duty_due_to_proportional = ctl->settings.pid_kp*count_err;
+    if (ctl->type == PBIO_CONTROL_ANGLE) {
+        duty_due_to_proportional += (ctl->settings.pid_kp*count_ref_ext)/1000;
+    }
     duty_due_to_derivative = ctl->settings.pid_kd*rate_err;
     duty_due_to_integral = (ctl->settings.pid_ki*(count_err_integral/US_PER_MS))/MS_PER_SECOND;
     duty_feedforward = pbio_math_sign(rate_ref)*ctl->settings.control_offset;
@@ -61,8 +66,10 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
     // Position anti-windup: pause trajectory or integration if falling behind despite using maximum duty
 
     // Position anti-windup in case of angle control (position error may not get too high)
+    bool windup;
     if (ctl->type == PBIO_CONTROL_ANGLE) {
-        if (abs(duty_due_to_proportional) >= max_windup_duty) {
+        windup = abs(duty_due_to_proportional) >= max_windup_duty;
+        if (windup) {
             // We are at the duty limit and we should prevent further position error integration.
             pbio_count_integrator_pause(&ctl->count_integrator, time_now, count_now, count_ref);
         }
@@ -73,7 +80,8 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
     }
     // Position anti-windup in case of timed speed control (speed integral may not get too high)
     else {
-        if (abs(duty_due_to_proportional) >= max_windup_duty && pbio_math_sign(duty_due_to_proportional) == pbio_math_sign(rate_err)) {
+        windup = abs(duty_due_to_proportional) >= max_windup_duty && pbio_math_sign(duty_due_to_proportional) == pbio_math_sign(rate_err);
+        if (windup) {
             // We are at the duty limit and we should prevent further speed error integration.
             pbio_rate_integrator_pause(&ctl->rate_integrator, time_now, count_now, count_ref);
         }
@@ -83,6 +91,18 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
         }
     }
 
+    // Keep the intermediate results, so loggers do not have to compute them again
+    ctl->state.time_ref = time_ref;
+    ctl->state.count_ref = count_ref;
+    ctl->state.rate_ref = rate_ref;
+    ctl->state.err = ctl->type == PBIO_CONTROL_ANGLE ? count_err : rate_err;
+    ctl->state.err_integral = ctl->type == PBIO_CONTROL_ANGLE ? count_err_integral : count_err; // count_err is the rate integral in timed control
+    ctl->state.duty_proportional = duty_due_to_proportional;
+    ctl->state.duty_integral = duty_due_to_integral;
+    ctl->state.duty_derivative = duty_due_to_derivative;
+    ctl->state.duty_feedforward = duty_feedforward;
+    ctl->state.windup = windup;
+
     // Check if controller is stalled
     ctl->stalled = ctl->type == PBIO_CONTROL_ANGLE ? 
                    pbio_count_integrator_stalled(&ctl->count_integrator, time_now, rate_now, ctl->settings.stall_time, ctl->settings.stall_rate_limit) :
@@ -133,7 +153,7 @@ pbio_error_t pbio_control_start_angle_control(pbio_control_t *ctl, int32_t time_
     // Compute the trajectory
     if (ctl->type == PBIO_CONTROL_NONE) {
         // If no control is ongoing, start from physical state
-        err = pbio_trajectory_make_angle_based(&ctl->trajectory, time_now, count_now, target_count, rate_now, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
+        err = pbio_trajectory_make_angle_based(&ctl->trajectory, time_now, count_now, 0, target_count, rate_now, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
         if (err != PBIO_SUCCESS) {
             return err;
         }
@@ -162,6 +182,28 @@ pbio_error_t pbio_control_start_angle_control(pbio_control_t *ctl, int32_t time_
     return PBIO_SUCCESS;
 }
 
+pbio_error_t pbio_control_start_synchronized_angle_control(pbio_control_t *ctl, const pbio_trajectory_t *master, int32_t count_start, int32_t count_start_ext, int32_t target_count, pbio_actuation_t after_stop) {
+
+    // Set new maneuver action and stop type, and state
+    ctl->after_stop = after_stop;
+    ctl->on_target = false;
+    ctl->on_target_func = pbio_control_on_target_angle;
+
+    // Compute the trajectory, scaled from the master trajectory
+    pbio_error_t err = pbio_trajectory_make_scaled(&ctl->trajectory, master, count_start, count_start_ext, target_count);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Always reset the integrator, so all controllers that follow the same master
+    // trajectory start with the same reference time.
+    int32_t integrator_max = pbio_control_settings_get_max_integrator(&ctl->settings);
+    pbio_count_integrator_reset(&ctl->count_integrator, ctl->trajectory.t0, ctl->trajectory.th0, ctl->trajectory.th0, integrator_max);
+    ctl->type = PBIO_CONTROL_ANGLE;
+
+    return PBIO_SUCCESS;
+}
+
 pbio_error_t pbio_control_start_relative_angle_control(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t relative_target_count, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_actuation_t after_stop) {
 
     // Get the count from which the relative count is to be counted
@@ -189,6 +231,34 @@ pbio_error_t pbio_control_start_relative_angle_control(pbio_control_t *ctl, int3
     return pbio_control_start_angle_control(ctl, time_now, count_now, target_count, rate_now, target_rate, acceleration, after_stop);
 }
 
+// Track a reference that is computed externally, such as from another motor.
+// This is called again in every control update, to move the reference along.
+pbio_error_t pbio_control_start_follow_control(pbio_control_t *ctl, int32_t time_now, int32_t target_count, int32_t target_count_ext, int32_t target_rate) {
+
+    // Set new maneuver action and stop type, and state. Following never ends
+    // by itself, so a follower is identified by its on-target function.
+    ctl->after_stop = PBIO_ACTUATION_HOLD;
+    ctl->on_target = false;
+    ctl->on_target_func = pbio_control_on_target_never;
+
+    // If called for the first time, set state and reset PID
+    if (ctl->type != PBIO_CONTROL_ANGLE) {
+        int32_t integrator_max = pbio_control_settings_get_max_integrator(&ctl->settings);
+        pbio_count_integrator_reset(&ctl->count_integrator, time_now, target_count, target_count, integrator_max);
+        ctl->type = PBIO_CONTROL_ANGLE;
+    }
+
+    // The reference passes through the target now, moving at the target rate
+    int32_t time_ref = pbio_control_get_ref_time(ctl, time_now);
+    pbio_trajectory_make_constant(&ctl->trajectory, time_ref, target_count, target_count_ext, target_rate);
+
+    return PBIO_SUCCESS;
+}
+
+bool pbio_control_is_following(pbio_control_t *ctl) {
+    return ctl->type == PBIO_CONTROL_ANGLE && ctl->on_target_func == pbio_control_on_target_never;
+}
+
 pbio_error_t pbio_control_start_hold_control(pbio_control_t *ctl, int32_t time_now, int32_t target_count) {
 
     // Set new maneuver action and stop type, and state
@@ -197,7 +267,7 @@ pbio_error_t pbio_control_start_hold_control(pbio_control_t *ctl, int32_t time_n
     ctl->on_target_func = pbio_control_on_target_always;
 
     // Compute new maneuver based on user argument, starting from the initial state
-    pbio_trajectory_make_stationary(&ctl->trajectory, time_now, target_count);
+    pbio_trajectory_make_stationary(&ctl->trajectory, time_now, target_count, 0);
     // If called for the first time, set state and reset PID
     if (ctl->type != PBIO_CONTROL_ANGLE) {
         // Initialize or reset the PID control status for the given maneuver
@@ -232,11 +302,11 @@ pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_
     else if (ctl->type == PBIO_CONTROL_ANGLE) {
         // If position based control is ongoing, start from its current reference. First get current reference signal.
         int32_t time_ref = pbio_control_get_ref_time(ctl, time_now);
-        int32_t count_start, rate_start, unused;
-        pbio_trajectory_get_reference(&ctl->trajectory, time_ref, &count_start, &unused, &rate_start, &unused);
+        int32_t count_start, count_start_ext, rate_start, unused;
+        pbio_trajectory_get_reference(&ctl->trajectory, time_ref, &count_start, &count_start_ext, &rate_start, &unused);
 
         // Now start the timed trajectory from there
-        err = pbio_trajectory_make_time_based(&ctl->trajectory, time_now, duration, count_start, 0, rate_start, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
+        err = pbio_trajectory_make_time_based(&ctl->trajectory, time_now, duration, count_start, count_start_ext, rate_start, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
         if (err != PBIO_SUCCESS) {
             return err;
         }
@@ -308,11 +378,11 @@ static bool _pbio_control_on_target_stalled(pbio_trajectory_t *trajectory, pbio_
 pbio_control_on_target_t pbio_control_on_target_stalled = _pbio_control_on_target_stalled;
 
 int32_t pbio_control_counts_to_user(pbio_control_settings_t *s, int32_t counts) {
-    return pbio_math_div_i32_fix16(counts, s->counts_per_unit);
+    return pbio_math_scale_div(&s->counts_per_unit, counts);
 }
 
 int32_t pbio_control_user_to_counts(pbio_control_settings_t *s, int32_t user) {
-    return pbio_math_mul_i32_fix16(user, s->counts_per_unit);
+    return pbio_math_scale_mul(&s->counts_per_unit, user);
 }
 
 void pbio_control_settings_get_limits(pbio_control_settings_t *s, int32_t *speed, int32_t *acceleration, int32_t *actuation) {
@@ -11,6 +11,7 @@
 
 #include <pbdrv/config.h>
 #include <pbdrv/motor.h>
+#include <pbio/battery.h>
 #include <pbio/dcmotor.h>
 
 static pbio_dcmotor_t dcmotors[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
@@ -85,9 +86,20 @@ pbio_error_t pbio_dcmotor_set_duty_cycle_sys(pbio_dcmotor_t *dcmotor, int32_t du
         duty_steps = -limit;
     }
 
-    // Signed duty cycle applied to bridge
+    // Signed duty cycle at nominal battery voltage
     dcmotor->duty_now = duty_steps;
 
+    // Duty cycle that gives the same motor voltage at the actual battery
+    // voltage, limited to what the battery can give. This is continuous,
+    // so the actuation does not jump as the duty cycle nears the limit.
+    duty_steps = pbio_battery_compensate_duty(duty_steps);
+    if (duty_steps > limit) {
+        duty_steps = limit;
+    }
+    if (duty_steps < -limit) {
+        duty_steps = -limit;
+    }
+
     // Flip sign if motor is inverted
     if (dcmotor->direction == PBIO_DIRECTION_COUNTERCLOCKWISE){
         duty_steps = -duty_steps;
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/download.h>
+#include <pbio/error.h>
+
+// CRC-32 with the same polynomial as the STM32 CRC unit, processed one nibble
+// at a time. Also see crc32_bytes() in tools/checksum.py.
+static const uint32_t crc32_table[16] = {
+    0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9,
+    0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+    0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61,
+    0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
+};
+
+uint32_t pbio_download_crc32(uint32_t crc, const uint8_t *data, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= (uint32_t)data[i] << 24;
+        crc = (crc << 4) ^ crc32_table[crc >> 28];
+        crc = (crc << 4) ^ crc32_table[crc >> 28];
+    }
+    return crc;
+}
+
+void pbio_download_init(pbio_download_t *dl, uint8_t *buf, uint32_t len, uint8_t *received, uint32_t time_now) {
+    dl->buf = buf;
+    dl->len = len;
+    dl->received = received;
+    dl->num_blocks = PBIO_DOWNLOAD_NUM_BLOCKS(len);
+    dl->num_received = 0;
+    dl->frame_len = 0;
+    dl->frame_size = 0;
+    dl->discard = false;
+    dl->time_last = time_now;
+    dl->reply_len = 0;
+    dl->reply_sent = 0;
+    memset(received, 0, PBIO_DOWNLOAD_RECEIVED_SIZE(len));
+}
+
+static bool block_is_received(pbio_download_t *dl, uint32_t seq) {
+    return dl->received[seq / 8] & (1 << (seq % 8));
+}
+
+static void set_reply(pbio_download_t *dl, uint8_t type, uint32_t seq) {
+    dl->reply[0] = type;
+    dl->reply[1] = seq >> 8;
+    dl->reply[2] = seq;
+    dl->reply_len = 3;
+    dl->reply_sent = 0;
+}
+
+// Requests the first block that is still missing
+static void set_nak(pbio_download_t *dl) {
+    uint32_t seq = 0;
+    while (seq < dl->num_blocks && block_is_received(dl, seq)) {
+        seq++;
+    }
+    set_reply(dl, PBIO_DOWNLOAD_NAK, seq);
+}
+
+// Handles one complete block and prepares the reply
+static void handle_frame(pbio_download_t *dl) {
+
+    uint32_t seq = dl->frame[0] << 8 | dl->frame[1];
+    uint32_t data_len = dl->frame_size - 6;
+    const uint8_t *crc_bytes = &dl->frame[dl->frame_size - 4];
+    uint32_t crc = (uint32_t)crc_bytes[0] << 24 | (uint32_t)crc_bytes[1] << 16 | (uint32_t)crc_bytes[2] << 8 | crc_bytes[3];
+
+    // On a bad checksum, we cannot trust the framing of what follows either
+    if (pbio_download_crc32(0xFFFFFFFF, dl->frame, dl->frame_size - 4) != crc) {
+        dl->discard = true;
+        return;
+    }
+
+    // Store the data, unless this is a resend of a block we already have
+    if (!block_is_received(dl, seq)) {
+        memcpy(&dl->buf[seq * PBIO_DOWNLOAD_BLOCK_SIZE], &dl->frame[2], data_len);
+        dl->received[seq / 8] |= 1 << (seq % 8);
+        dl->num_received++;
+    }
+    set_reply(dl, PBIO_DOWNLOAD_ACK, seq);
+}
+
+/**
+ * Receives available data and sends replies. Call this repeatedly until it
+ * returns something other than ::PBIO_ERROR_AGAIN.
+ * @param [in]  dl          The download state
+ * @param [in]  get_char    Function to read one byte from the host
+ * @param [in]  put_char    Function to write one byte to the host
+ * @param [in]  time_now    Current time (ms)
+ * @return                  ::PBIO_SUCCESS when the whole program was received
+ *                          and acknowledged, ::PBIO_ERROR_AGAIN if it is not
+ *                          done yet, ::PBIO_ERROR_TIMEDOUT if the host stopped
+ *                          sending, or any error from get_char or put_char.
+ */
+pbio_error_t pbio_download_poll(pbio_download_t *dl, pbio_download_get_char_t get_char, pbio_download_put_char_t put_char, uint32_t time_now) {
+    pbio_error_t err;
+    uint8_t c;
+
+    for (;;) {
+        // Finish sending the reply before reading more data
+        while (dl->reply_sent < dl->reply_len) {
+            err = put_char(dl->reply[dl->reply_sent]);
+            if (err != PBIO_SUCCESS) {
+                return err;
+            }
+            dl->reply_sent++;
+        }
+
+        // We're done when all blocks have been received and acknowledged
+        if (dl->num_received == dl->num_blocks) {
+            return PBIO_SUCCESS;
+        }
+
+        err = get_char(&c);
+        if (err != PBIO_SUCCESS) {
+            break;
+        }
+        dl->time_last = time_now;
+
+        if (dl->discard) {
+            continue;
+        }
+
+        dl->frame[dl->frame_len++] = c;
+
+        // Once we have the sequence number, we know how long the block is
+        if (dl->frame_len == 2) {
+            uint32_t seq = dl->frame[0] << 8 | dl->frame[1];
+            if (seq >= dl->num_blocks) {
+                dl->discard = true;
+                continue;
+            }
+            uint32_t data_len = dl->len - seq * PBIO_DOWNLOAD_BLOCK_SIZE;
+            if (data_len > PBIO_DOWNLOAD_BLOCK_SIZE) {
+                data_len = PBIO_DOWNLOAD_BLOCK_SIZE;
+            }
+            dl->frame_size = data_len + 6;
+        }
+
+        if (dl->frame_len > 2 && dl->frame_len == dl->frame_size) {
+            handle_frame(dl);
+            dl->frame_len = 0;
+        }
+    }
+
+    if (err != PBIO_ERROR_AGAIN) {
+        return err;
+    }
+
+    uint32_t idle_time = time_now - dl->time_last;
+
+    // When the line goes idle after an error or in the middle of a block,
+    // start over and ask for the first missing block.
+    if ((dl->discard || dl->frame_len > 0) && idle_time >= PBIO_DOWNLOAD_RESYNC_MS) {
+        dl->discard = false;
+        dl->frame_len = 0;
+        dl->time_last = time_now;
+        set_nak(dl);
+        return PBIO_ERROR_AGAIN;
+    }
+
+    if (idle_time >= PBIO_DOWNLOAD_TIMEOUT_MS) {
+        return PBIO_ERROR_TIMEDOUT;
+    }
+
+    return PBIO_ERROR_AGAIN;
+}
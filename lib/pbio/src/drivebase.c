@@ -1,11 +1,14 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2018-2020 The Pybricks Authors
 
+#include <string.h>
+
 #include <contiki.h>
 
 #include <pbio/error.h>
 #include <pbio/drivebase.h>
 #include <pbio/math.h>
+#include <pbio/record.h>
 #include <pbio/servo.h>
 
 #define DRIVEBASE_LOG_NUM_VALUES (15 + NUM_DEFAULT_LOG_VALUES)
@@ -85,6 +88,15 @@ static pbio_error_t drivebase_get_state(pbio_drivebase_t *db,
         return err;
     }
 
+    // Record the state, or replace it by the recorded state on replay
+    int32_t values[] = { *time_now, count_left, count_right, rate_left, rate_right };
+    _pbio_record_values(PBIO_RECORD_CHANNEL_DRIVEBASE, values, 5);
+    *time_now = values[0];
+    count_left = values[1];
+    count_right = values[2];
+    rate_left = values[3];
+    rate_right = values[4];
+
     *sum = count_left + count_right;
     *sum_rate = rate_left + rate_right;
     *dif = count_left - count_right;
@@ -150,9 +162,11 @@ static pbio_error_t drivebase_log_update(pbio_drivebase_t *db,
                                          int32_t sum_control,
                                          int32_t dif,
                                          int32_t dif_rate,
-                                         int32_t dif_control) {
+                                         int32_t dif_control,
+                                         bool controlled) {
 
     int32_t buf[DRIVEBASE_LOG_NUM_VALUES];
+    memset(buf, 0, sizeof(buf));
     buf[0] = time_now;
     buf[1] = sum;
     buf[2] = sum_rate;
@@ -161,21 +175,20 @@ static pbio_error_t drivebase_log_update(pbio_drivebase_t *db,
     buf[5] = dif_rate;
     buf[6] = dif_control;
 
-    int32_t sum_ref, sum_ref_ext, sum_rate_ref, sum_rate_err, sum_rate_err_integral, sum_acceleration_ref;
-    pbio_trajectory_get_reference(&db->control_distance.trajectory, time_now, &sum_ref, &sum_ref_ext, &sum_rate_ref, &sum_acceleration_ref);
-    pbio_rate_integrator_get_errors(&db->control_distance.rate_integrator, time_now, sum_rate_ref, sum, sum_ref, &sum_rate_err, &sum_rate_err_integral);
-    buf[7] = sum_ref;
-    buf[8] = sum_rate_err_integral;
-    buf[9] = sum_rate_ref;
-    buf[10] = sum_rate_err_integral;
-
-    int32_t dif_ref, dif_ref_ext, dif_rate_ref, dif_rate_err, dif_rate_err_integral, dif_acceleration_ref;
-    pbio_trajectory_get_reference(&db->control_heading.trajectory, time_now, &dif_ref, &dif_ref_ext, &dif_rate_ref, &dif_acceleration_ref);
-    pbio_rate_integrator_get_errors(&db->control_heading.rate_integrator, time_now, dif_rate_ref, dif, dif_ref, &dif_rate_err, &dif_rate_err_integral);
-    buf[11] = dif_ref;
-    buf[12] = dif_rate_err_integral;
-    buf[13] = dif_rate_ref;
-    buf[14] = dif_rate_err_integral;
+    // If control is active, log the data that control_update just computed
+    if (controlled) {
+        pbio_control_state_t *sum_state = &db->control_distance.state;
+        buf[7] = sum_state->count_ref;
+        buf[8] = sum_state->err;
+        buf[9] = sum_state->rate_ref;
+        buf[10] = sum_state->err_integral;
+
+        pbio_control_state_t *dif_state = &db->control_heading.state;
+        buf[11] = dif_state->count_ref;
+        buf[12] = dif_state->err;
+        buf[13] = dif_state->rate_ref;
+        buf[14] = dif_state->err_integral;
+    }
 
     return pbio_logger_update(&db->log, buf);
 }
@@ -205,7 +218,7 @@ pbio_error_t pbio_drivebase_setup(pbio_drivebase_t *db, pbio_servo_t *left, pbio
     }
 
     // Assert that both motors have the same gearing
-    if (left->control.settings.counts_per_unit != right->control.settings.counts_per_unit) {
+    if (left->control.settings.counts_per_unit.scale != right->control.settings.counts_per_unit.scale) {
         return PBIO_ERROR_INVALID_ARG;
     }
 
@@ -224,9 +237,9 @@ pbio_error_t pbio_drivebase_setup(pbio_drivebase_t *db, pbio_servo_t *left, pbio
     }
 
     // Count difference between the motors for every 1 degree drivebase rotation
-    db->control_heading.settings.counts_per_unit = 
+    pbio_math_scale_set(&db->control_heading.settings.counts_per_unit,
     fix16_mul(
-        left->control.settings.counts_per_unit,
+        left->control.settings.counts_per_unit.scale,
         fix16_div(
             fix16_mul(
                 axle_track,
@@ -234,12 +247,12 @@ pbio_error_t pbio_drivebase_setup(pbio_drivebase_t *db, pbio_servo_t *left, pbio
             ),
             wheel_diameter
         )
-    );
+    ));
 
     // Sum of motor counts for every 1 mm forward
-    db->control_distance.settings.counts_per_unit =
+    pbio_math_scale_set(&db->control_distance.settings.counts_per_unit,
     fix16_mul(
-        left->control.settings.counts_per_unit,
+        left->control.settings.counts_per_unit.scale,
         fix16_div(
             fix16_mul(
                 fix16_from_int(180),
@@ -247,7 +260,7 @@ pbio_error_t pbio_drivebase_setup(pbio_drivebase_t *db, pbio_servo_t *left, pbio
             ),
             wheel_diameter
         )
-    );
+    ));
 
     return PBIO_SUCCESS;
 }
@@ -310,7 +323,7 @@ pbio_error_t pbio_drivebase_stop_force(pbio_drivebase_t *db) {
     return pbio_servo_stop_force(db->right);
 }
 
-pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db) {
+static pbio_error_t drivebase_update(pbio_drivebase_t *db) {
     // Get the physical state
     int32_t time_now, sum, sum_rate, dif, dif_rate;
     pbio_error_t err = drivebase_get_state(db, &time_now, &sum, &sum_rate, &dif, &dif_rate);
@@ -320,7 +333,7 @@ pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db) {
 
     // If passive, log and exit
     if (db->control_heading.type == PBIO_CONTROL_NONE || db->control_distance.type == PBIO_CONTROL_NONE) {
-        return drivebase_log_update(db, time_now, sum, sum_rate, 0, dif, dif_rate, 0);
+        return drivebase_log_update(db, time_now, sum, sum_rate, 0, dif, dif_rate, 0, false);
     }
 
     // Get control signals
@@ -328,6 +341,8 @@ pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db) {
     pbio_actuation_t sum_actuation, dif_actuation;
     control_update(&db->control_distance, time_now, sum, sum_rate, &sum_actuation, &sum_control);
     control_update(&db->control_heading, time_now, dif, dif_rate, &dif_actuation, &dif_control);
+    _pbio_record_output(PBIO_RECORD_CHANNEL_DRIVEBASE, 0, sum_actuation, sum_control);
+    _pbio_record_output(PBIO_RECORD_CHANNEL_DRIVEBASE, 1, dif_actuation, dif_control);
 
     // Separate actuation types are not possible for now
     if (sum_actuation != dif_actuation) {
@@ -339,7 +354,17 @@ pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db) {
     if (err != PBIO_SUCCESS) {
         return err;
     }
-    return drivebase_log_update(db, time_now, sum, sum_rate, sum_control, dif, dif_rate, dif_control);
+    return drivebase_log_update(db, time_now, sum, sum_rate, sum_control, dif, dif_rate, dif_control, true);
+}
+
+pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db) {
+    pbio_control_t *ctl[] = { &db->control_distance, &db->control_heading };
+
+    _pbio_record_begin(PBIO_RECORD_CHANNEL_DRIVEBASE, ctl, 2);
+    pbio_error_t err = drivebase_update(db);
+    _pbio_record_end(PBIO_RECORD_CHANNEL_DRIVEBASE, ctl, 2);
+
+    return err;
 }
 
 pbio_error_t pbio_drivebase_straight(pbio_drivebase_t *db, int32_t distance, int32_t drive_speed, int32_t drive_acceleration) {
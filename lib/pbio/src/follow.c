@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <fixmath.h>
+
+#include <pbio/follow.h>
+#include <pbio/math.h>
+
+/* Reference of a servo that follows the position of another servo */
+
+// Get the follower reference for the given leader count and rate
+void pbio_follow_get_reference(pbio_follow_t *f, int32_t leader_count, int32_t leader_rate, int32_t *count, int32_t *count_ext, int32_t *rate) {
+
+    // Geared position in millicounts, and rate
+    int64_t product = ((int64_t) leader_count) * f->ratio;
+    int64_t mcount = ((int64_t) f->offset) * 1000 + (product >> 16) * 1000 + (((product & 0xFFFF) * 1000) >> 16);
+    *rate = pbio_math_mul_i32_fix16(leader_rate, f->ratio);
+
+    // Add the cam profile, interpolated linearly between its points
+    if (f->cam_size > 0) {
+        int32_t phase = leader_count % f->cam_period;
+        if (phase < 0) {
+            phase += f->cam_period;
+        }
+        int64_t position = ((int64_t) phase) * f->cam_size;
+        int32_t i = position / f->cam_period;
+        int32_t remainder = position - ((int64_t) i) * f->cam_period;
+        int32_t rise = f->cam[(i + 1) % f->cam_size] - f->cam[i];
+
+        mcount += ((int64_t) f->cam[i]) * 1000 + (((int64_t) rise) * 1000 * remainder) / f->cam_period;
+        *rate += (((int64_t) rise) * f->cam_size * leader_rate) / f->cam_period;
+    }
+
+    *count = mcount / 1000;
+    *count_ext = mcount - ((int64_t) *count) * 1000;
+}
+
+// Shift the offset so that the follower reference is at the given count for
+// the given leader count, so the follower does not jump when it starts
+void pbio_follow_set_relative(pbio_follow_t *f, int32_t leader_count, int32_t count_now) {
+    int32_t count, count_ext, rate;
+    pbio_follow_get_reference(f, leader_count, 0, &count, &count_ext, &rate);
+    f->offset += count_now - count;
+}
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/error.h>
+#include <pbio/i2c.h>
+
+void pbio_i2c_dev_init(pbio_i2c_dev_t *dev, pbio_i2c_transfer_t transfer, void *context, uint8_t address) {
+    dev->transfer = transfer;
+    dev->context = context;
+    dev->address = address;
+    dev->num_cached = 0;
+}
+
+/**
+ * Marks a block of registers as read-only, so that it is read from the
+ * device only once. Later reads of the same block or a part of it return
+ * the stored values.
+ * @param [in]  dev         The device
+ * @param [in]  reg         First register of the block
+ * @param [in]  len         Number of registers in the block
+ * @return                  ::PBIO_SUCCESS, ::PBIO_ERROR_INVALID_ARG if the
+ *                          block is too long, or ::PBIO_ERROR_INVALID_OP if
+ *                          too many blocks are cached already
+ */
+pbio_error_t pbio_i2c_dev_set_cached(pbio_i2c_dev_t *dev, uint8_t reg, uint8_t len) {
+    if (len == 0 || len > PBIO_I2C_MAX_DATA || reg + len > UINT8_MAX + 1) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Nothing to do if this block is cached already
+    for (uint32_t i = 0; i < dev->num_cached; i++) {
+        if (dev->cache[i].reg == reg && dev->cache[i].len == len) {
+            return PBIO_SUCCESS;
+        }
+    }
+
+    if (dev->num_cached == PBIO_I2C_CACHE_SIZE) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    pbio_i2c_cache_entry_t *entry = &dev->cache[dev->num_cached++];
+    entry->reg = reg;
+    entry->len = len;
+    entry->valid = false;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Clears the cached values of a range of registers, for example because they
+ * were written to. They are read from the device again the next time.
+ * @param [in]  dev         The device
+ * @param [in]  reg         First register of the range
+ * @param [in]  len         Number of registers in the range
+ */
+void pbio_i2c_dev_invalidate(pbio_i2c_dev_t *dev, uint8_t reg, uint8_t len) {
+    for (uint32_t i = 0; i < dev->num_cached; i++) {
+        pbio_i2c_cache_entry_t *entry = &dev->cache[i];
+        if (reg < entry->reg + entry->len && reg + len > entry->reg) {
+            entry->valid = false;
+        }
+    }
+}
+
+void pbio_i2c_batch_init(pbio_i2c_batch_t *batch, pbio_i2c_dev_t *dev) {
+    batch->dev = dev;
+    batch->num_msgs = 0;
+    batch->data_len = 0;
+}
+
+static pbio_i2c_msg_t *add_msg(pbio_i2c_batch_t *batch, uint8_t flags, uint8_t *buf, uint16_t len) {
+    pbio_i2c_msg_t *msg = &batch->msgs[batch->num_msgs];
+    msg->address = batch->dev->address;
+    msg->flags = flags;
+    msg->len = len;
+    msg->buf = buf;
+    batch->fill[batch->num_msgs] = NULL;
+    batch->num_msgs++;
+    return msg;
+}
+
+/**
+ * Adds a register read to the batch. The data is in buf after the batch was
+ * submitted successfully, or right away if the registers are cached.
+ * @param [in]  batch       The batch
+ * @param [in]  reg         First register to read
+ * @param [out] buf         Buffer for the register values
+ * @param [in]  len         Number of registers to read
+ * @return                  ::PBIO_SUCCESS or ::PBIO_ERROR_INVALID_ARG if the
+ *                          read is too long or the batch is full
+ */
+pbio_error_t pbio_i2c_batch_read(pbio_i2c_batch_t *batch, uint8_t reg, uint8_t *buf, uint8_t len) {
+    pbio_i2c_dev_t *dev = batch->dev;
+
+    if (len == 0 || len > PBIO_I2C_MAX_DATA) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Look for a cached block that has these registers
+    pbio_i2c_cache_entry_t *fill = NULL;
+    for (uint32_t i = 0; i < dev->num_cached; i++) {
+        pbio_i2c_cache_entry_t *entry = &dev->cache[i];
+        if (reg < entry->reg || reg + len > entry->reg + entry->len) {
+            continue;
+        }
+        if (entry->valid) {
+            memcpy(buf, &entry->data[reg - entry->reg], len);
+            return PBIO_SUCCESS;
+        }
+        if (reg == entry->reg && len == entry->len) {
+            fill = entry;
+        }
+    }
+
+    if (batch->num_msgs + 2 > PBIO_I2C_MAX_MSGS || batch->data_len + 1 > PBIO_I2C_BATCH_DATA_SIZE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    uint8_t *reg_buf = &batch->data[batch->data_len++];
+    *reg_buf = reg;
+    add_msg(batch, 0, reg_buf, 1);
+    add_msg(batch, PBIO_I2C_MSG_READ, buf, len);
+    batch->fill[batch->num_msgs - 1] = fill;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Adds a register write to the batch. The data is copied, so buf may be
+ * reused before the batch is submitted.
+ * @param [in]  batch       The batch
+ * @param [in]  reg         First register to write
+ * @param [in]  buf         Register values
+ * @param [in]  len         Number of registers to write
+ * @return                  ::PBIO_SUCCESS or ::PBIO_ERROR_INVALID_ARG if the
+ *                          write is too long or the batch is full
+ */
+pbio_error_t pbio_i2c_batch_write(pbio_i2c_batch_t *batch, uint8_t reg, const uint8_t *buf, uint8_t len) {
+    pbio_i2c_dev_t *dev = batch->dev;
+
+    if (len > PBIO_I2C_MAX_DATA) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (batch->num_msgs + 1 > PBIO_I2C_MAX_MSGS || batch->data_len + 1 + len > PBIO_I2C_BATCH_DATA_SIZE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Registers that are written are not read-only after all, so stop caching them
+    pbio_i2c_dev_invalidate(dev, reg, len);
+
+    // Earlier reads in this batch see the old values, so they must not be
+    // used to fill the cache either
+    for (uint32_t i = 0; i < batch->num_msgs; i++) {
+        pbio_i2c_cache_entry_t *entry = batch->fill[i];
+        if (entry && reg < entry->reg + entry->len && reg + len > entry->reg) {
+            batch->fill[i] = NULL;
+        }
+    }
+
+    uint8_t *msg_buf = &batch->data[batch->data_len];
+    msg_buf[0] = reg;
+    memcpy(&msg_buf[1], buf, len);
+    batch->data_len += 1 + len;
+    add_msg(batch, 0, msg_buf, 1 + len);
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Performs all reads and writes of the batch as one transaction and empties
+ * the batch.
+ * @param [in]  batch       The batch
+ * @return                  ::PBIO_SUCCESS or any error from the bus backend
+ */
+pbio_error_t pbio_i2c_batch_submit(pbio_i2c_batch_t *batch) {
+    pbio_i2c_dev_t *dev = batch->dev;
+
+    // Everything may have come from the cache
+    if (batch->num_msgs == 0) {
+        return PBIO_SUCCESS;
+    }
+
+    pbio_error_t err = dev->transfer(dev->context, batch->msgs, batch->num_msgs);
+
+    if (err == PBIO_SUCCESS) {
+        for (uint32_t i = 0; i < batch->num_msgs; i++) {
+            pbio_i2c_cache_entry_t *entry = batch->fill[i];
+            if (entry) {
+                memcpy(entry->data, batch->msgs[i].buf, entry->len);
+                entry->valid = true;
+            }
+        }
+    }
+
+    batch->num_msgs = 0;
+    batch->data_len = 0;
+    return err;
+}
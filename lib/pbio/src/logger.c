@@ -1,12 +1,12 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2018-2020 The Pybricks Authors
 
-#include <stdlib.h>
 #include <stdbool.h>
 #include <inttypes.h>
 
 #include <contiki.h>
 
+#include <pbio/arena.h>
 #include <pbio/config.h>
 #include <pbio/error.h>
 #include <pbio/logger.h>
@@ -14,7 +14,7 @@
 static void pbio_logger_delete(pbio_log_t *log) {
     // Free log if any
     if (log->len > 0) {
-        free(log->data);
+        pbio_arena_free(log->data);
     }
     log->sampled = 0;
     log->skipped = 0;
@@ -38,7 +38,7 @@ pbio_error_t pbio_logger_start(pbio_log_t *log, int32_t duration, int32_t div) {
     }
 
     // Allocate memory for the logs
-    log->data = malloc(len * log->num_values * sizeof(int32_t));
+    log->data = pbio_arena_alloc(len * log->num_values * sizeof(int32_t));
     if (log->data == NULL) {
         return PBIO_ERROR_FAILED;
     }
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/config.h>
+#include <pbio/loopstats.h>
+
+void pbio_loopstats_clear(pbio_loopstats_t *stats) {
+    *stats = (pbio_loopstats_t) {
+        .min = UINT32_MAX,
+    };
+}
+
+void pbio_loopstats_add(pbio_loopstats_t *stats, uint32_t value) {
+
+    stats->count++;
+    stats->total += value;
+
+    if (value < stats->min) {
+        stats->min = value;
+    }
+    if (value > stats->max) {
+        stats->max = value;
+    }
+
+    // Bin index is the position of the most significant bit, so that
+    // microsecond execution times and millisecond periods both fit.
+    int32_t bin = 0;
+    while ((value >>= 1) != 0 && bin < PBIO_LOOPSTATS_NUM_BINS - 1) {
+        bin++;
+    }
+    stats->bins[bin]++;
+}
+
+uint32_t pbio_loopstats_get_mean(const pbio_loopstats_t *stats) {
+    if (stats->count == 0) {
+        return 0;
+    }
+    return stats->total / stats->count;
+}
+
+#if PBIO_CONFIG_LOOPSTATS
+
+static pbio_loopstats_t loopstats[PBIO_LOOPSTATS_NUM];
+static uint32_t overruns;
+
+static uint32_t prev_tick_time;
+static bool prev_tick_valid;
+
+const pbio_loopstats_t *pbio_loopstats_get(pbio_loopstats_part_t part) {
+    return &loopstats[part];
+}
+
+uint32_t pbio_loopstats_get_overruns(void) {
+    return overruns;
+}
+
+void pbio_loopstats_reset(void) {
+    for (int i = 0; i < PBIO_LOOPSTATS_NUM; i++) {
+        pbio_loopstats_clear(&loopstats[i]);
+    }
+    overruns = 0;
+    prev_tick_valid = false;
+}
+
+// Called at the start of each control loop tick
+void _pbio_loopstats_tick(uint32_t time_now) {
+
+    if (prev_tick_valid) {
+        // Unsigned difference is correct across wraparound of the clock
+        uint32_t period = time_now - prev_tick_time;
+        pbio_loopstats_add(&loopstats[PBIO_LOOPSTATS_PERIOD], period);
+
+        // If the loop was not reached in time, one or more ticks were missed
+        uint32_t ticks = period / (PBIO_CONFIG_SERVO_PERIOD_MS * 1000);
+        if (ticks > 1) {
+            overruns += ticks - 1;
+        }
+    }
+    prev_tick_time = time_now;
+    prev_tick_valid = true;
+}
+
+// Records the execution time of one part of the event loop
+void _pbio_loopstats_record(pbio_loopstats_part_t part, uint32_t time_start, uint32_t time_end) {
+    pbio_loopstats_add(&loopstats[part], time_end - time_start);
+}
+
+#endif // PBIO_CONFIG_LOOPSTATS
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/error.h>
+#include <pbio/mailbox.h>
+
+static uint16_t get_uint16_le(const uint8_t *buf) {
+    return buf[0] | buf[1] << 8;
+}
+
+static void set_uint16_le(uint8_t *buf, uint16_t value) {
+    buf[0] = value;
+    buf[1] = value >> 8;
+}
+
+/**
+ * Encodes a message for a mailbox.
+ * @param [out] buf         Buffer for the message
+ * @param [in]  size        Size of the buffer
+ * @param [in]  name        Name of the mailbox
+ * @param [in]  name_len    Length of the name, without terminator
+ * @param [in]  payload     Payload data
+ * @param [in]  payload_len Size of the payload
+ * @param [out] msg_len     Total size of the message
+ * @return                  ::PBIO_SUCCESS on success, ::PBIO_ERROR_INVALID_ARG
+ *                          if the name or payload is too long, or if the
+ *                          message does not fit in the buffer.
+ */
+pbio_error_t pbio_mailbox_encode(uint8_t *buf, size_t size, const char *name, size_t name_len,
+    const uint8_t *payload, size_t payload_len, size_t *msg_len) {
+
+    if (name_len + 1 > UINT8_MAX || payload_len > UINT16_MAX) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    size_t len = PBIO_MAILBOX_HEADER_SIZE + name_len + 1 + payload_len;
+    if (len > PBIO_MAILBOX_MAX_SIZE || len > size) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    set_uint16_le(&buf[0], len - 2);
+    set_uint16_le(&buf[2], 1);
+    buf[4] = PBIO_MAILBOX_SYSTEM_COMMAND_NO_REPLY;
+    buf[5] = PBIO_MAILBOX_WRITEMAILBOX;
+    buf[6] = name_len + 1;
+    memcpy(&buf[7], name, name_len);
+    buf[7 + name_len] = '\0';
+    set_uint16_le(&buf[8 + name_len], payload_len);
+    memcpy(&buf[10 + name_len], payload, payload_len);
+
+    *msg_len = len;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Initializes a message decoder.
+ * @param [in]  dec         The decoder
+ * @param [in]  buf         Buffer for received data
+ * @param [in]  size        Size of the buffer. Messages that don't fit are
+ *                          treated as errors. Use ::PBIO_MAILBOX_MAX_SIZE to
+ *                          accept any message.
+ */
+void pbio_mailbox_decoder_init(pbio_mailbox_decoder_t *dec, uint8_t *buf, size_t size) {
+    dec->buf = buf;
+    dec->size = size;
+    dec->len = 0;
+    dec->done = 0;
+}
+
+// Discards the message that was returned last
+static void pbio_mailbox_decoder_discard(pbio_mailbox_decoder_t *dec) {
+    if (dec->done) {
+        dec->len -= dec->done;
+        memmove(dec->buf, &dec->buf[dec->done], dec->len);
+        dec->done = 0;
+    }
+}
+
+/**
+ * Gets the free space for receiving data. After writing to it, call
+ * pbio_mailbox_decoder_commit().
+ * @param [in]  dec         The decoder
+ * @param [out] space       Number of bytes that can be written
+ * @return                  Where to write received data
+ */
+uint8_t *pbio_mailbox_decoder_get_space(pbio_mailbox_decoder_t *dec, size_t *space) {
+    pbio_mailbox_decoder_discard(dec);
+    *space = dec->size - dec->len;
+    return &dec->buf[dec->len];
+}
+
+/**
+ * Adds received data to the decoder.
+ * @param [in]  dec         The decoder
+ * @param [in]  count       Number of bytes written to the free space
+ */
+void pbio_mailbox_decoder_commit(pbio_mailbox_decoder_t *dec, size_t count) {
+    dec->len += count;
+}
+
+/**
+ * Gets the next complete message from the received data.
+ * @param [in]  dec         The decoder
+ * @param [out] msg         The message
+ * @return                  ::PBIO_SUCCESS if a message was decoded,
+ *                          ::PBIO_ERROR_AGAIN if more data is needed, or
+ *                          ::PBIO_ERROR_IO if the data is not a valid
+ *                          mailbox message. After an error, the rest of the
+ *                          stream can't be decoded.
+ */
+pbio_error_t pbio_mailbox_decoder_next(pbio_mailbox_decoder_t *dec, pbio_mailbox_msg_t *msg) {
+    pbio_mailbox_decoder_discard(dec);
+
+    if (dec->len < 2) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    size_t len = 2 + get_uint16_le(dec->buf);
+    if (len > dec->size) {
+        return PBIO_ERROR_IO;
+    }
+    if (dec->len < len) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    const uint8_t *data = dec->buf;
+    if (len < PBIO_MAILBOX_HEADER_SIZE ||
+        data[4] != PBIO_MAILBOX_SYSTEM_COMMAND_NO_REPLY ||
+        data[5] != PBIO_MAILBOX_WRITEMAILBOX) {
+        return PBIO_ERROR_IO;
+    }
+
+    size_t name_size = data[6];
+    if (PBIO_MAILBOX_HEADER_SIZE + name_size > len) {
+        return PBIO_ERROR_IO;
+    }
+
+    size_t payload_len = get_uint16_le(&data[7 + name_size]);
+    if (PBIO_MAILBOX_HEADER_SIZE + name_size + payload_len > len) {
+        return PBIO_ERROR_IO;
+    }
+
+    // The name is zero-terminated, but be lenient like the EV3 firmware
+    msg->name = (const char *)&data[7];
+    msg->name_len = name_size;
+    while (msg->name_len > 0 && msg->name[msg->name_len - 1] == '\0') {
+        msg->name_len--;
+    }
+    msg->payload = &data[9 + name_size];
+    msg->payload_len = payload_len;
+
+    dec->done = len;
+    return PBIO_SUCCESS;
+}
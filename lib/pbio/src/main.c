@@ -15,8 +15,11 @@
 #include "pbdrv/light.h"
 #include "pbdrv/motor.h"
 #include "pbsys/sys.h"
+#include "pbio/battery.h"
 #include "pbio/config.h"
+#include "pbio/loopstats.h"
 #include "pbio/motorpoll.h"
+#include "pbio/trace.h"
 #include "pbio/uartdev.h"
 
 #include "processes.h"
@@ -39,9 +42,6 @@ AUTOSTART_PROCESSES(
 #if PBDRV_CONFIG_COUNTER
     ,&pbdrv_counter_process
 #endif
-#if PBDRV_CONFIG_IOPORT_EV3DEV_STRETCH
-    ,&pbdrv_ioport_ev3dev_stretch_process
-#endif
 #if PBDRV_CONFIG_IOPORT_LPF2
     ,&pbdrv_ioport_lpf2_process
 #endif
@@ -68,7 +68,9 @@ void pbio_init(void) {
     _pbdrv_light_init();
     autostart_start(autostart_processes);
     _pbdrv_motor_init();
+    _pbio_battery_reset();
     _pbio_motorpoll_reset_all();
+    pbio_loopstats_reset();
 }
 
 /**
@@ -84,14 +86,26 @@ int pbio_do_one_event(void) {
     // don't want to call all of the subroutines unless enough time has
     // actually elapsed to do something useful.
     if (now - prev_fast_poll_time >= clock_from_msec(PBIO_CONFIG_SERVO_PERIOD_MS)) {
+        unsigned long trace_start = pbio_trace_now();
+        _pbio_loopstats_tick(_pbio_loopstats_now());
         _pbio_motorpoll_poll();
+        pbio_trace_record(PBIO_TRACE_MOTORPOLL, trace_start);
         prev_fast_poll_time = clock_time();
     }
     if (now - prev_slow_poll_time >= clock_from_msec(32)) {
+        unsigned long trace_start = pbio_trace_now();
         _pbio_light_poll(now);
+        _pbio_battery_poll(now);
+        pbio_trace_record(PBIO_TRACE_LIGHTPOLL, trace_start);
         prev_slow_poll_time = now;
     }
-    return process_run();
+
+    // Handles polls and events of high priority processes such as the
+    // counter and UART device drivers before all other processes.
+    uint32_t process_start = _pbio_loopstats_now();
+    int pending = process_run();
+    _pbio_loopstats_record(PBIO_LOOPSTATS_PROCESS, process_start, _pbio_loopstats_now());
+    return pending;
 }
 
 #if PBIO_CONFIG_ENABLE_DEINIT
@@ -102,6 +116,10 @@ int pbio_do_one_event(void) {
  */
 void pbio_deinit(void) {
     autostart_exit(autostart_processes);
+#if PBDRV_CONFIG_IOPORT_EV3DEV_STRETCH
+    // Not autostarted, see pbdrv_ioport_ev3dev_get_syspath()
+    process_exit(&pbdrv_ioport_ev3dev_stretch_process);
+#endif
     _pbdrv_motor_deinit();
     _pbdrv_light_deinit();
     _pbdrv_button_deinit();
@@ -5,6 +5,8 @@
 #include <inttypes.h>
 #include <fixmath.h>
 
+#include <pbio/math.h>
+
 int32_t pbio_math_sign(int32_t a) {
     if (a == 0) {
         return 0;
@@ -31,18 +33,143 @@ int32_t pbio_math_div_i32_fix16(int32_t a, fix16_t b) {
     return pbio_math_mul_i32_fix16(a, fix16_div(fix16_one, b));
 }
 
+// Integer square root, rounded down. This computes one bit of the result at a
+// time, using only shifts and additions.
 int32_t pbio_math_sqrt(int32_t n) {
     if (n <= 0) {
         return 0;
     }
-    int32_t x0 = n;
-    int32_t x1 = x0;
+    uint32_t rem = n;
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    // Start at the highest power of four that is not bigger than n
+    while (bit > rem) {
+        bit >>= 2;
+    }
 
-    while (true) {
-        x1 = (x0 + n/x0)/2;
-        if (x1 == x0 || x1 == x0 + 1) {
-            return x0;
+    while (bit != 0) {
+        if (rem >= root + bit) {
+            rem -= root + bit;
+            root = (root >> 1) + bit;
         }
-        x0 = x1;
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Set scaling factor and cache its reciprocal
+void pbio_math_scale_set(pbio_math_scale_t *s, fix16_t scale) {
+    s->scale = scale;
+    s->inverse = fix16_div(fix16_one, scale);
+}
+
+// Multiply by the scaling factor. Same as pbio_math_mul_i32_fix16(a, s->scale).
+int32_t pbio_math_scale_mul(const pbio_math_scale_t *s, int32_t a) {
+    return pbio_math_mul_i32_fix16(a, s->scale);
+}
+
+// Divide by the scaling factor. Same as pbio_math_div_i32_fix16(a, s->scale).
+int32_t pbio_math_scale_div(const pbio_math_scale_t *s, int32_t a) {
+    if (s->scale == fix16_one) {
+        return a;
+    }
+    return pbio_math_mul_i32_fix16(a, s->inverse);
+}
+
+// sin(x) for x = 0, 1, ..., 90 degrees
+static const int32_t sin_table[] = {
+    0, 1144, 2287, 3430, 4572, 5712, 6850, 7987,
+    9121, 10252, 11380, 12505, 13626, 14742, 15855, 16962,
+    18064, 19161, 20252, 21336, 22415, 23486, 24550, 25607,
+    26656, 27697, 28729, 29753, 30767, 31772, 32768, 33754,
+    34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+    42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930,
+    48703, 49461, 50203, 50931, 51643, 52339, 53020, 53684,
+    54332, 54963, 55578, 56175, 56756, 57319, 57865, 58393,
+    58903, 59396, 59870, 60326, 60764, 61183, 61584, 61966,
+    62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+    64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446,
+    65496, 65526, 65536,
+};
+
+// atan(x) in degrees for x = 0, 1/64, 2/64, ..., 1
+static const int32_t atan_table[] = {
+    0, 58666, 117304, 175884, 234379, 292760,
+    350999, 409070, 466945, 524598, 582003, 639135,
+    695970, 752484, 808654, 864460, 919879, 974893,
+    1029481, 1083627, 1137313, 1190524, 1243245, 1295461,
+    1347161, 1398332, 1448965, 1499049, 1548575, 1597536,
+    1645926, 1693738, 1740967, 1787610, 1833663, 1879123,
+    1923990, 1968261, 2011937, 2055018, 2097505, 2139399,
+    2180703, 2221419, 2261551, 2301101, 2340074, 2378474,
+    2416306, 2453574, 2490285, 2526443, 2562055, 2597126,
+    2631664, 2665673, 2699161, 2732134, 2764600, 2796564,
+    2828035, 2859019, 2889523, 2919554, 2949120,
+};
+
+// Linear interpolation in a table, where frac is the position between entries i and i+1 in units of 2^shift.
+static int32_t interpolate(const int32_t *table, uint32_t i, uint32_t frac, uint8_t shift) {
+    return table[i] + (((table[i + 1] - table[i]) * (int32_t)frac) >> shift);
+}
+
+// Sine of an angle in degrees, both as fix16
+fix16_t pbio_math_sin_deg(fix16_t angle) {
+    // Reduce angle to the range [0, 360) degrees
+    angle %= F16C(360, 0);
+    if (angle < 0) {
+        angle += F16C(360, 0);
+    }
+
+    // Get the value in the first quadrant by symmetry
+    bool negate = angle >= F16C(180, 0);
+    if (negate) {
+        angle -= F16C(180, 0);
+    }
+    if (angle > F16C(90, 0)) {
+        angle = F16C(180, 0) - angle;
+    }
+
+    // Interpolate between whole degrees
+    if (angle == F16C(90, 0)) {
+        return negate ? -fix16_one : fix16_one;
+    }
+    fix16_t value = interpolate(sin_table, angle >> 16, angle & 0xFFFF, 16);
+    return negate ? -value : value;
+}
+
+// Cosine of an angle in degrees, both as fix16
+fix16_t pbio_math_cos_deg(fix16_t angle) {
+    // Shift by 90 degrees, reduced first so this cannot overflow
+    return pbio_math_sin_deg((angle % F16C(360, 0)) + F16C(90, 0));
+}
+
+// Angle in degrees (fix16) of the vector (x, y), in the range (-180, 180]
+fix16_t pbio_math_atan2_deg(int32_t y, int32_t x) {
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+    uint32_t abs_x = x < 0 ? -(uint32_t)x : x;
+    uint32_t abs_y = y < 0 ? -(uint32_t)y : y;
+
+    // Get angle in the first octant, where the ratio is at most one
+    bool swap = abs_y > abs_x;
+    uint32_t ratio = swap ?
+        (((uint64_t)abs_x) << 16) / abs_y :
+        (((uint64_t)abs_y) << 16) / abs_x;
+    fix16_t angle = ratio == fix16_one ?
+        atan_table[64] :
+        interpolate(atan_table, ratio >> 10, ratio & 0x3FF, 10);
+
+    // Map to the other octants by symmetry
+    if (swap) {
+        angle = F16C(90, 0) - angle;
+    }
+    if (x < 0) {
+        angle = F16C(180, 0) - angle;
     }
+    return y < 0 ? -angle : angle;
 }
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdlib.h>
+
+#include <contiki.h>
+
+#include <pbio/control.h>
+#include <pbio/motiongroup.h>
+#include <pbio/servo.h>
+#include <pbio/trajectory.h>
+
+#if PBDRV_CONFIG_NUM_MOTOR_CONTROLLER != 0
+
+pbio_error_t pbio_motiongroup_setup(pbio_motiongroup_t *group, pbio_servo_t **axes, uint8_t num_axes) {
+
+    if (num_axes < 1 || num_axes > PBDRV_CONFIG_NUM_MOTOR_CONTROLLER) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Each servo may appear only once
+    for (uint8_t i = 0; i < num_axes; i++) {
+        for (uint8_t j = 0; j < i; j++) {
+            if (axes[i] == axes[j]) {
+                return PBIO_ERROR_INVALID_ARG;
+            }
+        }
+        group->axes[i] = axes[i];
+    }
+    group->num_axes = num_axes;
+    group->active = false;
+
+    return PBIO_SUCCESS;
+}
+
+// Stop synchronizing the servos. This does not stop the servos themselves.
+void pbio_motiongroup_release(pbio_motiongroup_t *group) {
+    group->active = false;
+    group->num_axes = 0;
+}
+
+// Get the count from which a servo starts its part of the maneuver
+static pbio_error_t motiongroup_get_start(pbio_servo_t *srv, int32_t time_now, int32_t *count, int32_t *count_ext) {
+
+    // If no control is active, start from the physical count
+    if (srv->control.type == PBIO_CONTROL_NONE) {
+        *count_ext = 0;
+        return pbio_tacho_get_count(srv->tacho, count);
+    }
+
+    // Otherwise start from the current reference
+    int32_t time_ref = pbio_control_get_ref_time(&srv->control, time_now);
+    int32_t unused;
+    pbio_trajectory_get_reference(&srv->control.trajectory, time_ref, count, count_ext, &unused, &unused);
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbio_motiongroup_run_target(pbio_motiongroup_t *group, int32_t speed, const int32_t *targets, pbio_actuation_t after_stop) {
+
+    pbio_error_t err;
+
+    int32_t count_start[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    int32_t count_start_ext[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    int32_t target_count[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    int64_t mlength[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER] = { 0 };
+
+    int32_t time_now = clock_usecs();
+
+    // Get the start and end point of each axis, and find the one that travels farthest
+    uint8_t longest = 0;
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_servo_t *srv = group->axes[i];
+
+        // Return if this servo is already in use by higher level entity
+        if (srv->claimed) {
+            return PBIO_ERROR_INVALID_OP;
+        }
+
+        err = motiongroup_get_start(srv, time_now, &count_start[i], &count_start_ext[i]);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        target_count[i] = pbio_control_user_to_counts(&srv->control.settings, targets[i]);
+
+        // Millicounts to travel
+        mlength[i] = ((int64_t) target_count[i])*1000 - (((int64_t) count_start[i])*1000 + count_start_ext[i]);
+        mlength[i] = mlength[i] < 0 ? -mlength[i] : mlength[i];
+        if (mlength[i] > mlength[longest]) {
+            longest = i;
+        }
+    }
+
+    // If no axis has to move, just hold the targets
+    if (mlength[longest] == 0) {
+        group->active = false;
+        for (uint8_t i = 0; i < group->num_axes; i++) {
+            err = pbio_control_start_hold_control(&group->axes[i]->control, time_now, target_count[i]);
+            if (err != PBIO_SUCCESS) {
+                return err;
+            }
+        }
+        return PBIO_SUCCESS;
+    }
+
+    // The master trajectory travels as far as the longest axis, rounded up to
+    // whole counts. All axes move a fraction of this, so the speed and
+    // acceleration limits of the master are those of the most restrictive axis.
+    int32_t master_length = (mlength[longest] + 999) / 1000;
+    int64_t max_rate = INT32_MAX;
+    int64_t max_acceleration = INT32_MAX;
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        if (mlength[i] == 0) {
+            continue;
+        }
+        pbio_control_settings_t *s = &group->axes[i]->control.settings;
+        max_rate = min(max_rate, (((int64_t) s->max_rate) * master_length * 1000) / mlength[i]);
+        max_acceleration = min(max_acceleration, (((int64_t) s->abs_acceleration) * master_length * 1000) / mlength[i]);
+    }
+
+    // The speed is given for the axis that travels farthest
+    int32_t target_rate = abs(pbio_control_user_to_counts(&group->axes[longest]->control.settings, speed));
+
+    // Make the master trajectory, starting from standstill
+    pbio_trajectory_t master;
+    err = pbio_trajectory_make_angle_based(&master, time_now, 0, 0, master_length, 0, target_rate, max_rate, max_acceleration, max_acceleration);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Start each axis along a scaled version of the master trajectory
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        err = pbio_control_start_synchronized_angle_control(&group->axes[i]->control, &master, count_start[i], count_start_ext[i], target_count[i], after_stop);
+        if (err != PBIO_SUCCESS) {
+            group->active = false;
+            return err;
+        }
+    }
+    group->t0 = master.t0;
+    group->active = true;
+
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t pbio_motiongroup_stop(pbio_motiongroup_t *group, pbio_actuation_t after_stop) {
+    group->active = false;
+
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_error_t err = pbio_servo_stop(group->axes[i], after_stop);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+    return PBIO_SUCCESS;
+}
+
+bool pbio_motiongroup_is_done(pbio_motiongroup_t *group) {
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        if (!pbio_control_is_done(&group->axes[i]->control)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Keep the reference time of all axes the same. Each servo pauses its own
+// trajectory when it falls behind, for example because it is blocked. All
+// other axes must then wait too, to stay on the straight path. This is called
+// after the servos have been updated, in the same control loop iteration.
+pbio_error_t pbio_motiongroup_update(pbio_motiongroup_t *group) {
+
+    if (!group->active) {
+        return PBIO_SUCCESS;
+    }
+
+    // Stop synchronizing once an axis was given another command
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_control_t *ctl = &group->axes[i]->control;
+        if (ctl->type != PBIO_CONTROL_ANGLE || ctl->trajectory.t0 != group->t0) {
+            group->active = false;
+            return PBIO_SUCCESS;
+        }
+    }
+
+    // Find the axis that lags behind most
+    int32_t time_now = clock_usecs();
+    pbio_count_integrator_t *slowest = &group->axes[0]->control.count_integrator;
+    int32_t time_ref_min = pbio_count_integrator_get_ref_time(slowest, time_now);
+    for (uint8_t i = 1; i < group->num_axes; i++) {
+        pbio_count_integrator_t *itg = &group->axes[i]->control.count_integrator;
+        int32_t time_ref = pbio_count_integrator_get_ref_time(itg, time_now);
+        if (time_ref - time_ref_min < 0) {
+            slowest = itg;
+            time_ref_min = time_ref;
+        }
+    }
+
+    // Let all other axes follow its reference time
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_count_integrator_t *itg = &group->axes[i]->control.count_integrator;
+        itg->trajectory_running = slowest->trajectory_running;
+        itg->time_pause_begin = slowest->time_pause_begin;
+        itg->time_paused_total = slowest->time_paused_total;
+    }
+
+    // Synchronization ends when the maneuver is complete
+    if (time_ref_min - group->axes[0]->control.trajectory.t3 > 0) {
+        group->active = false;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+#endif // PBDRV_CONFIG_NUM_MOTOR_CONTROLLER
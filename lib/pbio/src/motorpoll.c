@@ -3,6 +3,8 @@
 
 #include <pbio/control.h>
 #include <pbio/drivebase.h>
+#include <pbio/loopstats.h>
+#include <pbio/motiongroup.h>
 #include <pbio/motorpoll.h>
 #include <pbio/servo.h>
 
@@ -14,6 +16,9 @@ static pbio_error_t servo_err[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
 static pbio_drivebase_t drivebase;
 static pbio_error_t drivebase_err;
 
+static pbio_motiongroup_t motiongroup;
+static pbio_error_t motiongroup_err;
+
 // Get pointer to servo by port index
 pbio_error_t pbio_motorpoll_get_servo(pbio_port_t port, pbio_servo_t **srv) {
 
@@ -71,6 +76,29 @@ pbio_error_t pbio_motorpoll_get_drivebase_status(pbio_drivebase_t *db) {
     return drivebase_err;
 }
 
+// Get pointer to motion group
+pbio_error_t pbio_motorpoll_get_motiongroup(pbio_motiongroup_t **group) {
+    // Get pointer to device (at the moment, there is only one motion group)
+    *group = &motiongroup;
+    return PBIO_SUCCESS;
+}
+
+// Set status of the motion group, which tells us whether to poll or not
+pbio_error_t pbio_motorpoll_set_motiongroup_status(pbio_motiongroup_t *group, pbio_error_t err) {
+    if (group != &motiongroup) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    motiongroup_err = err;
+    return PBIO_SUCCESS;
+}
+
+// Get status of the motion group, which tells us whether to poll or not
+pbio_error_t pbio_motorpoll_get_motiongroup_status(pbio_motiongroup_t *group) {
+    if (group != &motiongroup) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    return motiongroup_err;
+}
 
 void _pbio_motorpoll_reset_all(void) {
 
@@ -81,6 +109,10 @@ void _pbio_motorpoll_reset_all(void) {
 
     pbio_error_t err;
 
+    // Stop synchronizing servos in the motion group
+    pbio_motiongroup_release(&motiongroup);
+    motiongroup_err = PBIO_SUCCESS;
+
     // Force stop the drivebase
     err = pbio_drivebase_stop_force(&drivebase);
     if (err != PBIO_SUCCESS) {
@@ -99,6 +131,8 @@ void _pbio_motorpoll_reset_all(void) {
 void _pbio_motorpoll_poll(void) {
 
     pbio_error_t err;
+    uint32_t time_start = _pbio_loopstats_now();
+    uint32_t time_end;
 
     // Poll servos
     for (int i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
@@ -110,6 +144,9 @@ void _pbio_motorpoll_poll(void) {
             }
         }
     }
+    time_end = _pbio_loopstats_now();
+    _pbio_loopstats_record(PBIO_LOOPSTATS_SERVO, time_start, time_end);
+    time_start = time_end;
 
     // Poll drivebase again if it says so, and save error if encountered
     if (drivebase_err == PBIO_ERROR_AGAIN) {
@@ -118,6 +155,18 @@ void _pbio_motorpoll_poll(void) {
             drivebase_err = err;
         }
     }
+    time_end = _pbio_loopstats_now();
+    _pbio_loopstats_record(PBIO_LOOPSTATS_DRIVEBASE, time_start, time_end);
+    time_start = time_end;
+
+    // Poll motion group again if it says so, after its servos were updated
+    if (motiongroup_err == PBIO_ERROR_AGAIN) {
+        err = pbio_motiongroup_update(&motiongroup);
+        if (err != PBIO_SUCCESS) {
+            motiongroup_err = err;
+        }
+    }
+    _pbio_loopstats_record(PBIO_LOOPSTATS_MOTIONGROUP, time_start, _pbio_loopstats_now());
 }
 
 #endif // PBDRV_CONFIG_NUM_MOTOR_CONTROLLER
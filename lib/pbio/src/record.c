@@ -0,0 +1,564 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <pbio/config.h>
+
+#if PBIO_CONFIG_RECORD
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/arena.h>
+#include <pbio/control.h>
+#include <pbio/iodev.h>
+#include <pbio/record.h>
+#include <pbio/uartdev.h>
+
+// The stream starts with a header that identifies the format and the memory
+// layout of the controllers. It is followed by records that start with a tag
+// byte holding the record type in the upper 3 bits and the channel in the
+// lower 5 bits. Measured values are stored as zigzag varints relative to the
+// previous values of the same channel, so most of them take a single byte.
+//
+//  UPDATE  tag
+//  CONTROL tag, index, on_target_func id, raw controller bytes
+//  VALUES  tag, count, varint * count
+//  OUTPUT  tag, index, actuation, varint
+//  DATA    tag, mode, size, bytes * size (channel is the sensor index)
+
+#define VERSION (1)
+
+#define TYPE_UPDATE     (1)
+#define TYPE_CONTROL    (2)
+#define TYPE_VALUES     (3)
+#define TYPE_OUTPUT     (4)
+#define TYPE_DATA       (5)
+
+#define TAG(type, channel) ((type) << 5 | (channel))
+#define TAG_TYPE(tag) ((tag) >> 5)
+#define TAG_CHANNEL(tag) ((tag) & 0x1F)
+
+#define NO_CHANNEL (0xFF)
+
+// The controller is copied as raw bytes, except for the on target function
+// pointer, which differs between the brick and the host. The header stores
+// the size of both parts, so that a mismatching layout can be rejected.
+#define BLOCK_A_SIZE (offsetof(pbio_control_t, count_integrator) + sizeof(pbio_count_integrator_t))
+#define BLOCK_B_START (offsetof(pbio_control_t, stalled))
+#define BLOCK_B_SIZE (offsetof(pbio_control_t, state) + sizeof(pbio_control_state_t) - BLOCK_B_START)
+
+#define HEADER_SIZE (9)
+
+typedef enum {
+    MODE_OFF,
+    MODE_RECORD,
+    MODE_REPLAY,
+} record_mode_t;
+
+static record_mode_t mode;
+
+static uint8_t *record_data;
+static uint32_t record_size;
+static const uint8_t *data;
+static uint32_t size;
+static uint32_t pos;
+
+// Start of the record or update that is being written, so that a full buffer
+// never ends with a partial update
+static uint32_t record_start;
+static bool full;
+
+static uint8_t active = NO_CHANNEL;
+static int32_t last_values[PBIO_RECORD_NUM_CHANNELS][PBIO_RECORD_MAX_VALUES];
+static uint32_t control_hash[PBIO_RECORD_NUM_CHANNELS][PBIO_RECORD_MAX_CONTROL];
+static uint32_t mismatches;
+
+static uint8_t on_target_func_to_id(pbio_control_on_target_t func) {
+    if (func == pbio_control_on_target_always) {
+        return 1;
+    }
+    if (func == pbio_control_on_target_never) {
+        return 2;
+    }
+    if (func == pbio_control_on_target_angle) {
+        return 3;
+    }
+    if (func == pbio_control_on_target_time) {
+        return 4;
+    }
+    if (func == pbio_control_on_target_stalled) {
+        return 5;
+    }
+    return 0;
+}
+
+static pbio_control_on_target_t on_target_func_from_id(uint8_t id) {
+    switch (id) {
+        case 1:
+            return pbio_control_on_target_always;
+        case 2:
+            return pbio_control_on_target_never;
+        case 3:
+            return pbio_control_on_target_angle;
+        case 4:
+            return pbio_control_on_target_time;
+        case 5:
+            return pbio_control_on_target_stalled;
+        default:
+            return NULL;
+    }
+}
+
+// FNV-1a, only used to notice that a command changed a controller
+static uint32_t hash_control(const pbio_control_t *ctl) {
+    const uint8_t *bytes = (const uint8_t *)ctl;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(pbio_control_t); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void reset_state(void) {
+    pos = 0;
+    record_start = 0;
+    full = false;
+    active = NO_CHANNEL;
+    mismatches = 0;
+    memset(last_values, 0, sizeof(last_values));
+    memset(control_hash, 0, sizeof(control_hash));
+}
+
+/* Writing */
+
+static void put(const void *bytes, uint32_t len) {
+    if (full) {
+        return;
+    }
+    if (pos + len > size) {
+        // Drop the incomplete record or update and stop recording
+        full = true;
+        pos = record_start;
+        return;
+    }
+    memcpy(&record_data[pos], bytes, len);
+    pos += len;
+}
+
+static void put_byte(uint8_t byte) {
+    put(&byte, 1);
+}
+
+static void put_varint(int32_t value) {
+    uint8_t bytes[5];
+    uint8_t len = 0;
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+    while (zigzag >= 0x80) {
+        bytes[len++] = zigzag | 0x80;
+        zigzag >>= 7;
+    }
+    bytes[len++] = zigzag;
+    put(bytes, len);
+}
+
+static void put_control(uint8_t channel, uint8_t index, const pbio_control_t *ctl) {
+    put_byte(TAG(TYPE_CONTROL, channel));
+    put_byte(index);
+    put_byte(on_target_func_to_id(ctl->on_target_func));
+    put(ctl, BLOCK_A_SIZE);
+    put((const uint8_t *)ctl + BLOCK_B_START, BLOCK_B_SIZE);
+}
+
+/* Reading */
+
+static bool get_varint(int32_t *value) {
+    uint32_t zigzag = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= size) {
+            return false;
+        }
+        uint8_t byte = data[pos++];
+        zigzag |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = (zigzag >> 1) ^ -(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Gets the tag of the next record if it has the given type and channel
+static bool peek(uint8_t type, uint8_t channel) {
+    return pos < size && data[pos] == TAG(type, channel);
+}
+
+// Moves past the next record, returning false if it is incomplete
+static bool skip_record(void) {
+    uint8_t tag = data[pos++];
+    int32_t value;
+
+    switch (TAG_TYPE(tag)) {
+        case TYPE_UPDATE:
+            return true;
+        case TYPE_CONTROL:
+            pos += 2 + BLOCK_A_SIZE + BLOCK_B_SIZE;
+            return pos <= size;
+        case TYPE_VALUES:
+            if (pos >= size) {
+                return false;
+            }
+            for (uint8_t n = data[pos++]; n > 0; n--) {
+                if (!get_varint(&value)) {
+                    return false;
+                }
+            }
+            return true;
+        case TYPE_OUTPUT:
+            pos += 2;
+            return pos <= size && get_varint(&value);
+        case TYPE_DATA:
+            pos += 2;
+            if (pos > size) {
+                return false;
+            }
+            pos += data[pos - 1];
+            return pos <= size;
+        default:
+            return false;
+    }
+}
+
+static void apply_data(uint8_t index) {
+    uint8_t sensor_mode = data[pos + 1];
+    uint8_t len = data[pos + 2];
+
+    #if PBIO_CONFIG_UARTDEV
+    pbio_iodev_t *iodev;
+    if (pbio_uartdev_get(index, &iodev) == PBIO_SUCCESS && len <= PBIO_IODEV_MAX_DATA_SIZE) {
+        iodev->mode = sensor_mode;
+        memcpy(iodev->bin_data, &data[pos + 3], len);
+    }
+    #endif
+    (void)sensor_mode;
+    (void)len;
+}
+
+/* Recording */
+
+/**
+ * Starts a new recording. Any previous recording is deleted.
+ * @param [in]  max_size    Size of the buffer for the recording in bytes
+ * @return                  ::PBIO_SUCCESS, ::PBIO_ERROR_INVALID_ARG if the
+ *                          size is too small or ::PBIO_ERROR_FAILED if there
+ *                          is not enough memory
+ */
+pbio_error_t pbio_record_start(uint32_t max_size) {
+    pbio_record_stop();
+    pbio_arena_free(record_data);
+    record_data = NULL;
+    record_size = 0;
+
+    if (max_size < HEADER_SIZE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    record_data = pbio_arena_alloc(max_size);
+    if (!record_data) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    data = record_data;
+    size = max_size;
+    reset_state();
+
+    put("PBR", 3);
+    put_byte(VERSION);
+    put_byte(PBIO_RECORD_NUM_CHANNELS);
+    put_byte(BLOCK_A_SIZE & 0xFF);
+    put_byte(BLOCK_A_SIZE >> 8);
+    put_byte(BLOCK_B_SIZE & 0xFF);
+    put_byte(BLOCK_B_SIZE >> 8);
+
+    mode = MODE_RECORD;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Stops recording or replaying. A recording stays available until the next
+ * one is started.
+ */
+void pbio_record_stop(void) {
+    if (mode == MODE_RECORD) {
+        record_size = pos;
+    }
+    mode = MODE_OFF;
+    active = NO_CHANNEL;
+}
+
+/**
+ * Gets the recorded stream.
+ * @param [out] stream      The stream
+ * @param [out] len         Size of the stream in bytes
+ * @return                  ::PBIO_SUCCESS or ::PBIO_ERROR_INVALID_OP if
+ *                          nothing was recorded
+ */
+pbio_error_t pbio_record_get_data(const uint8_t **stream, uint32_t *len) {
+    if (!record_data) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+    *stream = record_data;
+    *len = mode == MODE_RECORD ? pos : record_size;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Tells whether recording stopped because the buffer is full.
+ * @return                  True if full
+ */
+bool pbio_record_is_full(void) {
+    return full;
+}
+
+/* Replaying */
+
+/**
+ * Starts replaying a recording. From now on, updates that are started by
+ * pbio_record_replay_next() get their inputs from the recording.
+ * @param [in]  stream      The recording, which must stay valid during replay
+ * @param [in]  len         Size of the recording in bytes
+ * @return                  ::PBIO_SUCCESS, ::PBIO_ERROR_INVALID_ARG if this is
+ *                          not a recording or ::PBIO_ERROR_NOT_SUPPORTED if
+ *                          it was made with a different controller layout
+ */
+pbio_error_t pbio_record_replay_start(const uint8_t *stream, uint32_t len) {
+    pbio_record_stop();
+
+    if (len < HEADER_SIZE || memcmp(stream, "PBR", 3) != 0 || stream[3] != VERSION) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    if (stream[4] != PBIO_RECORD_NUM_CHANNELS ||
+        (stream[5] | stream[6] << 8) != BLOCK_A_SIZE ||
+        (stream[7] | stream[8] << 8) != BLOCK_B_SIZE) {
+        return PBIO_ERROR_NOT_SUPPORTED;
+    }
+
+    data = stream;
+    size = len;
+    reset_state();
+    pos = HEADER_SIZE;
+    mode = MODE_REPLAY;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Moves to the next recorded update, applying any sensor data on the way.
+ * The caller must then run the update of the returned channel: either
+ * pbio_servo_control_update() or pbio_drivebase_update().
+ * @param [out] channel     Channel of the update
+ * @return                  False at the end of the recording
+ */
+bool pbio_record_replay_next(uint8_t *channel) {
+    if (mode != MODE_REPLAY) {
+        return false;
+    }
+
+    active = NO_CHANNEL;
+
+    while (pos < size) {
+        uint8_t tag = data[pos];
+
+        if (TAG_TYPE(tag) == TYPE_UPDATE) {
+            pos++;
+            active = TAG_CHANNEL(tag);
+            *channel = active;
+            return true;
+        }
+
+        uint32_t start = pos;
+        if (!skip_record()) {
+            break;
+        }
+
+        if (TAG_TYPE(tag) == TYPE_DATA) {
+            pos = start;
+            apply_data(TAG_CHANNEL(tag));
+            skip_record();
+        } else {
+            // Left over from an update that went differently this time
+            mismatches++;
+        }
+    }
+
+    pbio_record_stop();
+    return false;
+}
+
+/**
+ * Gets the number of differences between the recorded and the replayed
+ * updates so far.
+ * @return                  Number of mismatches
+ */
+uint32_t pbio_record_replay_get_mismatches(void) {
+    return mismatches;
+}
+
+/* Hooks in the control loop */
+
+/**
+ * Marks the start of a servo or drive base update.
+ * @param [in]  channel     Update channel
+ * @param [in]  ctl         The controllers used by the update
+ * @param [in]  num_ctl     Number of controllers
+ */
+void _pbio_record_begin(uint8_t channel, pbio_control_t **ctl, uint8_t num_ctl) {
+    if (mode == MODE_RECORD && !full) {
+        record_start = pos;
+        active = channel;
+        put_byte(TAG(TYPE_UPDATE, channel));
+
+        // Store the controllers if a command changed them since the last update
+        for (uint8_t i = 0; i < num_ctl; i++) {
+            if (hash_control(ctl[i]) != control_hash[channel][i]) {
+                put_control(channel, i, ctl[i]);
+            }
+        }
+    }
+
+    if (mode == MODE_REPLAY && active == channel) {
+        while (peek(TYPE_CONTROL, channel) && pos + 3 + BLOCK_A_SIZE + BLOCK_B_SIZE <= size) {
+            uint8_t i = data[pos + 1];
+            if (i < num_ctl) {
+                memcpy(ctl[i], &data[pos + 3], BLOCK_A_SIZE);
+                ctl[i]->on_target_func = on_target_func_from_id(data[pos + 2]);
+                memcpy((uint8_t *)ctl[i] + BLOCK_B_START, &data[pos + 3 + BLOCK_A_SIZE], BLOCK_B_SIZE);
+            }
+            pos += 3 + BLOCK_A_SIZE + BLOCK_B_SIZE;
+        }
+    }
+}
+
+/**
+ * Records or replays the measured state used by an update.
+ * @param [in]  channel     Update channel
+ * @param [in,out] values   The measured values, replaced on replay
+ * @param [in]  num_values  Number of values
+ */
+void _pbio_record_values(uint8_t channel, int32_t *values, uint8_t num_values) {
+    if (active != channel) {
+        return;
+    }
+
+    int32_t *last = last_values[channel];
+
+    if (mode == MODE_RECORD) {
+        put_byte(TAG(TYPE_VALUES, channel));
+        put_byte(num_values);
+        for (uint8_t i = 0; i < num_values; i++) {
+            put_varint(values[i] - last[i]);
+            last[i] = values[i];
+        }
+        return;
+    }
+
+    if (mode == MODE_REPLAY) {
+        if (!peek(TYPE_VALUES, channel) || pos + 1 >= size || data[pos + 1] != num_values) {
+            mismatches++;
+            return;
+        }
+        pos += 2;
+        for (uint8_t i = 0; i < num_values; i++) {
+            int32_t delta;
+            if (!get_varint(&delta)) {
+                mismatches++;
+                return;
+            }
+            last[i] += delta;
+            values[i] = last[i];
+        }
+    }
+}
+
+/**
+ * Records the control signal computed by an update, or compares it with the
+ * recorded one on replay.
+ * @param [in]  channel     Update channel
+ * @param [in]  index       Index of the controller in the update
+ * @param [in]  actuation   Actuation type
+ * @param [in]  control     Control signal
+ */
+void _pbio_record_output(uint8_t channel, uint8_t index, pbio_actuation_t actuation, int32_t control) {
+    if (active != channel) {
+        return;
+    }
+
+    if (mode == MODE_RECORD) {
+        put_byte(TAG(TYPE_OUTPUT, channel));
+        put_byte(index);
+        put_byte(actuation);
+        put_varint(control);
+        return;
+    }
+
+    if (mode == MODE_REPLAY) {
+        int32_t recorded;
+        if (!peek(TYPE_OUTPUT, channel) || pos + 3 > size) {
+            mismatches++;
+            return;
+        }
+        uint8_t recorded_index = data[pos + 1];
+        uint8_t recorded_actuation = data[pos + 2];
+        pos += 3;
+        if (!get_varint(&recorded) || recorded_index != index ||
+            recorded_actuation != actuation || recorded != control) {
+            mismatches++;
+        }
+    }
+}
+
+/**
+ * Marks the end of a servo or drive base update.
+ * @param [in]  channel     Update channel
+ * @param [in]  ctl         The controllers used by the update
+ * @param [in]  num_ctl     Number of controllers
+ */
+void _pbio_record_end(uint8_t channel, pbio_control_t **ctl, uint8_t num_ctl) {
+    if (active != channel) {
+        return;
+    }
+
+    if (mode == MODE_RECORD) {
+        for (uint8_t i = 0; i < num_ctl; i++) {
+            control_hash[channel][i] = hash_control(ctl[i]);
+        }
+        record_start = pos;
+    }
+
+    active = NO_CHANNEL;
+}
+
+/**
+ * Records data received from a sensor.
+ * @param [in]  index       Sensor index, starting at 0 for the first sensor port
+ * @param [in]  sensor_mode Mode of the data
+ * @param [in]  bytes       The data
+ * @param [in]  len         Size of the data
+ */
+void _pbio_record_iodev_data(uint8_t index, uint8_t sensor_mode, const uint8_t *bytes, uint8_t len) {
+    if (mode != MODE_RECORD || active != NO_CHANNEL) {
+        return;
+    }
+
+    record_start = pos;
+    put_byte(TAG(TYPE_DATA, index));
+    put_byte(sensor_mode);
+    put_byte(len);
+    put(bytes, len);
+}
+
+#endif // PBIO_CONFIG_RECORD
@@ -91,7 +91,7 @@ pbio_error_t pbio_serial_read(pbio_serial_t *ser, uint8_t *buf, size_t count) {
 
     // Read and keep track of how much was read
     size_t read_now;
-    err = pbdrv_serial_read(ser->dev, &buf[count - ser->remaining], count, &read_now);
+    err = pbdrv_serial_read(ser->dev, &buf[count - ser->remaining], ser->remaining, &read_now);
     if (err != PBIO_SUCCESS) {
         return pbio_serial_read_stop(ser, err);
     }
@@ -113,6 +113,36 @@ pbio_error_t pbio_serial_read(pbio_serial_t *ser, uint8_t *buf, size_t count) {
     return PBIO_ERROR_AGAIN;
 }
 
+/**
+ * Waits until there is data to read, without using the CPU. Use this between
+ * calls to pbio_serial_read() that return ::PBIO_ERROR_AGAIN.
+ * @param [in]  ser         The serial port
+ * @param [in]  max_time    Maximum time to wait (ms), or -1 to wait until
+ *                          data arrives or the read times out
+ * @return                  ::PBIO_SUCCESS when pbio_serial_read() should be
+ *                          called again, or ::PBIO_ERROR_IO
+ */
+pbio_error_t pbio_serial_wait(pbio_serial_t *ser, int max_time) {
+
+    // Don't wait past the timeout of the read that is in progress, so that
+    // the next call to pbio_serial_read() can report it
+    if (ser->busy && ser->timeout >= 0) {
+        int remaining = ser->timeout - (int)(clock_usecs()/1000 - ser->time_start) + 1;
+        if (remaining < 0) {
+            remaining = 0;
+        }
+        if (max_time < 0 || remaining < max_time) {
+            max_time = remaining;
+        }
+    }
+
+    pbio_error_t err = pbdrv_serial_wait(ser->dev, max_time);
+    if (err == PBIO_ERROR_TIMEDOUT || err == PBIO_ERROR_AGAIN) {
+        return PBIO_SUCCESS;
+    }
+    return err;
+}
+
 pbio_error_t pbio_serial_clear(pbio_serial_t *ser) {
     return pbdrv_serial_clear(ser->dev);
 }
@@ -10,12 +10,13 @@
 #include <pbdrv/counter.h>
 #include <pbdrv/motor.h>
 #include <pbio/math.h>
+#include <pbio/record.h>
 #include <pbio/servo.h>
 #include <pbio/logger.h>
 
 #if PBDRV_CONFIG_NUM_MOTOR_CONTROLLER != 0
 
-#define SERVO_LOG_NUM_VALUES (9 + NUM_DEFAULT_LOG_VALUES)
+#define SERVO_LOG_NUM_VALUES (15 + NUM_DEFAULT_LOG_VALUES)
 
 // TODO: Move to config and enable only known motors for platform
 static pbio_control_settings_t settings_servo_ev3_medium = {
@@ -180,7 +181,7 @@ pbio_error_t pbio_servo_setup(pbio_servo_t *srv, pbio_direction_t direction, fix
     load_servo_settings(&srv->control.settings, srv->dcmotor->id);
 
     // For a servo, counts per output unit is counts per degree at the gear train output
-    srv->control.settings.counts_per_unit = fix16_mul(F16C(PBDRV_CONFIG_COUNTER_COUNTS_PER_DEGREE, 0), gear_ratio);
+    pbio_math_scale_set(&srv->control.settings.counts_per_unit, fix16_mul(F16C(PBDRV_CONFIG_COUNTER_COUNTS_PER_DEGREE, 0), gear_ratio));
 
     // Configure the logs for a servo
     srv->log.num_values = SERVO_LOG_NUM_VALUES;
@@ -246,11 +247,19 @@ static pbio_error_t servo_get_state(pbio_servo_t *srv, int32_t *time_now, int32_
     if (err != PBIO_SUCCESS) {
         return err;
     }
+
+    // Record the state, or replace it by the recorded state on replay
+    int32_t values[] = { *time_now, *count_now, *rate_now };
+    _pbio_record_values(srv->port - PBDRV_CONFIG_FIRST_MOTOR_PORT, values, 3);
+    *time_now = values[0];
+    *count_now = values[1];
+    *rate_now = values[2];
+
     return PBIO_SUCCESS;
 }
 
 // Actuate a single motor
-static pbio_error_t pbio_servo_actuate(pbio_servo_t *srv, pbio_actuation_t actuation_type, int32_t control) {
+static pbio_error_t pbio_servo_actuate(pbio_servo_t *srv, int32_t time_now, pbio_actuation_t actuation_type, int32_t control) {
 
     // Apply the calculated actuation, by type
     switch (actuation_type)
@@ -260,7 +269,7 @@ static pbio_error_t pbio_servo_actuate(pbio_servo_t *srv, pbio_actuation_t actua
     case PBIO_ACTUATION_BRAKE:
         return pbio_dcmotor_brake(srv->dcmotor);
     case PBIO_ACTUATION_HOLD:
-        return pbio_control_start_hold_control(&srv->control, clock_usecs(), control);
+        return pbio_control_start_hold_control(&srv->control, time_now, control);
     case PBIO_ACTUATION_DUTY:
         return pbio_dcmotor_set_duty_cycle_sys(srv->dcmotor, control);
     }
@@ -269,7 +278,7 @@ static pbio_error_t pbio_servo_actuate(pbio_servo_t *srv, pbio_actuation_t actua
 }
 
 // Log motor data for a motor that is being actively controlled
-static pbio_error_t pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, int32_t count_now, int32_t rate_now, pbio_actuation_t actuation, int32_t control) {
+static pbio_error_t pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, int32_t count_now, int32_t rate_now, pbio_actuation_t actuation, int32_t control, bool controlled) {
 
     int32_t buf[SERVO_LOG_NUM_VALUES];
     memset(buf, 0, sizeof(buf));
@@ -282,36 +291,52 @@ static pbio_error_t pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, i
     buf[3] = actuation;
     buf[4] = control;
 
-    // If control is active, log additional data about the maneuver
-    if (srv->control.type != PBIO_CONTROL_NONE) {
-        
-        // Get the time of reference evaluation
-        int32_t time_ref = pbio_control_get_ref_time(&srv->control, time_now);
+    // If control is active, log the data that control_update just computed
+    if (controlled) {
+        pbio_control_state_t *state = &srv->control.state;
 
         // Log the time since start of control trajectory
-        buf[0] = (time_ref - srv->control.trajectory.t0) / 1000;
-
-        // Log reference signals. These values are only meaningful for time based commands
-        int32_t count_ref, count_ref_ext, rate_ref, err, err_integral, acceleration_ref;
-        pbio_trajectory_get_reference(&srv->control.trajectory, time_ref, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+        buf[0] = (state->time_ref - srv->control.trajectory.t0) / 1000;
 
-        if (srv->control.type == PBIO_CONTROL_ANGLE) {
-            pbio_count_integrator_get_errors(&srv->control.count_integrator, count_now, count_ref, &err, &err_integral);
-        }
-        else {
-            pbio_rate_integrator_get_errors(&srv->control.rate_integrator, rate_now, rate_ref, count_now, count_ref, &err, &err_integral);
-        }
+        // Log reference signals and errors
+        buf[5] = state->count_ref;
+        buf[6] = state->rate_ref;
+        buf[7] = state->err; // count err for angle control, rate err for timed control
+        buf[8] = state->err_integral;
 
-        buf[5] = count_ref;
-        buf[6] = rate_ref;
-        buf[7] = err; // count err for angle control, rate err for timed control
-        buf[8] = err_integral;
+        // Log the individual contributions to the duty
+        buf[9] = state->duty_proportional;
+        buf[10] = state->duty_integral;
+        buf[11] = state->duty_derivative;
+        buf[12] = state->duty_feedforward;
+        buf[13] = state->windup;
+        buf[14] = srv->control.stalled;
     }
 
     return pbio_logger_update(&srv->log, buf);
 }
 
-pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
+// Get the reference of a follower from the physical state of its leader
+static pbio_error_t servo_follow_get_reference(pbio_follow_t *f, int32_t *count, int32_t *count_ext, int32_t *rate) {
+
+    pbio_error_t err;
+
+    int32_t leader_count;
+    int32_t leader_rate;
+    err = pbio_tacho_get_count(f->leader->tacho, &leader_count);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    err = pbio_tacho_get_rate(f->leader->tacho, &leader_rate);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    pbio_follow_get_reference(f, leader_count, leader_rate, count, count_ext, rate);
+    return PBIO_SUCCESS;
+}
+
+static pbio_error_t servo_control_update(pbio_servo_t *srv) {
 
     // Read the physical state
     int32_t time_now;
@@ -322,6 +347,28 @@ pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
         return err;
     }
 
+    // A follower gets a new reference from its leader in every update
+    if (srv->follow.leader && pbio_control_is_following(&srv->control)) {
+        int32_t count_ref, count_ref_ext, rate_ref;
+        err = servo_follow_get_reference(&srv->follow, &count_ref, &count_ref_ext, &rate_ref);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        err = pbio_control_start_follow_control(&srv->control, time_now, count_ref, count_ref_ext, rate_ref);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+    // A streaming servo interpolates between the setpoints it received
+    else if (srv->stream.size > 0 && pbio_control_is_following(&srv->control)) {
+        int32_t count_ref, count_ref_ext, rate_ref;
+        pbio_stream_get_reference(&srv->stream, time_now, &count_ref, &count_ref_ext, &rate_ref);
+        err = pbio_control_start_follow_control(&srv->control, time_now, count_ref, count_ref_ext, rate_ref);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+
     // Control action to be calculated
     pbio_actuation_t actuation;
     int32_t control;
@@ -334,20 +381,32 @@ pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
         if (err != PBIO_SUCCESS) {
             return err;
         }
-        return pbio_servo_log_update(srv, time_now, count_now, rate_now, state, control);
+        return pbio_servo_log_update(srv, time_now, count_now, rate_now, state, control, false);
     }
 
     // Calculate control signal
     control_update(&srv->control, time_now, count_now, rate_now, &actuation, &control);
+    _pbio_record_output(srv->port - PBDRV_CONFIG_FIRST_MOTOR_PORT, 0, actuation, control);
 
     // Apply the control type and signal
-    err = pbio_servo_actuate(srv, actuation, control);
+    err = pbio_servo_actuate(srv, time_now, actuation, control);
     if (err != PBIO_SUCCESS) {
         return err;
     }
 
     // Log data if logger enabled
-    return pbio_servo_log_update(srv, time_now, count_now, rate_now, actuation, control);
+    return pbio_servo_log_update(srv, time_now, count_now, rate_now, actuation, control, true);
+}
+
+pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
+    uint8_t channel = srv->port - PBDRV_CONFIG_FIRST_MOTOR_PORT;
+    pbio_control_t *ctl = &srv->control;
+
+    _pbio_record_begin(channel, &ctl, 1);
+    pbio_error_t err = servo_control_update(srv);
+    _pbio_record_end(channel, &ctl, 1);
+
+    return err;
 }
 
 /* pbio user functions */
@@ -386,7 +445,7 @@ pbio_error_t pbio_servo_stop(pbio_servo_t *srv, pbio_actuation_t after_stop) {
     }
 
     // Apply the actuation
-    return pbio_servo_actuate(srv, after_stop, control);
+    return pbio_servo_actuate(srv, clock_usecs(), after_stop, control);
 }
 
 pbio_error_t pbio_servo_stop_force(pbio_servo_t *srv) {
@@ -396,6 +455,10 @@ pbio_error_t pbio_servo_stop_force(pbio_servo_t *srv) {
     // Release claim from drivebases or other classes
     srv->claimed = false;
 
+    // Stop following other servos or streams
+    srv->follow.leader = NULL;
+    srv->stream.size = 0;
+
     // Try to stop / coast motor whether or not initialized already
     if (srv->dcmotor) {
         return pbio_dcmotor_coast(srv->dcmotor);
@@ -546,4 +609,102 @@ pbio_error_t pbio_servo_track_target(pbio_servo_t *srv, int32_t target) {
     return pbio_control_start_hold_control(&srv->control, time_start, target_count);
 }
 
+// Add a setpoint to reach at a given time, in milliseconds on the clock of the
+// sender. Setpoints are played back after a delay, so the servo can move
+// smoothly between them even if they arrive at irregular intervals.
+pbio_error_t pbio_servo_stream_target(pbio_servo_t *srv, int32_t target, int32_t time_stamp, int32_t delay) {
+
+    // Return if this servo is already in use by higher level entity
+    if (srv->claimed) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+    if (delay < 0) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    pbio_stream_t *s = &srv->stream;
+    int32_t time_now = clock_usecs();
+    bool streaming = s->size > 0 && !srv->follow.leader && pbio_control_is_following(&srv->control);
+
+    // On the first setpoint, start from the current reference or the physical count
+    if (!streaming) {
+        int32_t count_start;
+        if (srv->control.type == PBIO_CONTROL_NONE) {
+            pbio_error_t err = pbio_tacho_get_count(srv->tacho, &count_start);
+            if (err != PBIO_SUCCESS) {
+                return err;
+            }
+        }
+        else {
+            int32_t unused;
+            pbio_trajectory_get_reference(&srv->control.trajectory, pbio_control_get_ref_time(&srv->control, time_now), &count_start, &unused, &unused, &unused);
+        }
+        srv->follow.leader = NULL;
+        pbio_stream_start(s, time_now, count_start, time_stamp, delay);
+    }
+
+    pbio_stream_add(s, time_now, pbio_control_user_to_counts(&srv->control.settings, target), time_stamp);
+
+    if (streaming) {
+        return PBIO_SUCCESS;
+    }
+
+    // Start following the stream. The reference is updated in every control update.
+    return pbio_control_start_follow_control(&srv->control, time_now, s->count[0], 0, 0);
+}
+
+pbio_error_t pbio_servo_follow(pbio_servo_t *srv, pbio_servo_t *leader, fix16_t ratio, int32_t offset, bool relative, const int32_t *cam, uint8_t cam_size, int32_t cam_period) {
+
+    pbio_error_t err;
+
+    // Return if this servo is already in use by higher level entity
+    if (srv->claimed) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // Validate arguments
+    if (leader == srv || cam_size > PBIO_FOLLOW_CAM_SIZE_MAX || (cam_size > 0 && cam_period <= 0)) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    if (!leader->tacho) {
+        return PBIO_ERROR_NO_DEV;
+    }
+
+    // Convert the settings from user units to counts of each servo
+    pbio_follow_t *f = &srv->follow;
+    f->ratio = fix16_div(fix16_mul(ratio, srv->control.settings.counts_per_unit.scale), leader->control.settings.counts_per_unit.scale);
+    f->offset = pbio_control_user_to_counts(&srv->control.settings, offset);
+    f->cam_period = pbio_control_user_to_counts(&leader->control.settings, cam_period);
+    f->cam_size = f->cam_period > 0 ? cam_size : 0;
+    for (uint8_t i = 0; i < f->cam_size; i++) {
+        f->cam[i] = pbio_control_user_to_counts(&srv->control.settings, cam[i]);
+    }
+    f->leader = leader;
+    srv->stream.size = 0;
+
+    // In relative mode, the offset is relative to where the follower is now,
+    // so it does not jump to a new position when it starts following.
+    if (relative) {
+        int32_t leader_count, count_now;
+        err = pbio_tacho_get_count(leader->tacho, &leader_count);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        err = pbio_tacho_get_count(srv->tacho, &count_now);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        pbio_follow_set_relative(f, leader_count, count_now);
+    }
+
+    // Get the initial reference
+    int32_t count_ref, count_ref_ext, rate_ref;
+    err = servo_follow_get_reference(f, &count_ref, &count_ref_ext, &rate_ref);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    return pbio_control_start_follow_control(&srv->control, clock_usecs(), count_ref, count_ref_ext, rate_ref);
+}
+
 #endif // PBDRV_CONFIG_NUM_MOTOR_CONTROLLER
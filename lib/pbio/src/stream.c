@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/stream.h>
+
+/* Setpoint buffer for a servo that follows a stream of timestamped targets */
+
+// Start a new stream at the given count. The setpoint with the given sender
+// time stamp is played back after the delay, in milliseconds.
+void pbio_stream_start(pbio_stream_t *s, int32_t time_now, int32_t count, int32_t stamp, int32_t delay) {
+    s->size = 1;
+    s->time[0] = time_now;
+    s->count[0] = count;
+    s->stamp = stamp;
+    s->delay = delay * US_PER_MS;
+    s->time_stamp = time_now + s->delay;
+    s->lag = 0;
+}
+
+// Add a setpoint to reach at a given time, in milliseconds on the clock of the sender
+void pbio_stream_add(pbio_stream_t *s, int32_t time_now, int32_t count, int32_t stamp) {
+
+    // Time stamps are compared to the previous one modulo 2^16, so senders
+    // may use a 16-bit clock, as long as setpoints are less than 32 s apart.
+    int32_t elapsed = (int16_t) (stamp - s->stamp);
+
+    // Ignore setpoints that arrive out of order
+    if (elapsed < 0) {
+        return;
+    }
+
+    // Hub time at which the setpoint should be reached. Like the clock, this wraps around.
+    int32_t time_stamp = s->time_stamp + elapsed * US_PER_MS;
+    int32_t lag = s->lag;
+    int32_t time_target = time_stamp + lag;
+
+    if (time_target - time_now < 0) {
+        // If a setpoint arrives too late to be played back in time, delay
+        // the playback of those that follow, but only up to a limit. Beyond
+        // that, the sender clock has jumped, so start over from this setpoint.
+        lag += time_now - time_target;
+        if (lag > PBIO_STREAM_LAG_MAX) {
+            time_stamp = time_now + s->delay;
+            lag = 0;
+        }
+        time_target = time_stamp + lag;
+    }
+    else {
+        // Setpoints that arrive in time take back that extra delay, gradually
+        // so that the playback does not speed up by more than 1/8
+        int32_t catch_up = (time_target - s->time[s->size - 1]) / 8;
+        if (catch_up > time_target - time_now) {
+            catch_up = time_target - time_now;
+        }
+        if (catch_up > lag) {
+            catch_up = lag;
+        }
+        lag -= catch_up;
+        time_target -= catch_up;
+    }
+
+    // Ignore setpoints that would not come after the latest one
+    if (time_target - s->time[s->size - 1] <= 0) {
+        return;
+    }
+    s->stamp = stamp;
+    s->time_stamp = time_stamp;
+    s->lag = lag;
+
+    // Discard setpoints we have already passed, but keep the one we are moving away from
+    while (s->size > 1 && time_now - s->time[1] >= 0) {
+        memmove(&s->time[0], &s->time[1], sizeof(s->time[0]) * (s->size - 1));
+        memmove(&s->count[0], &s->count[1], sizeof(s->count[0]) * (s->size - 1));
+        s->size--;
+    }
+
+    // If the buffer is still full, the new setpoint replaces the latest one
+    if (s->size == PBIO_STREAM_SIZE) {
+        s->size--;
+    }
+    s->time[s->size] = time_target;
+    s->count[s->size] = count;
+    s->size++;
+}
+
+// Get the reference by interpolating between setpoints
+void pbio_stream_get_reference(pbio_stream_t *s, int32_t time_now, int32_t *count, int32_t *count_ext, int32_t *rate) {
+
+    // Before the first setpoint or with only one setpoint, wait there
+    if (s->size == 1 || time_now - s->time[0] < 0) {
+        *count = s->count[0];
+        *count_ext = 0;
+        *rate = 0;
+        return;
+    }
+
+    // Find the segment that contains the current time, or the last segment if we are past it
+    uint8_t i = 0;
+    while (i + 2 < s->size && time_now - s->time[i + 1] >= 0) {
+        i++;
+    }
+    int32_t t = time_now - s->time[i];
+    int32_t dt = s->time[i + 1] - s->time[i];
+    int32_t dc = s->count[i + 1] - s->count[i];
+
+    // Beyond the last setpoint, extrapolate for a short time and then stop
+    *rate = (((int64_t) dc) * US_PER_SECOND) / dt;
+    if (t - dt > PBIO_STREAM_EXTRAPOLATE_MAX) {
+        t = dt + PBIO_STREAM_EXTRAPOLATE_MAX;
+        *rate = 0;
+    }
+
+    int64_t mcount = ((int64_t) s->count[i]) * 1000 + (((int64_t) dc) * 1000 * t) / dt;
+    *count = mcount / 1000;
+    *count_ext = mcount - ((int64_t) *count) * 1000;
+}
@@ -14,7 +14,7 @@
 struct _pbio_tacho_t {
     pbio_direction_t direction;
     int32_t offset;
-    fix16_t counts_per_degree;
+    pbio_math_scale_t counts_per_degree;
     pbdrv_counter_dev_t *counter;
 };
 
@@ -59,7 +59,7 @@ static pbio_error_t pbio_tacho_setup(pbio_tacho_t *tacho, uint8_t counter_id, pb
         return PBIO_ERROR_INVALID_ARG;
     }
     // Get overal ratio from counts to output variable, including gear train
-    tacho->counts_per_degree = fix16_mul(F16C(PBDRV_CONFIG_COUNTER_COUNTS_PER_DEGREE, 0), gear_ratio);
+    pbio_math_scale_set(&tacho->counts_per_degree, fix16_mul(F16C(PBDRV_CONFIG_COUNTER_COUNTS_PER_DEGREE, 0), gear_ratio));
 
     // Configure direction
     tacho->direction = direction;
@@ -122,7 +122,7 @@ pbio_error_t pbio_tacho_get_angle(pbio_tacho_t *tacho, int32_t *angle) {
         return err;
     }
 
-    *angle = pbio_math_div_i32_fix16(encoder_count, tacho->counts_per_degree);
+    *angle = pbio_math_scale_div(&tacho->counts_per_degree, encoder_count);
 
     return PBIO_SUCCESS;
 }
@@ -132,7 +132,7 @@ pbio_error_t pbio_tacho_reset_angle(pbio_tacho_t *tacho, int32_t reset_angle, bo
         return pbio_tacho_reset_count_to_abs(tacho);
     }
     else {
-        return pbio_tacho_reset_count(tacho, pbio_math_mul_i32_fix16(reset_angle, tacho->counts_per_degree));
+        return pbio_tacho_reset_count(tacho, pbio_math_scale_mul(&tacho->counts_per_degree, reset_angle));
     }
 }
 
@@ -160,7 +160,7 @@ pbio_error_t pbio_tacho_get_angular_rate(pbio_tacho_t *tacho, int32_t *angular_r
         return err;
     }
 
-    *angular_rate = pbio_math_div_i32_fix16(encoder_rate, tacho->counts_per_degree);
+    *angular_rate = pbio_math_scale_div(&tacho->counts_per_degree, encoder_rate);
 
     return PBIO_SUCCESS;
 }
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+// Ring buffer of scheduler events for profiling. This implements the
+// process_trace() hook that Contiki calls when PROCESS_CONF_TRACE is set.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <pbio/config.h>
+#include <pbio/trace.h>
+
+#if PROCESS_CONF_TRACE
+
+// Maximum number of distinct processes that get their own id
+#define PBIO_TRACE_NUM_IDS (32)
+
+static pbio_trace_event_t trace[PBIO_CONFIG_TRACE_NUM_EVENTS];
+
+// Total number of events recorded since the last clear. Only the last
+// PBIO_CONFIG_TRACE_NUM_EVENTS of them are kept.
+static uint32_t trace_count;
+
+// Processes seen so far. The id of a process is its index plus one.
+static struct process *trace_processes[PBIO_TRACE_NUM_IDS];
+
+static uint8_t trace_get_id(struct process *p) {
+
+    if (p == NULL) {
+        return PBIO_TRACE_ID_OTHER;
+    }
+
+    for (uint8_t i = 0; i < PBIO_TRACE_NUM_IDS; i++) {
+        // Return the id if we have seen this process before
+        if (trace_processes[i] == p) {
+            return i + 1;
+        }
+        // Otherwise, assign the first free id
+        if (trace_processes[i] == NULL) {
+            trace_processes[i] = p;
+            return i + 1;
+        }
+    }
+    return PBIO_TRACE_ID_OTHER;
+}
+
+static void trace_add(uint8_t type, uint8_t id, process_event_t ev, unsigned long start) {
+    pbio_trace_event_t *entry = &trace[trace_count % PBIO_CONFIG_TRACE_NUM_EVENTS];
+    entry->time = start;
+    entry->duration = clock_usecs() - start;
+    entry->type = type;
+    entry->id = id;
+    entry->event = ev;
+    entry->nevents = process_nevents();
+    trace_count++;
+}
+
+void process_trace(unsigned char type, struct process *p, process_event_t ev, unsigned long start) {
+    trace_add(type, trace_get_id(p), ev, start);
+}
+
+void pbio_trace_record(uint8_t type, unsigned long start) {
+    trace_add(type, PBIO_TRACE_ID_NONE, PROCESS_EVENT_NONE, start);
+}
+
+void pbio_trace_clear(void) {
+    trace_count = 0;
+}
+
+uint32_t pbio_trace_get_count(void) {
+    if (trace_count > PBIO_CONFIG_TRACE_NUM_EVENTS) {
+        return PBIO_CONFIG_TRACE_NUM_EVENTS;
+    }
+    return trace_count;
+}
+
+// Gets the recorded events from oldest (index 0) to newest
+bool pbio_trace_get_event(uint32_t index, pbio_trace_event_t *event) {
+    uint32_t count = pbio_trace_get_count();
+    if (index >= count) {
+        return false;
+    }
+    *event = trace[(trace_count - count + index) % PBIO_CONFIG_TRACE_NUM_EVENTS];
+    return true;
+}
+
+// Gets the name of the process with the given id, or NULL if there is none
+const char *pbio_trace_get_name(uint8_t id) {
+    if (id == PBIO_TRACE_ID_NONE || id > PBIO_TRACE_NUM_IDS || trace_processes[id - 1] == NULL) {
+        return NULL;
+    }
+    return PROCESS_NAME_STRING(trace_processes[id - 1]);
+}
+
+#endif // PROCESS_CONF_TRACE
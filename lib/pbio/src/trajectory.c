@@ -19,6 +19,71 @@ static void as_count(int64_t mcount, int32_t *count, int32_t *count_ext) {
     *count_ext = mcount - ((int64_t) *count)*1000;
 }
 
+// Convert count and millicount to Q16 counts. The magnitude is rounded up so
+// that converting back with as_count_q16 gives the original values exactly.
+static int64_t as_q16count(int32_t count, int32_t count_ext) {
+    int64_t mcount = as_mcount(count, count_ext);
+    int64_t qcount = ((mcount < 0 ? -mcount : mcount) * 65536 + 999) / 1000;
+    return mcount < 0 ? -qcount : qcount;
+}
+
+// Split Q16 counts into counts and millicounts. Like as_count, this rounds
+// towards zero, but it uses only shifts and multiplications.
+static void as_count_q16(int64_t qcount, int32_t *count, int32_t *count_ext) {
+    uint64_t abs_qcount = qcount < 0 ? -qcount : qcount;
+    int32_t abs_count = abs_qcount >> 16;
+    int32_t abs_count_ext = ((abs_qcount & 0xFFFF) * 1000) >> 16;
+    *count = qcount < 0 ? -abs_count : abs_count;
+    *count_ext = qcount < 0 ? -abs_count_ext : abs_count_ext;
+}
+
+// Divide with rounding to nearest, for the coefficients computed below
+static int64_t div_round(int64_t num, int64_t den) {
+    return (num < 0 ? num - den/2 : num + den/2) / den;
+}
+
+// Multiply a rate in Q40 counts per microsecond by a time in microseconds, giving Q16 counts.
+// The time is split in two parts, so the intermediate products do not overflow.
+static int64_t mul_q40_time(int64_t q40rate, int32_t t) {
+    return ((q40rate * (t >> 10)) >> 14) + ((q40rate * (t & 0x3FF)) >> 24);
+}
+
+// Precompute the fixed-point polynomial coefficients of each phase, so that
+// pbio_trajectory_get_reference does not need any divisions. This must be
+// called whenever the trajectory parameters change.
+static void set_coefficients(pbio_trajectory_t *ref) {
+    // Start angles of each phase
+    ref->qth0 = as_q16count(ref->th0, ref->th0_ext);
+    ref->qth1 = as_q16count(ref->th1, ref->th1_ext);
+    ref->qth2 = as_q16count(ref->th2, ref->th2_ext);
+
+    // Rates, used as the linear coefficient of the angle polynomial
+    ref->qw0 = div_round(((int64_t) ref->w0) << 40, US_PER_SECOND);
+    ref->qw1 = div_round(((int64_t) ref->w1) << 40, US_PER_SECOND);
+
+    // Half accelerations, used as the quadratic coefficient of the angle polynomial.
+    // In Q64, this is a * 2^63 / US_PER_SECOND^2, evaluated without overflowing.
+    ref->qa0 = div_round(ref->a0 * (INT64_MAX / US_PER_SECOND), US_PER_SECOND);
+    ref->qa2 = div_round(ref->a2 * (INT64_MAX / US_PER_SECOND), US_PER_SECOND);
+
+    // Accelerations, used as the linear coefficient of the rate polynomial. The
+    // magnitude is rounded down so the rate never overshoots the target rate.
+    ref->ra0 = (((int64_t) ref->a0) << 32) / US_PER_SECOND;
+    ref->ra2 = (((int64_t) ref->a2) << 32) / US_PER_SECOND;
+}
+
+// Evaluate angle in Q16 counts along a phase with given start angle, rate, and half acceleration
+static int64_t eval_q16count(int64_t qth, int64_t qw, int64_t qa, int32_t t) {
+    // Horner form: t times the average rate over this interval
+    return qth + mul_q40_time(qw + ((qa * t) >> 24), t);
+}
+
+// Evaluate rate along a phase with given start rate and acceleration, rounding towards zero
+static int32_t eval_rate(int32_t w, int32_t ra, int32_t t) {
+    int64_t increment = ((int64_t) ra) * t;
+    return w + (int32_t) (increment < 0 ? -((-increment) >> 32) : increment >> 32);
+}
+
 void reverse_trajectory(pbio_trajectory_t *ref) {
     // Mirror angles about initial angle th0
 
@@ -45,7 +110,7 @@ void reverse_trajectory(pbio_trajectory_t *ref) {
     ref->a2 *= -1;
 }
 
-void pbio_trajectory_make_stationary(pbio_trajectory_t *ref, int32_t t0, int32_t th0) {
+void pbio_trajectory_make_stationary(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th0_ext) {
     // All times equal to initial time:
     ref->t0 = t0;
     ref->t1 = t0;
@@ -58,11 +123,11 @@ void pbio_trajectory_make_stationary(pbio_trajectory_t *ref, int32_t t0, int32_t
     ref->th2 = th0;
     ref->th3 = th0;
 
-    // FIXME: Angle based does not have high res yet
-    ref->th0_ext = 0;
-    ref->th1_ext = 0;
-    ref->th2_ext = 0;
-    ref->th3_ext = 0;
+    // Including the millicounts:
+    ref->th0_ext = th0_ext;
+    ref->th1_ext = th0_ext;
+    ref->th2_ext = th0_ext;
+    ref->th3_ext = th0_ext;
 
     // All speeds/accelerations zero:
     ref->w0 = 0;
@@ -72,6 +137,19 @@ void pbio_trajectory_make_stationary(pbio_trajectory_t *ref, int32_t t0, int32_t
 
     // This is a finite maneuver
     ref->forever = false;
+
+    set_coefficients(ref);
+}
+
+// Make a trajectory that moves at a constant rate forever, starting from the given angle.
+void pbio_trajectory_make_constant(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th0_ext, int32_t w) {
+    pbio_trajectory_make_stationary(ref, t0, th0, th0_ext);
+
+    // Only the constant speed phase is used, so only its coefficients are needed
+    ref->w0 = w;
+    ref->w1 = w;
+    ref->qw1 = div_round(((int64_t) w) << 40, US_PER_SECOND);
+    ref->forever = true;
 }
 
 static int64_t x_time(int32_t b, int32_t t) {
@@ -194,10 +272,12 @@ pbio_error_t pbio_trajectory_make_time_based(pbio_trajectory_t *ref, int32_t t0,
         reverse_trajectory(ref);
     }
 
+    set_coefficients(ref);
+
     return PBIO_SUCCESS;
 }
 
-pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th3, int32_t w0, int32_t wt, int32_t wmax, int32_t a, int32_t amax) {
+pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0, int32_t th0, int32_t th0_ext, int32_t th3, int32_t w0, int32_t wt, int32_t wmax, int32_t a, int32_t amax) {
 
     // Return error for zero speed
     if (wt == 0) {
@@ -207,18 +287,23 @@ pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0
     if (abs((th3 - th0) / wt) + 1 > DURATION_MAX_S) {
         return PBIO_ERROR_INVALID_ARG;
     }
+
+    // Work with millicount/millideg precision. The target has no millicounts.
+    int64_t mth0 = as_mcount(th0, th0_ext);
+    int64_t mth3 = as_mcount(th3, 0);
+
     // Return empty maneuver for zero angle
-    if (th3 == th0) {
-        pbio_trajectory_make_stationary(ref, t0, th0);
+    if (mth3 == mth0) {
+        pbio_trajectory_make_stationary(ref, t0, th0, th0_ext);
         return PBIO_SUCCESS;
     }
 
     // Remember if the original user-specified maneuver was backward
-    bool backward = th3 < th0;
+    bool backward = mth3 < mth0;
 
     // Convert user parameters into a forward maneuver to simplify computations (we negate results at the end)
     if (backward) {
-        th3 = 2*th0 - th3;
+        mth3 = 2*mth0 - mth3;
         w0 *= -1;
     }
 
@@ -233,10 +318,13 @@ pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0
     w0 = max(-wmax, min(w0, wmax));
 
     // Limit initial speed, but evaluate square root only if necessary (usually not)
-    if (w0 > 0 && (w0*w0)/(2*a) > th3 - th0) {
-        w0 = pbio_math_sqrt(2*a*(th3 - th0));
+    if (w0 > 0 && (((int64_t) w0)*w0*1000)/(2*a) > mth3 - mth0) {
+        w0 = pbio_math_sqrt((2*a*(mth3 - mth0))/1000);
     }
 
+    int64_t mth1;
+    int64_t mth2;
+
     // Initial speed is less than the target speed
     if (w0 < wt) {
         // Therefore accelerate towards intersection from below,
@@ -244,50 +332,48 @@ pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0
         ref->a0 = a;
 
         // Fictitious zero speed angle (ahead of us if we have negative initial speed; behind us if we have initial positive speed)
-        int32_t thf = th0 - (w0*w0)/(2*a);
+        int64_t mthf = mth0 - (((int64_t) w0)*w0*1000)/(2*a);
 
         // Test if we can get to ref speed
-        if (th3-thf >= (wt*wt)/a) {
+        if (mth3-mthf >= (((int64_t) wt)*wt*1000)/a) {
             //  If so, find both constant speed intersections
-            ref->th1 = thf + (wt*wt)/(2*a);
-            ref->th2 = th3 - (wt*wt)/(2*a);
+            mth1 = mthf + (((int64_t) wt)*wt*1000)/(2*a);
+            mth2 = mth3 - (((int64_t) wt)*wt*1000)/(2*a);
             ref->w1 = wt;
         }
         else {
             // Otherwise, intersect halfway between accelerating and decelerating square root arcs
-            ref->th1 = (th3+thf)/2;
-            ref->th2 = ref->th1;
-            ref->w1 = pbio_math_sqrt(2*a*(ref->th1 - thf));
+            mth1 = (mth3+mthf)/2;
+            mth2 = mth1;
+            ref->w1 = pbio_math_sqrt((2*a*(mth1 - mthf))/1000);
         }
     }
     // Initial speed is equal to or more than the target speed
     else {
         // Therefore decelerate towards intersection from above
         ref->a0 = -a;
-        ref->th1 = th0 + (w0*w0-wt*wt)/(2*a);
-        ref->th2 = th3 - (wt*wt)/(2*a);
+        mth1 = mth0 + (((int64_t) w0)*w0*1000 - ((int64_t) wt)*wt*1000)/(2*a);
+        mth2 = mth3 - (((int64_t) wt)*wt*1000)/(2*a);
         ref->w1 = wt;
     }
     // Corresponding time intervals
     int32_t t1mt0 = wdiva(ref->w1-w0, ref->a0);
-    int32_t t2mt1 = ref->th2 == ref->th1 ? 0 : wdiva(ref->th2-ref->th1, ref->w1);
+    int32_t t2mt1 = mth2 == mth1 ? 0 : ((mth2-mth1)*US_PER_MS)/ref->w1;
     int32_t t3mt2 = wdiva(ref->w1, a);
 
     // Store other results/arguments
     ref->w0 = w0;
-    ref->th0 = th0;
-    ref->th3 = th3;
     ref->t0 = t0;
     ref->t1 = t0 + t1mt0;
     ref->t2 = ref->t1 + t2mt1;
     ref->t3 = ref->t2 + t3mt2;
     ref->a2 = -a;
 
-    // FIXME: Angle based does not have high res yet
-    ref->th0_ext = 0;
-    ref->th1_ext = 0;
-    ref->th2_ext = 0;
-    ref->th3_ext = 0;
+    // Store as counts and millicount
+    as_count(mth0, &ref->th0, &ref->th0_ext);
+    as_count(mth1, &ref->th1, &ref->th1_ext);
+    as_count(mth2, &ref->th2, &ref->th2_ext);
+    as_count(mth3, &ref->th3, &ref->th3_ext);
 
     // Reverse the maneuver if the original arguments imposed backward motion
     if (backward) {
@@ -297,42 +383,115 @@ pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0
     // This is a finite maneuver
     ref->forever = false;
 
+    set_coefficients(ref);
+
+    return PBIO_SUCCESS;
+}
+
+// Multiply by a ratio k in Q30, where |k| <= 1. The argument is split in two
+// parts, so the intermediate products do not overflow.
+static int64_t mul_q30_ratio(int64_t x, int32_t k) {
+    return (x >> 30) * k + (((x & 0x3FFFFFFF) * k) >> 30);
+}
+
+// Make a trajectory from th0 to th3 with the same timing as a given master
+// trajectory, which must be a finite forward maneuver from zero. The result
+// is the master scaled by the ratio of the angles traveled. Trajectories
+// derived from the same master therefore start and finish together, and
+// their angles stay proportional at every point in time.
+pbio_error_t pbio_trajectory_make_scaled(pbio_trajectory_t *ref, const pbio_trajectory_t *master, int32_t th0, int32_t th0_ext, int32_t th3) {
+
+    // Only finite maneuvers starting from zero can be scaled
+    int64_t mlength = as_mcount(master->th3, master->th3_ext);
+    if (master->forever || master->th0 != 0 || master->th0_ext != 0 || mlength <= 0) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Ratio of the angle to travel and the master angle, in Q30
+    int64_t mth0 = as_mcount(th0, th0_ext);
+    int64_t mlength_ref = as_mcount(th3, 0) - mth0;
+    if (mlength_ref > mlength || -mlength_ref > mlength) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    while (mlength >= ((int64_t) 1) << 32) {
+        // Drop resolution of very long maneuvers so the ratio does not overflow
+        mlength >>= 1;
+        mlength_ref >>= 1;
+    }
+    int32_t k = (mlength_ref << 30) / mlength;
+
+    // Same timing as the master
+    ref->t0 = master->t0;
+    ref->t1 = master->t1;
+    ref->t2 = master->t2;
+    ref->t3 = master->t3;
+
+    // Scaled rates and accelerations
+    ref->w0 = div_round(((int64_t) master->w0) * k, 1 << 30);
+    ref->w1 = div_round(((int64_t) master->w1) * k, 1 << 30);
+    ref->a0 = div_round(((int64_t) master->a0) * k, 1 << 30);
+    ref->a2 = div_round(((int64_t) master->a2) * k, 1 << 30);
+
+    // Scale the polynomial coefficients directly, instead of recomputing
+    // them from the rounded rates and accelerations above. This way, the
+    // phases join up without steps.
+    ref->qth0 = as_q16count(th0, th0_ext);
+    ref->qth1 = ref->qth0 + mul_q30_ratio(master->qth1 - master->qth0, k);
+    ref->qth2 = ref->qth0 + mul_q30_ratio(master->qth2 - master->qth0, k);
+    ref->qw0 = mul_q30_ratio(master->qw0, k);
+    ref->qw1 = mul_q30_ratio(master->qw1, k);
+    ref->qa0 = mul_q30_ratio(master->qa0, k);
+    ref->qa2 = mul_q30_ratio(master->qa2, k);
+    ref->ra0 = mul_q30_ratio(master->ra0, k);
+    ref->ra2 = mul_q30_ratio(master->ra2, k);
+
+    // Store angles as counts and millicounts. The target has no millicounts.
+    ref->th0 = th0;
+    ref->th0_ext = th0_ext;
+    as_count_q16(ref->qth1, &ref->th1, &ref->th1_ext);
+    as_count_q16(ref->qth2, &ref->th2, &ref->th2_ext);
+    ref->th3 = th3;
+    ref->th3_ext = 0;
+
+    // This is a finite maneuver
+    ref->forever = false;
+
     return PBIO_SUCCESS;
 }
 
 // Evaluate the reference speed and velocity at the (shifted) time
 void pbio_trajectory_get_reference(pbio_trajectory_t *traject, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
 
-    int64_t mcount_ref;
+    // The polynomial coefficients are precomputed in set_coefficients, so
+    // this uses only multiplications and shifts. This matters on hubs without
+    // a hardware divider, since this is evaluated in every control loop.
 
     if (time_ref - traject->t1 < 0) {
-        // If we are here, then we are still in the acceleration phase. Includes conversion from microseconds to seconds, in two steps to avoid overflows and round off errors
-        *rate_ref = traject->w0   + timest(traject->a0, time_ref-traject->t0);
-        mcount_ref = as_mcount(traject->th0, traject->th0_ext) + x_time(traject->w0, time_ref-traject->t0) + x_time2(traject->a0, time_ref-traject->t0);
+        // If we are here, then we are still in the acceleration phase
+        *rate_ref = eval_rate(traject->w0, traject->ra0, time_ref - traject->t0);
+        as_count_q16(eval_q16count(traject->qth0, traject->qw0, traject->qa0, time_ref - traject->t0), count_ref, count_ref_ext);
         *acceleration_ref = traject->a0;
     }
     else if (traject->forever || time_ref - traject->t2 <= 0) {
         // If we are here, then we are in the constant speed phase
         *rate_ref = traject->w1;
-        mcount_ref = as_mcount(traject->th1, traject->th1_ext) + x_time(traject->w1, time_ref-traject->t1);
+        as_count_q16(eval_q16count(traject->qth1, traject->qw1, 0, time_ref - traject->t1), count_ref, count_ref_ext);
         *acceleration_ref = 0;
     }
     else if (time_ref - traject->t3 <= 0) {
         // If we are here, then we are in the deceleration phase
-        *rate_ref = traject->w1 + timest(traject->a2,    time_ref-traject->t2);
-        mcount_ref = as_mcount(traject->th2, traject->th2_ext)  + x_time(traject->w1, time_ref-traject->t2) + x_time2(traject->a2, time_ref-traject->t2);
+        *rate_ref = eval_rate(traject->w1, traject->ra2, time_ref - traject->t2);
+        as_count_q16(eval_q16count(traject->qth2, traject->qw1, traject->qa2, time_ref - traject->t2), count_ref, count_ref_ext);
         *acceleration_ref = traject->a2;
     }
     else {
         // If we are here, we are in the zero speed phase (relevant when holding position)
         *rate_ref = 0;
-        mcount_ref = as_mcount(traject->th3, traject->th3_ext);
+        *count_ref = traject->th3;
+        *count_ref_ext = traject->th3_ext;
         *acceleration_ref = 0;
     }
 
-    // Split high res angle into counts and millicounts
-    as_count(mcount_ref, count_ref, count_ref_ext);
-
     // Rebase the reference before it overflows after 35 minutes
     if (time_ref - traject->t0 > (DURATION_MAX_S+120)*MS_PER_SECOND*US_PER_MS) {
         // Infinite maneuvers just maintain the same reference speed, continuing again from current time
@@ -343,7 +502,7 @@ void pbio_trajectory_get_reference(pbio_trajectory_t *traject, int32_t time_ref,
         // allowed to be this long. This just ensures that if a motor stops and holds, it will continue to
         // do so forever, by rebasing the stationary trajectory before it overflows.
         else {
-            pbio_trajectory_make_stationary(traject, time_ref, *count_ref);
+            pbio_trajectory_make_stationary(traject, time_ref, *count_ref, *count_ref_ext);
         }
 
     }
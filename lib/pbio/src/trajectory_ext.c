@@ -24,7 +24,7 @@ static pbio_error_t pbio_trajectory_patch(pbio_trajectory_t *ref, bool time_base
         err = pbio_trajectory_make_time_based(&nominal, t0, duration, th0, th0_ext, w0, wt, wmax, a, amax);    
     }
     else {
-        err = pbio_trajectory_make_angle_based(&nominal, t0, th0, th3, w0, wt, wmax, a, amax);
+        err = pbio_trajectory_make_angle_based(&nominal, t0, th0, th0_ext, th3, w0, wt, wmax, a, amax);
     }
     if (err != PBIO_SUCCESS) {
         return err;
@@ -74,7 +74,7 @@ static pbio_error_t pbio_trajectory_patch(pbio_trajectory_t *ref, bool time_base
             return pbio_trajectory_make_time_based(ref, t0, duration, th0, th0_ext, w0, wt, wmax, a, amax);
         }
         else {
-            return pbio_trajectory_make_angle_based(ref, t0, th0, th3, w0, wt, wmax, a, amax);
+            return pbio_trajectory_make_angle_based(ref, t0, th0, th0_ext, th3, w0, wt, wmax, a, amax);
         }
         
     }
@@ -47,6 +47,7 @@
 #include "pbio/event.h"
 #include "pbio/iodev.h"
 #include "pbio/port.h"
+#include "pbio/record.h"
 #include "pbio/uartdev.h"
 #include "pbio/util.h"
 #include "../drv/counter/counter.h"
@@ -208,7 +209,7 @@ enum {
     NUM_BUF
 };
 
-PROCESS(pbio_uartdev_process, "UART device");
+PROCESS_PRIO(pbio_uartdev_process, "UART device", PROCESS_PRIORITY_HIGH);
 
 static struct {
     pbio_iodev_info_t info;
@@ -682,6 +683,7 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
             data->iodev.mode = mode;
             if (mode == data->new_mode) {
                 memcpy(data->iodev.bin_data, data->rx_msg + 1, msg_size - 2);
+                _pbio_record_iodev_data(data - dev_data, mode, data->iodev.bin_data, msg_size - 2);
             }
         }
 
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/arena.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+void test_arena(void *env) {
+    pbio_arena_stats_t stats;
+
+    _pbio_arena_reset();
+    pbio_arena_get_stats(&stats);
+    tt_want_int_op(stats.size, ==, PBIO_CONFIG_ARENA_KB * 1024);
+    tt_want_int_op(stats.used, ==, 0);
+    tt_want_int_op(stats.num_free, ==, 1);
+
+    uint8_t *a = pbio_arena_alloc(1000);
+    uint8_t *b = pbio_arena_alloc(1000);
+    uint8_t *c = pbio_arena_alloc(1000);
+    tt_want(a != NULL && b != NULL && c != NULL);
+    tt_want_int_op((uintptr_t)a % 8, ==, 0);
+    tt_want_int_op((uintptr_t)b % 8, ==, 0);
+    tt_want(b >= a + 1000 && c >= b + 1000);
+    memset(a, 0xAA, 1000);
+    memset(b, 0xBB, 1000);
+    memset(c, 0xCC, 1000);
+    tt_want_int_op(b[0], ==, 0xBB);
+    tt_want_int_op(b[999], ==, 0xBB);
+
+    // Does not fit in what is left
+    tt_want(pbio_arena_alloc(2000) == NULL);
+    tt_want(pbio_arena_alloc(0) == NULL);
+
+    // A hole in the middle fragments the free space
+    pbio_arena_free(b);
+    pbio_arena_get_stats(&stats);
+    tt_want_int_op(stats.num_free, ==, 2);
+    tt_want_int_op(stats.largest_free, <, 2000);
+    uint32_t peak = stats.peak;
+    tt_want_int_op(peak, >=, 3000);
+
+    // The hole is reused
+    uint8_t *d = pbio_arena_alloc(500);
+    tt_want(d == b);
+
+    // Freeing neighbours merges them into one block
+    pbio_arena_free(d);
+    pbio_arena_free(a);
+    pbio_arena_free(c);
+    pbio_arena_free(NULL);
+    pbio_arena_get_stats(&stats);
+    tt_want_int_op(stats.used, ==, 0);
+    tt_want_int_op(stats.num_free, ==, 1);
+    tt_want_int_op(stats.peak, ==, peak);
+
+    // All memory can be allocated again
+    a = pbio_arena_alloc(stats.largest_free);
+    tt_want(a != NULL);
+    tt_want(pbio_arena_alloc(1) == NULL);
+    pbio_arena_free(a);
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/battery.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+void test_battery(void *env) {
+    _pbio_battery_reset();
+
+    // Compensation is off by default
+    _pbio_battery_update(PBIO_CONFIG_BATTERY_NOMINAL_MV / 2);
+    tt_want_int_op(pbio_battery_compensate_duty(5000), ==, 5000);
+    _pbio_battery_reset();
+    pbio_battery_set_compensation(true);
+
+    // Nothing is scaled until there is a reading
+    tt_want_int_op(pbio_battery_get_average_voltage(), ==, 0);
+    tt_want_int_op(pbio_battery_compensate_duty(5000), ==, 5000);
+
+    // The first reading is used as is
+    _pbio_battery_update(PBIO_CONFIG_BATTERY_NOMINAL_MV);
+    tt_want_int_op(pbio_battery_get_average_voltage(), ==, PBIO_CONFIG_BATTERY_NOMINAL_MV);
+    tt_want_int_op(pbio_battery_compensate_duty(5000), ==, 5000);
+    tt_want_int_op(pbio_battery_compensate_duty(-5000), ==, -5000);
+
+    // Short dips are filtered out
+    _pbio_battery_update(PBIO_CONFIG_BATTERY_NOMINAL_MV - 800);
+    tt_want_int_op(pbio_battery_get_average_voltage(), ==, PBIO_CONFIG_BATTERY_NOMINAL_MV - 100);
+
+    // A lasting drop is followed
+    for (int i = 0; i < 100; i++) {
+        _pbio_battery_update(PBIO_CONFIG_BATTERY_NOMINAL_MV * 3 / 4);
+    }
+    tt_want_int_op(pbio_battery_get_average_voltage(), ==, PBIO_CONFIG_BATTERY_NOMINAL_MV * 3 / 4);
+    tt_want_int_op(pbio_battery_compensate_duty(3000), ==, 4000);
+    tt_want_int_op(pbio_battery_compensate_duty(-3000), ==, -4000);
+
+    // A full battery reduces the duty cycle
+    for (int i = 0; i < 100; i++) {
+        _pbio_battery_update(PBIO_CONFIG_BATTERY_NOMINAL_MV * 5 / 4);
+    }
+    tt_want_int_op(pbio_battery_compensate_duty(5000), ==, 4000);
+
+    // The duty cycle is at most doubled
+    for (int i = 0; i < 100; i++) {
+        _pbio_battery_update(PBIO_CONFIG_BATTERY_NOMINAL_MV / 4);
+    }
+    tt_want_int_op(pbio_battery_compensate_duty(1000), ==, 2000);
+
+    // Turning compensation off
+    pbio_battery_set_compensation(false);
+    tt_want_int_op(pbio_battery_compensate_duty(1000), ==, 1000);
+}
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include "../drv/bluetooth/bluetooth_tx.h"
+
+// Notifications that the radio can send per connection interval
+#define NOTIFICATIONS_PER_INTERVAL (4)
+
+// Mock HCI transport that takes notifications from the queue like the drivers
+// do, and collects what would have been sent over the air.
+static struct {
+    uint32_t max_size;
+    uint8_t received[8192];
+    uint32_t num_received;
+    uint32_t num_notifications;
+} mock_hci;
+
+static void mock_hci_connection_interval(pbdrv_bluetooth_tx_queue_t *q) {
+    uint8_t packet[256];
+    for (int i = 0; i < NOTIFICATIONS_PER_INTERVAL && pbdrv_bluetooth_tx_queue_count(q); i++) {
+        uint32_t size = pbdrv_bluetooth_tx_queue_peek(q, packet, mock_hci.max_size);
+        memcpy(&mock_hci.received[mock_hci.num_received], packet, size);
+        mock_hci.num_received += size;
+        mock_hci.num_notifications++;
+        pbdrv_bluetooth_tx_queue_drop(q, size);
+    }
+}
+
+// Sends telemetry lines through the queue, returns the number of intervals
+static uint32_t send_telemetry(uint32_t max_size, uint8_t *sent, uint32_t *num_sent) {
+    static pbdrv_bluetooth_tx_queue_t q;
+    char line[32];
+    uint32_t intervals = 0;
+
+    pbdrv_bluetooth_tx_queue_reset(&q);
+    memset(&mock_hci, 0, sizeof(mock_hci));
+    mock_hci.max_size = max_size;
+    *num_sent = 0;
+
+    for (int i = 0; i < 200; i++) {
+        int len = snprintf(line, sizeof(line), "%d,%d,%d\n", i, i * 7, -i * 3);
+        uint32_t done = 0;
+        while (done < (uint32_t)len) {
+            // Writes may be partial if the queue is almost full
+            done += pbdrv_bluetooth_tx_queue_write(&q, (uint8_t *)line + done, len - done);
+            if (done < (uint32_t)len) {
+                mock_hci_connection_interval(&q);
+                intervals++;
+            }
+        }
+        memcpy(&sent[*num_sent], line, len);
+        *num_sent += len;
+    }
+    while (pbdrv_bluetooth_tx_queue_count(&q)) {
+        mock_hci_connection_interval(&q);
+        intervals++;
+    }
+    return intervals;
+}
+
+void test_bluetooth_tx_queue(void *env) {
+    static uint8_t sent[8192];
+    uint32_t num_sent;
+
+    pbdrv_bluetooth_tx_queue_t q;
+    pbdrv_bluetooth_tx_queue_reset(&q);
+
+    // One byte is always kept free
+    uint8_t data[PBDRV_CONFIG_BLUETOOTH_TX_BUF_SIZE] = { 0 };
+    tt_want_int_op(pbdrv_bluetooth_tx_queue_write(&q, data, sizeof(data)), ==, sizeof(data) - 1);
+    tt_want_int_op(pbdrv_bluetooth_tx_queue_write(&q, data, 1), ==, 0);
+    pbdrv_bluetooth_tx_queue_drop(&q, 10);
+    tt_want_int_op(pbdrv_bluetooth_tx_queue_count(&q), ==, sizeof(data) - 11);
+
+    // Disconnecting while a packet is being sent leaves nothing to drop
+    pbdrv_bluetooth_tx_queue_peek(&q, data, 20);
+    pbdrv_bluetooth_tx_queue_reset(&q);
+    pbdrv_bluetooth_tx_queue_drop(&q, 20);
+    tt_want_int_op(pbdrv_bluetooth_tx_queue_count(&q), ==, 0);
+
+    // Default MTU
+    uint32_t intervals_min = send_telemetry(PBDRV_BLUETOOTH_TX_MIN_PAYLOAD, sent, &num_sent);
+    tt_want_int_op(mock_hci.num_received, ==, num_sent);
+    tt_want(memcmp(mock_hci.received, sent, num_sent) == 0);
+
+    // Large MTU: data arrives in order, in fewer and fuller notifications
+    uint32_t intervals_max = send_telemetry(155, sent, &num_sent);
+    tt_want_int_op(mock_hci.num_received, ==, num_sent);
+    tt_want(memcmp(mock_hci.received, sent, num_sent) == 0);
+    tt_want_int_op(intervals_max * 3, <, intervals_min);
+    tt_want_int_op(mock_hci.num_notifications, <=, num_sent / 155 + 5);
+    tt_want_int_op(intervals_max, <=, 2 * num_sent / (155 * NOTIFICATIONS_PER_INTERVAL) + 5);
+}
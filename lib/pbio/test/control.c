@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/control.h>
+#include <pbio/trajectory.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+static void control_init(pbio_control_t *ctl) {
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->settings.max_rate = 1000;
+    ctl->settings.abs_acceleration = 2000;
+    ctl->settings.pid_kp = 400;
+    ctl->settings.max_control = 1000000;
+    ctl->settings.integral_range = 45;
+    ctl->settings.integral_rate = 3;
+    ctl->settings.stall_rate_limit = 2;
+    ctl->settings.stall_time = 200 * US_PER_MS;
+}
+
+// The millicounts of the reference angle are part of the proportional term
+// in angle control. In timed control, the proportional term acts on the
+// integral of the rate error, which does not have millicounts, so it must be
+// the same as without them.
+void test_control_millicounts(void *env) {
+    pbio_control_t ctl;
+    pbio_actuation_t actuation;
+    int32_t control;
+    int32_t count_ref, count_ref_ext, rate_ref, acceleration_ref;
+    int32_t num_ext = 0;
+
+    // Follow the reference exactly, so all errors are zero
+    control_init(&ctl);
+    tt_want_int_op(pbio_control_start_timed_control(&ctl, 0, 1000 * US_PER_MS, 0, 0, 333, 2000,
+        pbio_control_on_target_never, PBIO_ACTUATION_COAST), ==, PBIO_SUCCESS);
+    for (int32_t time = 0; time < 1000 * US_PER_MS; time += 7 * US_PER_MS) {
+        pbio_trajectory_get_reference(&ctl.trajectory, time, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+        control_update(&ctl, time, count_ref, rate_ref, &actuation, &control);
+        tt_want_int_op(ctl.state.err_integral, ==, 0);
+        tt_want_int_op(ctl.state.duty_proportional, ==, 0);
+        if (count_ref_ext != 0) {
+            num_ext++;
+        }
+    }
+    tt_want_int_op(num_ext, >, 0);
+
+    // With an error, only the error counts
+    control_init(&ctl);
+    tt_want_int_op(pbio_control_start_timed_control(&ctl, 0, 1000 * US_PER_MS, 0, 0, 333, 2000,
+        pbio_control_on_target_never, PBIO_ACTUATION_COAST), ==, PBIO_SUCCESS);
+    pbio_trajectory_get_reference(&ctl.trajectory, 500 * US_PER_MS, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+    tt_want_int_op(count_ref_ext, !=, 0);
+    control_update(&ctl, 500 * US_PER_MS, count_ref - 10, rate_ref, &actuation, &control);
+    tt_want_int_op(ctl.state.err_integral, ==, 10);
+    tt_want_int_op(ctl.state.duty_proportional, ==, ctl.settings.pid_kp * 10);
+
+    // In angle control, they are included
+    control_init(&ctl);
+    tt_want_int_op(pbio_control_start_angle_control(&ctl, 0, 0, 1000, 0, 333, 2000,
+        PBIO_ACTUATION_COAST), ==, PBIO_SUCCESS);
+    pbio_trajectory_get_reference(&ctl.trajectory, 500 * US_PER_MS, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+    tt_want_int_op(count_ref_ext, !=, 0);
+    control_update(&ctl, 500 * US_PER_MS, count_ref, rate_ref, &actuation, &control);
+    tt_want_int_op(ctl.state.duty_proportional, ==, ctl.settings.pid_kp * count_ref_ext / 1000);
+}
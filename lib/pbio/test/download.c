@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/download.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#define PROGRAM_SIZE (1000)
+#define NUM_BLOCKS PBIO_DOWNLOAD_NUM_BLOCKS(PROGRAM_SIZE)
+
+// Time after which the host resends a block that was not acknowledged
+#define HOST_RESEND_MS (50)
+
+// Loopback stand-in for stdin and stdout of the hub
+static struct {
+    uint8_t data[4096];
+    uint32_t head;
+    uint32_t tail;
+} hub_stdin, hub_stdout;
+
+static pbio_error_t loopback_get_char(uint8_t *c) {
+    if (hub_stdin.tail == hub_stdin.head) {
+        return PBIO_ERROR_AGAIN;
+    }
+    *c = hub_stdin.data[hub_stdin.tail++ % sizeof(hub_stdin.data)];
+    return PBIO_SUCCESS;
+}
+
+static pbio_error_t loopback_put_char(uint8_t c) {
+    hub_stdout.data[hub_stdout.head++ % sizeof(hub_stdout.data)] = c;
+    return PBIO_SUCCESS;
+}
+
+// Simulated host with a sliding window of unacknowledged blocks
+static struct {
+    const uint8_t *program;
+    bool acked[NUM_BLOCKS];
+    int32_t sent_time[NUM_BLOCKS];
+    uint32_t num_sent;
+    int32_t corrupt_seq;
+    int32_t drop_seq;
+} host;
+
+static void host_send_block(uint32_t seq, uint32_t time_now) {
+    uint8_t frame[PBIO_DOWNLOAD_BLOCK_SIZE + 6];
+    uint32_t data_len = PROGRAM_SIZE - seq * PBIO_DOWNLOAD_BLOCK_SIZE;
+    if (data_len > PBIO_DOWNLOAD_BLOCK_SIZE) {
+        data_len = PBIO_DOWNLOAD_BLOCK_SIZE;
+    }
+    frame[0] = seq >> 8;
+    frame[1] = seq;
+    memcpy(&frame[2], &host.program[seq * PBIO_DOWNLOAD_BLOCK_SIZE], data_len);
+    uint32_t crc = pbio_download_crc32(0xFFFFFFFF, frame, data_len + 2);
+    frame[data_len + 2] = crc >> 24;
+    frame[data_len + 3] = crc >> 16;
+    frame[data_len + 4] = crc >> 8;
+    frame[data_len + 5] = crc;
+
+    // Damage the first attempt of some blocks
+    if ((int32_t)seq == host.corrupt_seq) {
+        frame[10] ^= 0x40;
+        host.corrupt_seq = -1;
+    }
+    for (uint32_t i = 0; i < data_len + 6; i++) {
+        if ((int32_t)seq == host.drop_seq && i == 20) {
+            host.drop_seq = -1;
+            continue;
+        }
+        hub_stdin.data[hub_stdin.head++ % sizeof(hub_stdin.data)] = frame[i];
+    }
+    host.sent_time[seq] = time_now;
+    host.num_sent++;
+}
+
+static void host_update(uint32_t window, uint32_t time_now) {
+
+    // Process replies from the hub
+    while (hub_stdout.head - hub_stdout.tail >= 3) {
+        uint8_t type = hub_stdout.data[hub_stdout.tail++ % sizeof(hub_stdout.data)];
+        uint32_t seq = hub_stdout.data[hub_stdout.tail++ % sizeof(hub_stdout.data)] << 8;
+        seq |= hub_stdout.data[hub_stdout.tail++ % sizeof(hub_stdout.data)];
+        if (type == PBIO_DOWNLOAD_ACK) {
+            host.acked[seq] = true;
+        } else if (type == PBIO_DOWNLOAD_NAK && seq < NUM_BLOCKS) {
+            host_send_block(seq, time_now);
+        }
+    }
+
+    // Send new blocks, or resend old ones, while the window is not full
+    uint32_t in_flight = 0;
+    for (uint32_t seq = 0; seq < NUM_BLOCKS && in_flight < window; seq++) {
+        if (host.acked[seq]) {
+            continue;
+        }
+        if (host.sent_time[seq] < 0 || time_now - host.sent_time[seq] >= HOST_RESEND_MS) {
+            host_send_block(seq, time_now);
+        }
+        in_flight++;
+    }
+}
+
+static pbio_error_t run_download(uint8_t *buf, uint32_t window, uint32_t *duration) {
+    uint8_t program[PROGRAM_SIZE];
+    uint8_t received[PBIO_DOWNLOAD_RECEIVED_SIZE(PROGRAM_SIZE)];
+    pbio_download_t dl;
+    pbio_error_t err;
+
+    for (int i = 0; i < PROGRAM_SIZE; i++) {
+        program[i] = i * 7 + (i >> 8);
+    }
+    host.program = program;
+    for (int i = 0; i < NUM_BLOCKS; i++) {
+        host.acked[i] = false;
+        host.sent_time[i] = -1;
+    }
+    host.num_sent = 0;
+    hub_stdin.head = hub_stdin.tail = 0;
+    hub_stdout.head = hub_stdout.tail = 0;
+
+    uint32_t time_now = 0;
+    pbio_download_init(&dl, buf, PROGRAM_SIZE, received, time_now);
+
+    do {
+        if (window > 0) {
+            host_update(window, time_now);
+        }
+        err = pbio_download_poll(&dl, loopback_get_char, loopback_put_char, time_now);
+        time_now++;
+    } while (err == PBIO_ERROR_AGAIN);
+
+    *duration = time_now;
+
+    if (err == PBIO_SUCCESS && memcmp(buf, program, PROGRAM_SIZE) != 0) {
+        return PBIO_ERROR_FAILED;
+    }
+    return err;
+}
+
+void test_download(void *env) {
+    uint8_t buf[PROGRAM_SIZE];
+    uint32_t duration;
+
+    // Check against the CRC-32/MPEG-2 check value
+    tt_want_int_op(pbio_download_crc32(0xFFFFFFFF, (const uint8_t *)"123456789", 9), ==, 0x0376E6E7);
+
+    // Without errors, each block is sent once
+    host.corrupt_seq = host.drop_seq = -1;
+    tt_want_int_op(run_download(buf, 4, &duration), ==, PBIO_SUCCESS);
+    tt_want_int_op(host.num_sent, ==, NUM_BLOCKS);
+
+    // A corrupted block and a block with a missing byte are resent
+    host.corrupt_seq = 3;
+    host.drop_seq = 7;
+    tt_want_int_op(run_download(buf, 4, &duration), ==, PBIO_SUCCESS);
+    tt_want_int_op(host.num_sent, >, NUM_BLOCKS);
+    tt_want_int_op(host.corrupt_seq, ==, -1);
+    tt_want_int_op(host.drop_seq, ==, -1);
+
+    // The same works without a window
+    host.corrupt_seq = 0;
+    host.drop_seq = NUM_BLOCKS - 1;
+    tt_want_int_op(run_download(buf, 1, &duration), ==, PBIO_SUCCESS);
+
+    // Give up if the host sends nothing
+    tt_want_int_op(run_download(buf, 0, &duration), ==, PBIO_ERROR_TIMEDOUT);
+    tt_want_int_op(duration, ==, PBIO_DOWNLOAD_TIMEOUT_MS + 1);
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <fixmath.h>
+
+#include <pbio/follow.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+void test_follow_ratio(void *env) {
+    pbio_follow_t f = { .ratio = F16(2), .offset = 100 };
+    int32_t count, count_ext, rate;
+
+    // The follower tracks ratio * leader + offset
+    pbio_follow_get_reference(&f, 50, 300, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 200);
+    tt_want_int_op(count_ext, ==, 0);
+    tt_want_int_op(rate, ==, 600);
+
+    pbio_follow_get_reference(&f, -70, -300, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, -40);
+    tt_want_int_op(count_ext, ==, 0);
+    tt_want_int_op(rate, ==, -600);
+
+    // Fractions of a count are kept in millicounts, in the same direction
+    // as the count for negative leader counts
+    f.ratio = F16(1) / 3;
+    f.offset = 0;
+    pbio_follow_get_reference(&f, 100, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 33);
+    tt_want_int_op(count_ext, ==, 332);
+    pbio_follow_get_reference(&f, -100, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, -33);
+    tt_want_int_op(count_ext, ==, -333);
+}
+
+void test_follow_cam(void *env) {
+    pbio_follow_t f = {
+        .cam_period = 400,
+        .cam_size = 4,
+        .cam = { 0, 100, 0, -100 },
+    };
+    int32_t count, count_ext, rate;
+
+    // Points of the profile are reached at equally spaced leader counts
+    pbio_follow_get_reference(&f, 100, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 100);
+    pbio_follow_get_reference(&f, 300, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, -100);
+
+    // In between, the profile is interpolated linearly
+    pbio_follow_get_reference(&f, 50, 200, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 50);
+    tt_want_int_op(count_ext, ==, 0);
+    tt_want_int_op(rate, ==, 200);
+    pbio_follow_get_reference(&f, 150, 200, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 50);
+    tt_want_int_op(rate, ==, -200);
+    pbio_follow_get_reference(&f, 101, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 99);
+    tt_want_int_op(count_ext, ==, 0);
+
+    // The last point wraps around to the first one
+    pbio_follow_get_reference(&f, 350, 200, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, -50);
+    tt_want_int_op(rate, ==, 200);
+
+    // The profile repeats, also for negative leader counts
+    pbio_follow_get_reference(&f, 450, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 50);
+    pbio_follow_get_reference(&f, -50, 200, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, -50);
+    tt_want_int_op(rate, ==, 200);
+    pbio_follow_get_reference(&f, -400, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 0);
+
+    // The profile adds to the geared position
+    f.ratio = F16(1);
+    f.offset = 1000;
+    pbio_follow_get_reference(&f, -350, 200, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 1000 - 350 + 50);
+    tt_want_int_op(rate, ==, 400);
+}
+
+void test_follow_relative(void *env) {
+    pbio_follow_t f = { .ratio = F16(2), .offset = 0 };
+    int32_t count, count_ext, rate;
+
+    // The follower starts where it is now and moves from there
+    pbio_follow_set_relative(&f, 30, 500);
+    pbio_follow_get_reference(&f, 30, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 500);
+    pbio_follow_get_reference(&f, 40, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 520);
+    pbio_follow_get_reference(&f, -20, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 400);
+
+    // Same with a cam profile, starting in the middle of it
+    pbio_follow_t c = {
+        .ratio = 0,
+        .offset = 0,
+        .cam_period = 400,
+        .cam_size = 4,
+        .cam = { 0, 100, 0, -100 },
+    };
+    pbio_follow_set_relative(&c, -350, -10);
+    pbio_follow_get_reference(&c, -350, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, -10);
+    pbio_follow_get_reference(&c, -300, 0, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 40);
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/i2c.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#define DEVICE_ADDRESS (0x68)
+
+// In-memory model of a device with 256 registers and an auto-incrementing
+// register pointer, like most I2C sensors.
+static struct {
+    uint8_t regs[256];
+    uint8_t pointer;
+    uint32_t num_transfers;
+    uint32_t num_msgs;
+    pbio_error_t err;
+} model;
+
+static pbio_error_t model_transfer(void *context, pbio_i2c_msg_t *msgs, uint32_t num_msgs) {
+    model.num_transfers++;
+
+    if (model.err != PBIO_SUCCESS) {
+        return model.err;
+    }
+
+    for (uint32_t i = 0; i < num_msgs; i++) {
+        pbio_i2c_msg_t *msg = &msgs[i];
+        model.num_msgs++;
+        if (msg->address != DEVICE_ADDRESS) {
+            return PBIO_ERROR_IO;
+        }
+        if (msg->flags & PBIO_I2C_MSG_READ) {
+            for (uint16_t j = 0; j < msg->len; j++) {
+                msg->buf[j] = model.regs[model.pointer++];
+            }
+        } else if (msg->len > 0) {
+            model.pointer = msg->buf[0];
+            for (uint16_t j = 1; j < msg->len; j++) {
+                model.regs[model.pointer++] = msg->buf[j];
+            }
+        }
+    }
+    return PBIO_SUCCESS;
+}
+
+void test_i2c(void *env) {
+    pbio_i2c_dev_t dev;
+    pbio_i2c_batch_t batch;
+    uint8_t accel[6], gyro[6], id[2], cal[4];
+
+    for (int i = 0; i < 256; i++) {
+        model.regs[i] = i;
+    }
+
+    pbio_i2c_dev_init(&dev, model_transfer, NULL, DEVICE_ADDRESS);
+    pbio_i2c_batch_init(&batch, &dev);
+
+    // Two reads and a write all go in one transaction
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x3B, accel, sizeof(accel)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x43, gyro, sizeof(gyro)), ==, PBIO_SUCCESS);
+    uint8_t config[2] = { 0xAA, 0xBB };
+    tt_want_int_op(pbio_i2c_batch_write(&batch, 0x1A, config, sizeof(config)), ==, PBIO_SUCCESS);
+    config[0] = 0; // data was copied
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 1);
+    tt_want_int_op(model.num_msgs, ==, 5);
+    tt_want_int_op(accel[0], ==, 0x3B);
+    tt_want_int_op(accel[5], ==, 0x40);
+    tt_want_int_op(gyro[0], ==, 0x43);
+    tt_want_int_op(model.regs[0x1A], ==, 0xAA);
+    tt_want_int_op(model.regs[0x1B], ==, 0xBB);
+
+    // Cached blocks are read once, and parts of them come from the cache too
+    tt_want_int_op(pbio_i2c_dev_set_cached(&dev, 0x75, 2), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_dev_set_cached(&dev, 0x10, 4), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x75, id, sizeof(id)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x10, cal, sizeof(cal)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 2);
+    tt_want_int_op(id[1], ==, 0x76);
+
+    model.regs[0x75] = 0x00;
+    memset(id, 0, sizeof(id));
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x75, id, sizeof(id)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x11, cal, 2), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 2);
+    tt_want_int_op(id[0], ==, 0x75);
+    tt_want_int_op(cal[0], ==, 0x11);
+    tt_want_int_op(cal[1], ==, 0x12);
+
+    // Writing to a cached block makes it read from the device again
+    uint8_t zero = 0;
+    tt_want_int_op(pbio_i2c_batch_write(&batch, 0x76, &zero, 1), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x75, id, sizeof(id)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 3);
+    tt_want_int_op(id[0], ==, 0x00);
+
+    // A read of a cached block followed by a write to it in the same batch
+    // returns the old values, but does not store them
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x75, id, sizeof(id)), ==, PBIO_SUCCESS);
+    uint8_t ids[2] = { 0x12, 0x34 };
+    tt_want_int_op(pbio_i2c_batch_write(&batch, 0x75, ids, sizeof(ids)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 4);
+    tt_want_int_op(id[0], ==, 0x00);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x75, id, sizeof(id)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 5);
+    tt_want_int_op(id[0], ==, 0x12);
+    tt_want_int_op(id[1], ==, 0x34);
+
+    // Writes outside of a batch, like I2CDevice.write(), clear the cache too
+    model.regs[0x76] = 0x56;
+    pbio_i2c_dev_invalidate(&dev, 0x76, 1);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x75, id, sizeof(id)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 6);
+    tt_want_int_op(id[1], ==, 0x56);
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x75, id, sizeof(id)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 6);
+
+    // Failed transfers don't fill the cache
+    tt_want_int_op(pbio_i2c_batch_write(&batch, 0x10, &zero, 1), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    model.err = PBIO_ERROR_IO;
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x10, cal, sizeof(cal)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_ERROR_IO);
+    model.err = PBIO_SUCCESS;
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x10, cal, sizeof(cal)), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_batch_submit(&batch), ==, PBIO_SUCCESS);
+    tt_want_int_op(model.num_transfers, ==, 9);
+
+    // Limits
+    tt_want_int_op(pbio_i2c_batch_read(&batch, 0x00, accel, 0), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_i2c_dev_set_cached(&dev, 0xFF, 2), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_i2c_dev_set_cached(&dev, 0x20, 1), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_dev_set_cached(&dev, 0x30, 1), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_i2c_dev_set_cached(&dev, 0x40, 1), ==, PBIO_ERROR_INVALID_OP);
+    uint32_t count = 0;
+    while (pbio_i2c_batch_read(&batch, 0x50, accel, 1) == PBIO_SUCCESS) {
+        count++;
+    }
+    tt_want_int_op(count, ==, PBIO_I2C_MAX_MSGS / 2);
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/arena.h>
+#include <pbio/config.h>
+#include <pbio/logger.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+// Number of values in servo and drive base logs
+#define NUM_VALUES (16)
+
+// Duration in ms of a log with the given number of samples
+#define DURATION(len, div) ((len) * PBIO_CONFIG_SERVO_PERIOD_MS * (div))
+
+void test_logger_capacity(void *env) {
+    pbio_log_t a = { .num_values = NUM_VALUES };
+    pbio_log_t b = { .num_values = NUM_VALUES };
+    int32_t buf[MAX_LOG_VALUES] = { 0 };
+
+    _pbio_arena_reset();
+
+    // Just under 16 samples per KB fit in the arena
+    int32_t max_len = PBIO_CONFIG_ARENA_KB * 16 - 1;
+    tt_want_int_op(pbio_logger_start(&a, DURATION(max_len + 1, 1), 1), ==, PBIO_ERROR_FAILED);
+    tt_want_int_op(pbio_logger_start(&a, DURATION(max_len, 1), 1), ==, PBIO_SUCCESS);
+
+    // The log holds that many samples and then stops
+    for (int32_t i = 0; i < max_len + 10; i++) {
+        tt_want_int_op(pbio_logger_update(&a, buf), ==, PBIO_SUCCESS);
+    }
+    tt_want_int_op(pbio_logger_rows(&a), ==, max_len);
+    tt_want_int_op(pbio_logger_read(&a, max_len - 1, buf), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_logger_read(&a, max_len, buf), ==, PBIO_ERROR_INVALID_ARG);
+
+    // A larger divisor logs for longer in the same memory
+    tt_want_int_op(pbio_logger_start(&a, DURATION(max_len, 10), 10), ==, PBIO_SUCCESS);
+
+    // Logs share the arena
+    tt_want_int_op(pbio_logger_start(&a, DURATION(max_len / 2, 1), 1), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_logger_start(&b, DURATION(max_len / 2 + 2, 1), 1), ==, PBIO_ERROR_FAILED);
+    tt_want_int_op(pbio_logger_start(&b, DURATION(max_len / 2, 1), 1), ==, PBIO_SUCCESS);
+}
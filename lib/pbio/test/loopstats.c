@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/loopstats.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+void test_loopstats_add(void *env) {
+    pbio_loopstats_t stats;
+    pbio_loopstats_clear(&stats);
+
+    tt_want_int_op(stats.count, ==, 0);
+    tt_want_int_op(pbio_loopstats_get_mean(&stats), ==, 0);
+
+    pbio_loopstats_add(&stats, 0);
+    pbio_loopstats_add(&stats, 1);
+    pbio_loopstats_add(&stats, 3);
+    pbio_loopstats_add(&stats, 6000);
+    pbio_loopstats_add(&stats, UINT32_MAX);
+
+    tt_want_int_op(stats.count, ==, 5);
+    tt_want_int_op(stats.min, ==, 0);
+    tt_want_int_op(stats.max, ==, UINT32_MAX);
+    tt_want_int_op(pbio_loopstats_get_mean(&stats), ==, ((uint64_t)UINT32_MAX + 6004) / 5);
+
+    // Samples are binned by their most significant bit
+    tt_want_int_op(stats.bins[0], ==, 2);
+    tt_want_int_op(stats.bins[1], ==, 1);
+    tt_want_int_op(stats.bins[12], ==, 1);
+
+    // Long samples all end up in the last bin
+    tt_want_int_op(stats.bins[PBIO_LOOPSTATS_NUM_BINS - 1], ==, 1);
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/mailbox.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+// Message for mailbox "abc" with payload 0x01, as sent by the EV3 firmware
+static const uint8_t logic_msg[] = {
+    0x0C, 0x00, 0x01, 0x00, 0x81, 0x9E, 0x04, 'a', 'b', 'c', 0x00, 0x01, 0x00, 0x01,
+};
+
+void test_mailbox(void *env) {
+    uint8_t msg[64];
+    size_t msg_len;
+
+    // Encoding matches the EV3 firmware
+    tt_want_int_op(pbio_mailbox_encode(msg, sizeof(msg), "abc", 3, (const uint8_t *)"\x01", 1, &msg_len), ==, PBIO_SUCCESS);
+    tt_want_int_op(msg_len, ==, sizeof(logic_msg));
+    tt_want(memcmp(msg, logic_msg, sizeof(logic_msg)) == 0);
+    tt_want_int_op(pbio_mailbox_encode(msg, 10, "abc", 3, (const uint8_t *)"\x01", 1, &msg_len), ==, PBIO_ERROR_INVALID_ARG);
+
+    pbio_mailbox_decoder_t dec;
+    pbio_mailbox_msg_t m;
+    uint8_t buf[32];
+    uint8_t *space;
+    size_t size;
+    pbio_mailbox_decoder_init(&dec, buf, sizeof(buf));
+
+    // Data arrives one byte at a time, and then two messages at once
+    tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_ERROR_AGAIN);
+    for (size_t i = 0; i < sizeof(logic_msg) - 1; i++) {
+        space = pbio_mailbox_decoder_get_space(&dec, &size);
+        *space = logic_msg[i];
+        pbio_mailbox_decoder_commit(&dec, 1);
+        tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_ERROR_AGAIN);
+    }
+    space = pbio_mailbox_decoder_get_space(&dec, &size);
+    *space = logic_msg[sizeof(logic_msg) - 1];
+    pbio_mailbox_decoder_commit(&dec, 1);
+    tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_SUCCESS);
+    tt_want_int_op(m.name_len, ==, 3);
+    tt_want(memcmp(m.name, "abc", 3) == 0);
+    tt_want_int_op(m.payload_len, ==, 1);
+    tt_want_int_op(m.payload[0], ==, 0x01);
+
+    pbio_mailbox_encode(msg, sizeof(msg), "xy", 2, (const uint8_t *)"hi\0", 3, &msg_len);
+    space = pbio_mailbox_decoder_get_space(&dec, &size);
+    tt_want_int_op(size, ==, sizeof(buf));
+    memcpy(space, msg, msg_len);
+    memcpy(space + msg_len, logic_msg, 4);
+    pbio_mailbox_decoder_commit(&dec, msg_len + 4);
+    tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_SUCCESS);
+    tt_want_int_op(m.name_len, ==, 2);
+    tt_want_int_op(m.payload_len, ==, 3);
+    tt_want(memcmp(m.payload, "hi\0", 3) == 0);
+    tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_ERROR_AGAIN);
+
+    // Messages that don't fit in the buffer or have bad headers are errors
+    pbio_mailbox_decoder_init(&dec, buf, sizeof(buf));
+    space = pbio_mailbox_decoder_get_space(&dec, &size);
+    memcpy(space, "\x40\x00", 2);
+    pbio_mailbox_decoder_commit(&dec, 2);
+    tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_ERROR_IO);
+
+    pbio_mailbox_decoder_init(&dec, buf, sizeof(buf));
+    space = pbio_mailbox_decoder_get_space(&dec, &size);
+    memcpy(space, logic_msg, sizeof(logic_msg));
+    space[5] = 0x9F;
+    pbio_mailbox_decoder_commit(&dec, sizeof(logic_msg));
+    tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_ERROR_IO);
+
+    pbio_mailbox_decoder_init(&dec, buf, sizeof(buf));
+    space = pbio_mailbox_decoder_get_space(&dec, &size);
+    memcpy(space, logic_msg, sizeof(logic_msg));
+    space[11] = 0x05;
+    pbio_mailbox_decoder_commit(&dec, sizeof(logic_msg));
+    tt_want_int_op(pbio_mailbox_decoder_next(&dec, &m), ==, PBIO_ERROR_IO);
+}
@@ -1,5 +1,6 @@
 
 #include <stdio.h>
+#include <time.h>
 
 #include <pbio/math.h>
 
@@ -13,6 +14,13 @@ void test_sqrt(void *env) {
     tt_want(pbio_math_sqrt(400) == 20);
     tt_want(pbio_math_sqrt(40000) == 200);
     tt_want(pbio_math_sqrt(400000000) == 20000);
+
+    // Result is always rounded down
+    for (int64_t n = 1; n <= INT32_MAX; n += n / 1000 + 1) {
+        int64_t r = pbio_math_sqrt(n);
+        tt_want(r * r <= n && (r + 1) * (r + 1) > n);
+    }
+    tt_want_int_op(pbio_math_sqrt(INT32_MAX), ==, 46340);
 }
 
 void test_mul_i32_fix16(void *env) {
@@ -64,3 +72,174 @@ void test_div_i32_fix16(void *env) {
     tt_want_int_op(pbio_math_div_i32_fix16(-INT32_MAX, F16(-1.0)), ==, INT32_MAX);
     tt_want_int_op(pbio_math_div_i32_fix16(INT32_MIN, F16(-1.0)), ==, INT32_MIN); // overflow!
 }
+
+#define TEST_PI (3.14159265358979323846)
+
+// Double precision sine of an angle in radians, valid for |x| <= pi
+static double ref_sin(double x) {
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 15; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// Double precision sine of an angle in degrees
+static double ref_sin_deg(double deg) {
+    while (deg > 180) {
+        deg -= 360;
+    }
+    while (deg < -180) {
+        deg += 360;
+    }
+    return ref_sin(deg * TEST_PI / 180);
+}
+
+// Double precision square root
+static double ref_sqrt(double x) {
+    double r = x > 1 ? x : 1;
+    for (int i = 0; i < 50; i++) {
+        r = (r + x / r) / 2;
+    }
+    return r;
+}
+
+// Double precision arctangent in degrees, valid for 0 <= t <= 1
+static double ref_atan_deg(double t) {
+    // Halve the angle twice so the series converges quickly
+    t = t / (1 + ref_sqrt(1 + t * t));
+    t = t / (1 + ref_sqrt(1 + t * t));
+    double term = t;
+    double sum = t;
+    for (int i = 1; i < 30; i++) {
+        term *= -t * t;
+        sum += term / (2 * i + 1);
+    }
+    return sum * 4 * 180 / TEST_PI;
+}
+
+void test_sin_cos_deg(void *env) {
+    int32_t max_err = 0;
+
+    for (fix16_t angle = F16(-720.0); angle <= F16(720.0); angle += 331) {
+        double deg = angle / 65536.0;
+        int32_t err_sin = pbio_math_sin_deg(angle) - (int32_t)(ref_sin_deg(deg) * 65536.0);
+        int32_t err_cos = pbio_math_cos_deg(angle) - (int32_t)(ref_sin_deg(deg + 90) * 65536.0);
+        err_sin = err_sin < 0 ? -err_sin : err_sin;
+        err_cos = err_cos < 0 ? -err_cos : err_cos;
+        max_err = err_sin > max_err ? err_sin : max_err;
+        max_err = err_cos > max_err ? err_cos : max_err;
+    }
+    tt_want_int_op(max_err, <=, 4);
+
+    // Exact values at multiples of 90 degrees, also for extreme arguments
+    tt_want_int_op(pbio_math_sin_deg(F16(0.0)), ==, 0);
+    tt_want_int_op(pbio_math_sin_deg(F16(90.0)), ==, fix16_one);
+    tt_want_int_op(pbio_math_sin_deg(F16(180.0)), ==, 0);
+    tt_want_int_op(pbio_math_sin_deg(F16(-90.0)), ==, -fix16_one);
+    tt_want_int_op(pbio_math_cos_deg(F16(0.0)), ==, fix16_one);
+    tt_want_int_op(pbio_math_cos_deg(F16(180.0)), ==, -fix16_one);
+    tt_want_int_op(pbio_math_cos_deg(F16(-270.0)), ==, 0);
+    tt_want_int_op(pbio_math_sin_deg(F16(32400.0)), ==, 0);
+    tt_want_int_op(pbio_math_cos_deg(fix16_maximum), ==, pbio_math_cos_deg(fix16_maximum - F16(32400.0)));
+}
+
+void test_atan2_deg(void *env) {
+    int32_t max_err = 0;
+
+    // Points on a circle in all octants, including the axes
+    for (int32_t i = 0; i < 3600; i++) {
+        double deg = i / 10.0 - 179.9;
+        int32_t x = (int32_t)(ref_sin_deg(deg + 90) * 100000);
+        int32_t y = (int32_t)(ref_sin_deg(deg) * 100000);
+
+        // Exact angle of the rounded point
+        double ax = x < 0 ? -x : x;
+        double ay = y < 0 ? -y : y;
+        double ref = ay > ax ? 90 - ref_atan_deg(ax / ay) : ref_atan_deg(ay / ax);
+        ref = x < 0 ? 180 - ref : ref;
+        ref = y < 0 ? -ref : ref;
+
+        int32_t err = pbio_math_atan2_deg(y, x) - (int32_t)(ref * 65536.0);
+        err = err < 0 ? -err : err;
+        max_err = err > max_err ? err : max_err;
+    }
+    // About 0.002 degree
+    tt_want_int_op(max_err, <=, 128);
+
+    tt_want_int_op(pbio_math_atan2_deg(0, 0), ==, 0);
+    tt_want_int_op(pbio_math_atan2_deg(0, 1), ==, 0);
+    tt_want_int_op(pbio_math_atan2_deg(1, 0), ==, F16(90.0));
+    tt_want_int_op(pbio_math_atan2_deg(0, -1), ==, F16(180.0));
+    tt_want_int_op(pbio_math_atan2_deg(-1, 0), ==, F16(-90.0));
+    tt_want_int_op(pbio_math_atan2_deg(5, 5), ==, F16(45.0));
+    tt_want_int_op(pbio_math_atan2_deg(-5, -5), ==, F16(-135.0));
+    tt_want_int_op(pbio_math_atan2_deg(INT32_MIN, INT32_MIN), ==, F16(-135.0));
+    tt_want_int_op(pbio_math_atan2_deg(INT32_MAX, -INT32_MAX), ==, F16(135.0));
+}
+
+void test_scale(void *env) {
+    const fix16_t scales[] = {F16(1.0), F16(2.0), F16(0.5), F16(3.0), F16(-1.5), F16(1.0 / 7), F16(24.0 * 12 / 36), F16(1234.5)};
+    const int32_t values[] = {0, 1, -1, 7, -360, 12345, -99999, 1000000, INT32_MAX / 4};
+
+    // Results are identical to the uncached operations
+    for (size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+        pbio_math_scale_t scale;
+        pbio_math_scale_set(&scale, scales[i]);
+        tt_want_int_op(scale.scale, ==, scales[i]);
+        for (size_t j = 0; j < sizeof(values) / sizeof(values[0]); j++) {
+            tt_want_int_op(pbio_math_scale_div(&scale, values[j]), ==, pbio_math_div_i32_fix16(values[j], scales[i]));
+            if (scales[i] < F16(2.0) && scales[i] > F16(-2.0)) {
+                tt_want_int_op(pbio_math_scale_mul(&scale, values[j]), ==, pbio_math_mul_i32_fix16(values[j], scales[i]));
+            }
+        }
+    }
+}
+
+static int64_t elapsed_ns(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+// Time per call of each function. This only gives relative numbers on the
+// host, but it helps to spot regressions.
+void test_math_benchmark(void *env) {
+    const int32_t n = 1000000;
+    volatile int32_t sink = 0;
+    struct timespec start;
+    pbio_math_scale_t scale;
+    pbio_math_scale_set(&scale, F16(24.0 * 12 / 36));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < n; i++) {
+        sink += pbio_math_sqrt(i * 2047);
+    }
+    printf("sqrt: %d ns\n", (int)(elapsed_ns(&start) / n));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < n; i++) {
+        sink += pbio_math_sin_deg(i * 4099);
+    }
+    printf("sin_deg: %d ns\n", (int)(elapsed_ns(&start) / n));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < n; i++) {
+        sink += pbio_math_atan2_deg(i - n / 2, (i * 7) % 1001 - 500);
+    }
+    printf("atan2_deg: %d ns\n", (int)(elapsed_ns(&start) / n));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < n; i++) {
+        sink += pbio_math_div_i32_fix16(i, scale.scale);
+    }
+    printf("div_i32_fix16: %d ns\n", (int)(elapsed_ns(&start) / n));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < n; i++) {
+        sink += pbio_math_scale_div(&scale, i);
+    }
+    printf("scale_div: %d ns\n", (int)(elapsed_ns(&start) / n));
+}
@@ -3,3 +3,5 @@
 #define PBDRV_CONFIG_COUNTER_NUM_DEV                (1)
 
 #define PBDRV_CONFIG_UART                           (1)
+
+#define PBDRV_CONFIG_NUM_MOTOR_CONTROLLER           (0)
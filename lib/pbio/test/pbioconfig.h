@@ -1,2 +1,7 @@
+#define PBIO_CONFIG_ARENA_KB                (4)
+#define PBIO_CONFIG_BATTERY_COMPENSATION    (1)
+#define PBIO_CONFIG_BATTERY_NOMINAL_MV      (7200)
 #define PBIO_CONFIG_UARTDEV                 (1)
 #define PBIO_CONFIG_UARTDEV_NUM_DEV         (1)
+#define PBIO_CONFIG_RECORD                  (1)
+#define PBIO_CONFIG_LOOPSTATS               (1)
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <contiki.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+// Time that each flood event keeps the processor busy
+#define FLOOD_EVENT_US (100)
+
+#define NUM_TICKS (20)
+
+// Number of flood events handled so far
+static uint32_t flood_count;
+
+// The flood event during which the tick is posted, like an interrupt would
+static uint32_t tick_trigger;
+
+// Time at which the tick was posted, and when it was handled
+static unsigned long tick_posted;
+static unsigned long tick_latency;
+static uint32_t tick_flood_count;
+static bool tick_done;
+
+PROCESS(flood_process, "flood");
+PROCESS_PRIO(tick_process, "tick", PROCESS_PRIORITY_HIGH);
+
+PROCESS_THREAD(flood_process, ev, data) {
+    PROCESS_BEGIN();
+
+    for (;;) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
+        unsigned long start = clock_usecs();
+        while (clock_usecs() - start < FLOOD_EVENT_US / 2) {
+        }
+        if (flood_count == tick_trigger) {
+            tick_posted = clock_usecs();
+            process_post(&tick_process, PROCESS_EVENT_CONTINUE, NULL);
+        }
+        while (clock_usecs() - start < FLOOD_EVENT_US) {
+        }
+        flood_count++;
+    }
+
+    PROCESS_END();
+}
+
+PROCESS_THREAD(tick_process, ev, data) {
+    PROCESS_BEGIN();
+
+    for (;;) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
+        tick_latency = clock_usecs() - tick_posted;
+        tick_flood_count = flood_count;
+        tick_done = true;
+    }
+
+    PROCESS_END();
+}
+
+// Measures how long a high priority event waits while the normal event
+// queue is kept full by another process. The tick is posted halfway through
+// one of the queued events, so it should only have to wait for the rest of
+// that event, not for the whole queue.
+void test_process_priority(void *env) {
+    unsigned long worst = 0;
+
+    process_init();
+    process_start(&flood_process, NULL);
+    process_start(&tick_process, NULL);
+
+    for (int i = 0; i < NUM_TICKS; i++) {
+
+        // Flood the normal priority queue
+        uint32_t num_flood = 0;
+        while (process_post(&flood_process, PROCESS_EVENT_CONTINUE, NULL) == PROCESS_ERR_OK) {
+            num_flood++;
+        }
+
+        // Post the tick during a different flood event each time
+        tick_done = false;
+        tick_trigger = flood_count + i % num_flood;
+        while (!tick_done) {
+            tt_int_op(process_run(), >, 0);
+        }
+
+        // The tick must be handled right after the event that posted it
+        tt_want_int_op(tick_flood_count, ==, tick_trigger + 1);
+        if (tick_latency > worst) {
+            worst = tick_latency;
+        }
+
+        // Drain the rest of the flood
+        while (process_run()) {
+        }
+    }
+
+    // Handling the whole queue first would take PROCESS_CONF_NUMEVENTS times
+    // as long. The margin is for a busy test machine.
+    tt_want_int_op(worst, <, FLOOD_EVENT_US * 5);
+
+end:
+    process_exit(&tick_process);
+    process_exit(&flood_process);
+}
+
+static bool busy;
+static bool timer_fired;
+
+PROCESS_PRIO(busy_process, "busy", PROCESS_PRIORITY_HIGH);
+PROCESS(timer_process, "timer");
+
+PROCESS_THREAD(busy_process, ev, data) {
+    PROCESS_POLLHANDLER(if (busy) {
+        process_poll(&busy_process);
+    });
+
+    PROCESS_BEGIN();
+
+    process_poll(&busy_process);
+    PROCESS_WAIT_UNTIL(!busy);
+
+    PROCESS_END();
+}
+
+PROCESS_THREAD(timer_process, ev, data) {
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    etimer_set(&timer, 0);
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER && etimer_expired(&timer));
+    timer_fired = true;
+
+    PROCESS_END();
+}
+
+// A high priority process that always has work to do must not keep event
+// timers, which are handled in the normal class, from expiring.
+void test_process_starvation(void *env) {
+    process_init();
+    process_start(&etimer_process, NULL);
+
+    busy = true;
+    timer_fired = false;
+    process_start(&busy_process, NULL);
+    process_start(&timer_process, NULL);
+
+    int runs = 0;
+    while (!timer_fired && runs < 100) {
+        process_run();
+        runs++;
+    }
+    tt_want(timer_fired);
+    tt_want_int_op(runs, <=, PROCESS_CONF_MAX_SKIPPED + 1);
+
+    busy = false;
+    process_exit(&busy_process);
+    process_exit(&timer_process);
+    process_exit(&etimer_process);
+}
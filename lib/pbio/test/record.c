@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pbio/control.h>
+#include <pbio/record.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#define CHANNEL PBIO_RECORD_CHANNEL_DRIVEBASE
+#define NUM_UPDATES 10
+
+// One update like the servo does it: read the state, compute, actuate
+static void update(pbio_control_t *ctl, int32_t values[3], int32_t control) {
+    _pbio_record_begin(CHANNEL, &ctl, 1);
+    _pbio_record_values(CHANNEL, values, 3);
+    _pbio_record_output(CHANNEL, 0, PBIO_ACTUATION_DUTY, control);
+    _pbio_record_end(CHANNEL, &ctl, 1);
+}
+
+void test_record(void *env) {
+    static pbio_control_t ctl;
+    const uint8_t *data;
+    uint32_t size;
+    uint8_t channel;
+    uint8_t sensor_data[] = { 0x12, 0x34 };
+
+    // Record a stream with a command halfway
+    tt_want_int_op(pbio_record_start(1024), ==, PBIO_SUCCESS);
+    memset(&ctl, 0, sizeof(ctl));
+    ctl.type = PBIO_CONTROL_ANGLE;
+    ctl.settings.pid_kp = 100;
+    ctl.on_target_func = pbio_control_on_target_angle;
+
+    for (int32_t i = 0; i < NUM_UPDATES; i++) {
+        if (i == NUM_UPDATES / 2) {
+            ctl.settings.pid_kp = 200;
+        }
+        int32_t values[3] = { i * 6000, i * i * 1000 - 5000, -i * 300 };
+        update(&ctl, values, i * 10);
+        _pbio_record_iodev_data(0, 1, sensor_data, sizeof(sensor_data));
+
+        // Reading the state outside of an update is not recorded
+        _pbio_record_values(CHANNEL, values, 3);
+    }
+    pbio_record_stop();
+    tt_want(!pbio_record_is_full());
+    tt_want_int_op(pbio_record_get_data(&data, &size), ==, PBIO_SUCCESS);
+    tt_want_int_op(size, >, 9);
+    tt_want_int_op(size, <, 1024);
+
+    // Replay it with a controller that starts in another state
+    memset(&ctl, 0, sizeof(ctl));
+    tt_want_int_op(pbio_record_replay_start(data, size), ==, PBIO_SUCCESS);
+
+    int32_t i = 0;
+    while (pbio_record_replay_next(&channel)) {
+        tt_want_int_op(channel, ==, CHANNEL);
+        pbio_control_t *p = &ctl;
+        _pbio_record_begin(CHANNEL, &p, 1);
+        tt_want_int_op(ctl.type, ==, PBIO_CONTROL_ANGLE);
+        tt_want_int_op(ctl.settings.pid_kp, ==, i < NUM_UPDATES / 2 ? 100 : 200);
+        tt_want(ctl.on_target_func == pbio_control_on_target_angle);
+
+        // The measured state is replaced by the recorded state
+        int32_t values[3] = { 0, 0, 0 };
+        _pbio_record_values(CHANNEL, values, 3);
+        tt_want_int_op(values[0], ==, i * 6000);
+        tt_want_int_op(values[1], ==, i * i * 1000 - 5000);
+        tt_want_int_op(values[2], ==, -i * 300);
+
+        // A different control signal is noticed
+        _pbio_record_output(CHANNEL, 0, PBIO_ACTUATION_DUTY, i == 3 ? 31 : i * 10);
+        _pbio_record_end(CHANNEL, &p, 1);
+        i++;
+    }
+    tt_want_int_op(i, ==, NUM_UPDATES);
+    tt_want_int_op(pbio_record_replay_get_mismatches(), ==, 1);
+
+    // A full buffer keeps only complete updates
+    tt_want_int_op(pbio_record_start(sizeof(pbio_control_t) + 64), ==, PBIO_SUCCESS);
+    for (int32_t i = 0; i < NUM_UPDATES; i++) {
+        int32_t values[3] = { i * 6000, i * 1000, 0 };
+        update(&ctl, values, 0);
+    }
+    tt_want(pbio_record_is_full());
+    tt_want_int_op(pbio_record_get_data(&data, &size), ==, PBIO_SUCCESS);
+    tt_want_int_op(size, <=, sizeof(pbio_control_t) + 64);
+
+    tt_want_int_op(pbio_record_replay_start(data, size), ==, PBIO_SUCCESS);
+    i = 0;
+    while (pbio_record_replay_next(&channel)) {
+        int32_t values[3] = { 0, 0, 0 };
+        update(&ctl, values, 0);
+        tt_want_int_op(values[1], ==, i * 1000);
+        i++;
+    }
+    tt_want_int_op(i, >, 0);
+    tt_want_int_op(i, <, NUM_UPDATES);
+    tt_want_int_op(pbio_record_replay_get_mismatches(), ==, 0);
+
+    // Anything else is rejected
+    tt_want_int_op(pbio_record_replay_start((const uint8_t *)"PBX\x01\x01\0\0\0\0", 9), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_record_replay_start((const uint8_t *)"PBR\x01\x07\0\0\0\0", 9), ==, PBIO_ERROR_NOT_SUPPORTED);
+    tt_want_int_op(pbio_record_start(4), ==, PBIO_ERROR_INVALID_ARG);
+}
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/stream.h>
+#include <pbio/trajectory.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#define MS (US_PER_MS)
+
+static int32_t latest_time(pbio_stream_t *s) {
+    return s->time[s->size - 1];
+}
+
+void test_stream_interpolate(void *env) {
+    pbio_stream_t s;
+    int32_t count, count_ext, rate;
+
+    // Setpoints are played back 50 ms after they are sent
+    pbio_stream_start(&s, 0, 0, 1000, 50);
+    pbio_stream_add(&s, 0, 0, 1000);
+    pbio_stream_add(&s, 0, 100, 1100);
+    pbio_stream_add(&s, 0, 101, 1200);
+    tt_want_int_op(s.size, ==, 4);
+    tt_want_int_op(s.time[1], ==, 50 * MS);
+    tt_want_int_op(s.time[2], ==, 150 * MS);
+    tt_want_int_op(s.time[3], ==, 250 * MS);
+
+    // Wait at the first setpoint until the playback starts
+    pbio_stream_get_reference(&s, 20 * MS, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 0);
+    tt_want_int_op(rate, ==, 0);
+
+    pbio_stream_get_reference(&s, 75 * MS, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 25);
+    tt_want_int_op(count_ext, ==, 0);
+    tt_want_int_op(rate, ==, 1000);
+
+    // Slow segments move by millicounts
+    pbio_stream_get_reference(&s, 200 * MS, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 100);
+    tt_want_int_op(count_ext, ==, 500);
+    tt_want_int_op(rate, ==, 10);
+
+    // Beyond the last setpoint, extrapolate for a short time and then stop
+    pbio_stream_get_reference(&s, 300 * MS, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 101);
+    tt_want_int_op(count_ext, ==, 500);
+    tt_want_int_op(rate, ==, 10);
+    pbio_stream_get_reference(&s, 1000 * MS, &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 102);
+    tt_want_int_op(count_ext, ==, 0);
+    tt_want_int_op(rate, ==, 0);
+
+    // Setpoints that arrive out of order are ignored
+    pbio_stream_add(&s, 100 * MS, 50, 1150);
+    tt_want_int_op(s.size, ==, 4);
+    tt_want_int_op(latest_time(&s), ==, 250 * MS);
+    tt_want_int_op(s.count[s.size - 1], ==, 101);
+}
+
+void test_stream_late(void *env) {
+    pbio_stream_t s;
+
+    // The sender sends a setpoint every 20 ms, which arrives right away
+    pbio_stream_start(&s, 0, 0, 0, 50);
+    int32_t k;
+    for (k = 0; k < 5; k++) {
+        pbio_stream_add(&s, k * 20 * MS, k, k * 20);
+        tt_want_int_op(latest_time(&s), ==, (k * 20 + 50) * MS);
+    }
+
+    // One setpoint arrives 150 ms late, so it is played back 100 ms late
+    pbio_stream_add(&s, 250 * MS, k, k * 20);
+    tt_want_int_op(latest_time(&s), ==, 250 * MS);
+    tt_want_int_op(s.lag, ==, 100 * MS);
+
+    // Later setpoints that arrive in time catch up gradually
+    int32_t time_prev = latest_time(&s);
+    for (k = 13; k < 100; k++) {
+        pbio_stream_add(&s, k * 20 * MS, k, k * 20);
+        tt_want_int_op(latest_time(&s) - time_prev, >=, 20 * MS * 7 / 8);
+        tt_want_int_op(latest_time(&s) - time_prev, <=, k == 13 ? 160 * MS : 20 * MS);
+        time_prev = latest_time(&s);
+    }
+    tt_want_int_op(s.lag, ==, 0);
+    tt_want_int_op(latest_time(&s), ==, (99 * 20 + 50) * MS);
+
+    // A setpoint that is later than the limit means the sender clock jumped
+    pbio_stream_add(&s, 10000 * MS, k, k * 20);
+    tt_want_int_op(latest_time(&s), ==, 10050 * MS);
+    tt_want_int_op(s.lag, ==, 0);
+    pbio_stream_add(&s, 10020 * MS, k + 1, (k + 1) * 20);
+    tt_want_int_op(latest_time(&s), ==, 10070 * MS);
+}
+
+// Hub time shortly before the clock wraps around, plus the given milliseconds
+static int32_t after_start(int32_t ms) {
+    return (int32_t) ((uint32_t) INT32_MAX - 60 * MS + ms * MS);
+}
+
+void test_stream_wraparound(void *env) {
+    pbio_stream_t s;
+    int32_t count, count_ext, rate;
+
+    // A 16-bit sender clock wraps around while the hub clock does too
+    pbio_stream_start(&s, after_start(0), 0, 65500, 50);
+    pbio_stream_add(&s, after_start(0), 0, 65500);
+    pbio_stream_add(&s, after_start(0), 20, 65520);
+    pbio_stream_add(&s, after_start(20), 40, 4);
+    pbio_stream_add(&s, after_start(55), 60, 24);
+    tt_want_int_op(s.size, ==, 4);
+    tt_want_int_op(s.lag, ==, 0);
+    for (int32_t i = 0; i < 3; i++) {
+        tt_want_int_op(s.time[i + 1] - s.time[i], ==, 20 * MS);
+    }
+
+    // Interpolation works across the wraparound
+    pbio_stream_get_reference(&s, after_start(80), &count, &count_ext, &rate);
+    tt_want_int_op(count, ==, 30);
+    tt_want_int_op(count_ext, ==, 0);
+    tt_want_int_op(rate, ==, 1000);
+
+    // 32-bit time stamps work the same way
+    pbio_stream_start(&s, 0, 0, 100000, 0);
+    pbio_stream_add(&s, 0, 10, 100010);
+    pbio_stream_add(&s, 0, 20, 100020);
+    tt_want_int_op(s.time[1], ==, 10 * MS);
+    tt_want_int_op(s.time[2], ==, 20 * MS);
+}
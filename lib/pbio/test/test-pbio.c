@@ -78,11 +78,142 @@ static struct testcase_t example_tests[]  = {
 PBIO_TEST_FUNC(test_sqrt);
 PBIO_TEST_FUNC(test_mul_i32_fix16);
 PBIO_TEST_FUNC(test_div_i32_fix16);
+PBIO_TEST_FUNC(test_sin_cos_deg);
+PBIO_TEST_FUNC(test_atan2_deg);
+PBIO_TEST_FUNC(test_scale);
+PBIO_TEST_FUNC(test_math_benchmark);
 
 static struct testcase_t pbio_math_tests[] = {
     PBIO_TEST(test_sqrt),
     PBIO_TEST(test_mul_i32_fix16),
     PBIO_TEST(test_div_i32_fix16),
+    PBIO_TEST(test_sin_cos_deg),
+    PBIO_TEST(test_atan2_deg),
+    PBIO_TEST(test_scale),
+    PBIO_TEST(test_math_benchmark),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_trajectory_get_reference);
+PBIO_TEST_FUNC(test_trajectory_angle_millicounts);
+PBIO_TEST_FUNC(test_trajectory_scaled);
+PBIO_TEST_FUNC(test_trajectory_constant);
+PBIO_TEST_FUNC(test_trajectory_benchmark);
+
+static struct testcase_t pbio_trajectory_tests[] = {
+    PBIO_TEST(test_trajectory_get_reference),
+    PBIO_TEST(test_trajectory_angle_millicounts),
+    PBIO_TEST(test_trajectory_scaled),
+    PBIO_TEST(test_trajectory_constant),
+    PBIO_TEST(test_trajectory_benchmark),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_control_millicounts);
+
+static struct testcase_t pbio_control_tests[] = {
+    PBIO_TEST(test_control_millicounts),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_stream_interpolate);
+PBIO_TEST_FUNC(test_stream_late);
+PBIO_TEST_FUNC(test_stream_wraparound);
+
+static struct testcase_t pbio_stream_tests[] = {
+    PBIO_TEST(test_stream_interpolate),
+    PBIO_TEST(test_stream_late),
+    PBIO_TEST(test_stream_wraparound),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_follow_ratio);
+PBIO_TEST_FUNC(test_follow_cam);
+PBIO_TEST_FUNC(test_follow_relative);
+
+static struct testcase_t pbio_follow_tests[] = {
+    PBIO_TEST(test_follow_ratio),
+    PBIO_TEST(test_follow_cam),
+    PBIO_TEST(test_follow_relative),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_arena);
+
+static struct testcase_t pbio_arena_tests[] = {
+    PBIO_TEST(test_arena),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_battery);
+
+static struct testcase_t pbio_battery_tests[] = {
+    PBIO_TEST(test_battery),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_bluetooth_tx_queue);
+
+static struct testcase_t pbdrv_bluetooth_tests[] = {
+    PBIO_TEST(test_bluetooth_tx_queue),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_mailbox);
+
+static struct testcase_t pbio_mailbox_tests[] = {
+    PBIO_TEST(test_mailbox),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_download);
+
+static struct testcase_t pbio_download_tests[] = {
+    PBIO_TEST(test_download),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_i2c);
+
+static struct testcase_t pbio_i2c_tests[] = {
+    PBIO_TEST(test_i2c),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_logger_capacity);
+
+static struct testcase_t pbio_logger_tests[] = {
+    PBIO_TEST(test_logger_capacity),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_loopstats_add);
+
+static struct testcase_t pbio_loopstats_tests[] = {
+    PBIO_TEST(test_loopstats_add),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_process_priority);
+PBIO_TEST_FUNC(test_process_starvation);
+
+static struct testcase_t pbio_process_tests[] = {
+    PBIO_TEST(test_process_priority),
+    PBIO_TEST(test_process_starvation),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_record);
+
+static struct testcase_t pbio_record_tests[] = {
+    PBIO_TEST(test_record),
+    END_OF_TESTCASES
+};
+
+PBIO_TEST_FUNC(test_trace);
+
+static struct testcase_t pbio_trace_tests[] = {
+    PBIO_PT_THREAD_TEST(test_trace),
     END_OF_TESTCASES
 };
 
@@ -102,6 +233,21 @@ static struct testcase_t pbio_uartdev_tests[] = {
 static struct testgroup_t test_groups[] = {
     { "example/", example_tests },
     { "math/", pbio_math_tests },
+    { "trajectory/", pbio_trajectory_tests },
+    { "control/", pbio_control_tests },
+    { "stream/", pbio_stream_tests },
+    { "follow/", pbio_follow_tests },
+    { "arena/", pbio_arena_tests },
+    { "battery/", pbio_battery_tests },
+    { "bluetooth/", pbdrv_bluetooth_tests },
+    { "download/", pbio_download_tests },
+    { "mailbox/", pbio_mailbox_tests },
+    { "i2c/", pbio_i2c_tests },
+    { "logger/", pbio_logger_tests },
+    { "loopstats/", pbio_loopstats_tests },
+    { "process/", pbio_process_tests },
+    { "record/", pbio_record_tests },
+    { "trace/", pbio_trace_tests },
     { "uartdev/", pbio_uartdev_tests, },
     END_OF_GROUPS
 };
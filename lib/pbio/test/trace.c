@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <contiki.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/trace.h>
+
+PT_THREAD(test_trace(struct pt *pt)) {
+    static pbio_trace_event_t event;
+    static bool posted, called;
+
+    PT_BEGIN(pt);
+
+    pbio_trace_clear();
+    tt_want_int_op(pbio_trace_get_count(), ==, 0);
+    tt_want(!pbio_trace_get_event(0, &event));
+
+    // The event timer process handles this on the next call to pbio_do_one_event()
+    process_post(&etimer_process, PROCESS_EVENT_CONTINUE, NULL);
+    PT_YIELD(pt);
+
+    posted = called = false;
+    for (uint32_t i = 0; pbio_trace_get_event(i, &event); i++) {
+        if (event.event != PROCESS_EVENT_CONTINUE) {
+            continue;
+        }
+        tt_want_str_op(pbio_trace_get_name(event.id), ==, "Event timer");
+        if (event.type == PROCESS_TRACE_POST) {
+            tt_want(!called);
+            tt_want_int_op(event.nevents, >=, 1);
+            posted = true;
+        }
+        if (event.type == PROCESS_TRACE_CALL) {
+            called = true;
+        }
+    }
+    tt_want(posted && called);
+
+    // Old events are overwritten when the buffer is full
+    for (int i = 0; i < PBIO_CONFIG_TRACE_NUM_EVENTS + 10; i++) {
+        pbio_trace_record(PBIO_TRACE_LIGHTPOLL, pbio_trace_now());
+    }
+    tt_want_int_op(pbio_trace_get_count(), ==, PBIO_CONFIG_TRACE_NUM_EVENTS);
+    tt_want(pbio_trace_get_event(PBIO_CONFIG_TRACE_NUM_EVENTS - 1, &event));
+    tt_want_int_op(event.type, ==, PBIO_TRACE_LIGHTPOLL);
+    tt_want(pbio_trace_get_name(event.id) == NULL);
+
+    PT_END(pt);
+}
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2020 The Pybricks Authors
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <pbio/trajectory.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+// Reference evaluation with 64-bit divisions, as used before the polynomial
+// coefficients were precomputed. Used to check that results are equivalent.
+
+static int64_t ref_as_mcount(int32_t count, int32_t count_ext) {
+    return ((int64_t) count)*1000 + count_ext;
+}
+
+static int64_t ref_x_time(int32_t b, int32_t t) {
+    return (((int64_t) b) * ((int64_t) t))/US_PER_MS;
+}
+
+static int64_t ref_x_time2(int32_t b, int32_t t) {
+    return ref_x_time(ref_x_time(b, t), t)/(2*US_PER_MS);
+}
+
+static void ref_get_reference(pbio_trajectory_t *traject, int32_t time_ref, int64_t *mcount_ref, int32_t *rate_ref) {
+    if (time_ref - traject->t1 < 0) {
+        *rate_ref = traject->w0 + timest(traject->a0, time_ref-traject->t0);
+        *mcount_ref = ref_as_mcount(traject->th0, traject->th0_ext) + ref_x_time(traject->w0, time_ref-traject->t0) + ref_x_time2(traject->a0, time_ref-traject->t0);
+    }
+    else if (traject->forever || time_ref - traject->t2 <= 0) {
+        *rate_ref = traject->w1;
+        *mcount_ref = ref_as_mcount(traject->th1, traject->th1_ext) + ref_x_time(traject->w1, time_ref-traject->t1);
+    }
+    else if (time_ref - traject->t3 <= 0) {
+        *rate_ref = traject->w1 + timest(traject->a2, time_ref-traject->t2);
+        *mcount_ref = ref_as_mcount(traject->th2, traject->th2_ext) + ref_x_time(traject->w1, time_ref-traject->t2) + ref_x_time2(traject->a2, time_ref-traject->t2);
+    }
+    else {
+        *rate_ref = 0;
+        *mcount_ref = ref_as_mcount(traject->th3, traject->th3_ext);
+    }
+}
+
+// Exact evaluation in floating point, to check the accuracy of both methods
+static void exact_get_reference(pbio_trajectory_t *traject, int32_t time_ref, double *mcount_ref, double *rate_ref) {
+    int32_t th, th_ext, w, a, t;
+    if (time_ref - traject->t1 < 0) {
+        th = traject->th0, th_ext = traject->th0_ext, w = traject->w0, a = traject->a0, t = time_ref - traject->t0;
+    }
+    else if (traject->forever || time_ref - traject->t2 <= 0) {
+        th = traject->th1, th_ext = traject->th1_ext, w = traject->w1, a = 0, t = time_ref - traject->t1;
+    }
+    else if (time_ref - traject->t3 <= 0) {
+        th = traject->th2, th_ext = traject->th2_ext, w = traject->w1, a = traject->a2, t = time_ref - traject->t2;
+    }
+    else {
+        th = traject->th3, th_ext = traject->th3_ext, w = 0, a = 0, t = 0;
+    }
+    *mcount_ref = th * 1000.0 + th_ext + w * (double)t / 1e3 + a * (double)t * t / 2e9;
+    *rate_ref = w + a * (double)t / 1e6;
+}
+
+// Evaluate a trajectory along its full duration and compare with the other methods
+static void check_trajectory(pbio_trajectory_t *trj, int32_t duration, double *max_mcount_err, double *max_rate_err) {
+    for (int32_t t = 0; t <= duration; t += duration / 5000 + 1) {
+        int32_t time_ref = trj->t0 + t;
+
+        // Get the exact result and the result of the division based method
+        double mcount_exact, rate_exact;
+        exact_get_reference(trj, time_ref, &mcount_exact, &rate_exact);
+        int64_t mcount_div;
+        int32_t rate_div;
+        ref_get_reference(trj, time_ref, &mcount_div, &rate_div);
+
+        // Get the result to be tested. This is done last because it may rebase the trajectory.
+        int32_t count, count_ext, rate, acceleration;
+        pbio_trajectory_get_reference(trj, time_ref, &count, &count_ext, &rate, &acceleration);
+        int64_t mcount = ref_as_mcount(count, count_ext);
+
+        // Keep track of the error with respect to the exact result
+        double mcount_err = mcount > mcount_exact ? mcount - mcount_exact : mcount_exact - mcount;
+        double rate_err = rate > rate_exact ? rate - rate_exact : rate_exact - rate;
+        *max_mcount_err = mcount_err > *max_mcount_err ? mcount_err : *max_mcount_err;
+        *max_rate_err = rate_err > *max_rate_err ? rate_err : *max_rate_err;
+
+        // The result must be at least as accurate as the division based method, up to
+        // rounding. That method truncates intermediate results, so it is often worse.
+        double mcount_div_err = mcount_div > mcount_exact ? mcount_div - mcount_exact : mcount_exact - mcount_div;
+        double rate_div_err = rate_div > rate_exact ? rate_div - rate_exact : rate_exact - rate_div;
+        tt_want_float_op(mcount_err, <=, mcount_div_err + 2);
+        tt_want_float_op(rate_err, <=, rate_div_err + 1);
+    }
+}
+
+void test_trajectory_get_reference(void *env) {
+    static const int32_t speeds[] = {-2000, -500, -37, 0, 1, 99, 750, 1600, 4000};
+    static const int32_t accelerations[] = {100, 500, 3200, 20000};
+    static const int32_t angles[] = {-100000, -3600, -1, 1, 45, 721, 50000};
+    pbio_trajectory_t trj;
+    double max_mcount_err = 0;
+    double max_rate_err = 0;
+
+    for (int i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        for (int j = 0; j < sizeof(speeds) / sizeof(speeds[0]); j++) {
+            for (int k = 0; k < sizeof(accelerations) / sizeof(accelerations[0]); k++) {
+                int32_t w0 = speeds[i];
+                int32_t wt = speeds[j];
+                int32_t a = accelerations[k];
+
+                // Timed maneuvers, including one that starts at negative time
+                if (pbio_trajectory_make_time_based(&trj, -12345, 5 * US_PER_SECOND, 789, -321, w0, wt, 4000, a, 20000) == PBIO_SUCCESS) {
+                    check_trajectory(&trj, trj.t3 - trj.t0 + US_PER_SECOND, &max_mcount_err, &max_rate_err);
+                }
+                if (pbio_trajectory_make_time_based(&trj, 1000000, DURATION_FOREVER, -50, 0, w0, wt, 4000, a, 20000) == PBIO_SUCCESS) {
+                    check_trajectory(&trj, 30 * 60 * US_PER_SECOND, &max_mcount_err, &max_rate_err);
+                }
+
+                // Angle based maneuvers
+                for (int l = 0; l < sizeof(angles) / sizeof(angles[0]); l++) {
+                    if (wt != 0 && pbio_trajectory_make_angle_based(&trj, 2000000, 10, 0, 10 + angles[l], w0, wt, 4000, a, 20000) == PBIO_SUCCESS) {
+                        check_trajectory(&trj, trj.t3 - trj.t0 + US_PER_SECOND, &max_mcount_err, &max_rate_err);
+                    }
+                }
+            }
+        }
+    }
+
+    // Rounding towards zero gives up to one millicount or count/s error,
+    // plus a small error due to the fixed point coefficients.
+    tt_want_float_op(max_mcount_err, <, 2.0);
+    tt_want_float_op(max_rate_err, <, 1.5);
+}
+
+void test_trajectory_angle_millicounts(void *env) {
+    pbio_trajectory_t trj;
+    int32_t count, count_ext, rate, acceleration;
+
+    // Slow maneuver starting in between two counts
+    tt_want(pbio_trajectory_make_angle_based(&trj, 0, 10, 500, 20, 0, 10, 1000, 100, 1000) == PBIO_SUCCESS);
+    tt_want_int_op(trj.th0, ==, 10);
+    tt_want_int_op(trj.th0_ext, ==, 500);
+    tt_want_int_op(trj.th3, ==, 20);
+    tt_want_int_op(trj.th3_ext, ==, 0);
+
+    // The reference must increase smoothly, not in whole count steps
+    int64_t mcount_prev = 10500;
+    int32_t sub_count_steps = 0;
+    for (int32_t t = 0; t - trj.t3 <= 0; t += 10 * US_PER_MS) {
+        pbio_trajectory_get_reference(&trj, t, &count, &count_ext, &rate, &acceleration);
+        int64_t mcount = ref_as_mcount(count, count_ext);
+        tt_want_int_op(mcount, >=, mcount_prev);
+        tt_want_int_op(mcount - mcount_prev, <, 1000);
+        if (count_ext != 0) {
+            sub_count_steps++;
+        }
+        mcount_prev = mcount;
+    }
+    tt_want_int_op(sub_count_steps, >, 10);
+
+    // The maneuver ends exactly on the target
+    pbio_trajectory_get_reference(&trj, trj.t3 + 1, &count, &count_ext, &rate, &acceleration);
+    tt_want_int_op(count, ==, 20);
+    tt_want_int_op(count_ext, ==, 0);
+
+    // Backward maneuvers mirror about the fractional start angle
+    tt_want(pbio_trajectory_make_angle_based(&trj, 0, -10, -250, -20, 0, 10, 1000, 100, 1000) == PBIO_SUCCESS);
+    tt_want_int_op(trj.th0, ==, -10);
+    tt_want_int_op(trj.th0_ext, ==, -250);
+    tt_want_int_op(trj.th3, ==, -20);
+    tt_want_int_op(trj.th3_ext, ==, 0);
+
+    // Patching onto an ongoing maneuver keeps the millicounts of the reference
+    tt_want(pbio_trajectory_make_angle_based(&trj, 0, 0, 0, 1000, 0, 500, 1000, 2000, 2000) == PBIO_SUCCESS);
+    int32_t t_patch = 123456;
+    pbio_trajectory_get_reference(&trj, t_patch, &count, &count_ext, &rate, &acceleration);
+    tt_want(pbio_trajectory_make_angle_based_patched(&trj, t_patch, 2000, 500, 1000, 2000, 2000) == PBIO_SUCCESS);
+    int32_t count_patched, count_ext_patched;
+    pbio_trajectory_get_reference(&trj, t_patch, &count_patched, &count_ext_patched, &rate, &acceleration);
+    tt_want_int_op(ref_as_mcount(count_patched, count_ext_patched), ==, ref_as_mcount(count, count_ext));
+}
+
+void test_trajectory_scaled(void *env) {
+    pbio_trajectory_t master;
+    pbio_trajectory_t axes[3];
+    int32_t count, count_ext, rate, acceleration;
+
+    // Axes that travel the full, a negative, and a small fractional master angle
+    const int32_t th0[] = {0, 100, -7};
+    const int32_t th0_ext[] = {0, 250, -500};
+    const int32_t th3[] = {3600, -1700, 5};
+
+    tt_want(pbio_trajectory_make_angle_based(&master, 1000, 0, 0, 3600, 0, 1000, 2000, 2000, 2000) == PBIO_SUCCESS);
+    for (int i = 0; i < 3; i++) {
+        tt_want(pbio_trajectory_make_scaled(&axes[i], &master, th0[i], th0_ext[i], th3[i]) == PBIO_SUCCESS);
+        tt_want_int_op(axes[i].t0, ==, master.t0);
+        tt_want_int_op(axes[i].t3, ==, master.t3);
+    }
+
+    // All axes stay on a straight line throughout the maneuver
+    for (int32_t t = master.t0; t - master.t3 <= 0; t += 997) {
+        pbio_trajectory_get_reference(&master, t, &count, &count_ext, &rate, &acceleration);
+        double progress = ref_as_mcount(count, count_ext) / 3600000.0;
+        int32_t master_rate = rate;
+
+        for (int i = 0; i < 3; i++) {
+            double mth0 = ref_as_mcount(th0[i], th0_ext[i]);
+            double length = th3[i] * 1000.0 - mth0;
+            pbio_trajectory_get_reference(&axes[i], t, &count, &count_ext, &rate, &acceleration);
+            double err = ref_as_mcount(count, count_ext) - (mth0 + progress * length);
+            tt_want(err < 2 && err > -2);
+            double rate_err = rate - master_rate * length / 3600000.0;
+            tt_want(rate_err < 2 && rate_err > -2);
+        }
+    }
+
+    // All axes end exactly on their targets
+    for (int i = 0; i < 3; i++) {
+        pbio_trajectory_get_reference(&axes[i], master.t3 + 1, &count, &count_ext, &rate, &acceleration);
+        tt_want_int_op(count, ==, th3[i]);
+        tt_want_int_op(count_ext, ==, 0);
+        tt_want_int_op(rate, ==, 0);
+    }
+
+    // An axis may not travel farther than the master
+    tt_want(pbio_trajectory_make_scaled(&axes[0], &master, 0, 0, 3601) == PBIO_ERROR_INVALID_ARG);
+}
+
+void test_trajectory_constant(void *env) {
+    pbio_trajectory_t trj;
+    int32_t count, count_ext, rate, acceleration;
+
+    // Starts in between counts and keeps moving at the same rate
+    pbio_trajectory_make_constant(&trj, 5000, -20, -500, -300);
+    pbio_trajectory_get_reference(&trj, 5000, &count, &count_ext, &rate, &acceleration);
+    tt_want_int_op(ref_as_mcount(count, count_ext), ==, -20500);
+    tt_want_int_op(rate, ==, -300);
+
+    pbio_trajectory_get_reference(&trj, 5000 + 2 * US_PER_SECOND, &count, &count_ext, &rate, &acceleration);
+    tt_want_int_op(ref_as_mcount(count, count_ext), ==, -620500);
+    tt_want_int_op(rate, ==, -300);
+    tt_want_int_op(acceleration, ==, 0);
+}
+
+static int64_t elapsed_ns(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+void test_trajectory_benchmark(void *env) {
+    const int32_t n = 1000000;
+    pbio_trajectory_t trj;
+    struct timespec start;
+    int64_t checksum = 0;
+
+    // Typical maneuver with all phases, evaluated over its duration
+    tt_assert(pbio_trajectory_make_angle_based(&trj, 0, 0, 0, 3600, 0, 1000, 2000, 2000, 2000) == PBIO_SUCCESS);
+    int32_t dt = trj.t3 / n + 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < n; i++) {
+        int32_t count, count_ext, rate, acceleration;
+        pbio_trajectory_get_reference(&trj, i * dt, &count, &count_ext, &rate, &acceleration);
+        checksum += count + rate;
+    }
+    int64_t time_poly = elapsed_ns(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < n; i++) {
+        int64_t mcount;
+        int32_t rate;
+        ref_get_reference(&trj, i * dt, &mcount, &rate);
+        checksum -= mcount / 1000 + rate;
+    }
+    int64_t time_div = elapsed_ns(&start);
+
+    printf("get_reference: %d ns (precomputed), %d ns (divisions), checksum %d\n",
+        (int)(time_poly / n), (int)(time_div / n), (int)checksum);
+end:
+    ;
+}
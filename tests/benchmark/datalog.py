@@ -0,0 +1,15 @@
+# Logging speed, as in a control loop that logs a few values each iteration
+
+from pybricks.tools import DataLog, StopWatch
+
+COUNT = 10000
+
+data = DataLog('time', 'angle', 'speed', name='/tmp/pybricks-benchmark-datalog', timestamp=False)
+
+watch = StopWatch()
+for i in range(COUNT):
+    data.log(i, i * 3, i / 7)
+watch.pause()
+data.close()
+
+print("samples/s:", COUNT * 1000 // watch.time())
@@ -0,0 +1,25 @@
+# Time it takes to import the pybricks modules that a typical program uses. Run
+# this as a file so that each module is imported for the first time. These are
+# frozen bytecode in the ev3dev build, so there should be no compile step.
+
+from utime import ticks_diff, ticks_us
+
+MODULES = (
+    'pybricks.hubs',
+    'pybricks.parameters',
+    'pybricks.ev3devices',
+    'pybricks.tools',
+    'pybricks.robotics',
+    'pybricks.media.ev3dev',
+    'pybricks.messaging',
+)
+
+total = 0
+for name in MODULES:
+    start = ticks_us()
+    __import__(name)
+    elapsed = ticks_diff(ticks_us(), start)
+    total += elapsed
+    print(name, elapsed // 1000, 'ms')
+
+print('total', total // 1000, 'ms')
@@ -0,0 +1,28 @@
+# Same loop as looptime.py, but reading and driving both motors with one call
+# each through a MotorGroup, with preallocated arrays.
+
+from array import array
+
+from pybricks.ev3devices import Motor
+from pybricks.parameters import Port
+from pybricks.robotics import MotorGroup
+from pybricks.tools import StopWatch
+
+group = MotorGroup([Motor(Port.A), Motor(Port.B)])
+angles = array('i', [0, 0])
+duties = array('i', [0, 0])
+
+watch = StopWatch()
+for i in range(0, 10000):
+    group.angles(angles)
+    avg_pos = angles[0] + angles[1]
+    formula = i//100-avg_pos//36
+    duties[0] = formula
+    duties[1] = formula
+    group.dc(duties)
+
+watch.pause()
+
+group.stop()
+
+print("usec/loop:", watch.time()//10)
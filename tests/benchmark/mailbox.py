@@ -0,0 +1,44 @@
+# Mailbox round trips between a server and two clients over UNIX sockets, all
+# in one program. This measures the messaging code on a single computer.
+
+from pybricks.messaging import (SocketMailboxServer, SocketMailboxClient,
+                                NumericMailbox)
+from utime import ticks_diff, ticks_ms
+
+PATH = '/tmp/pybricks-mailbox-benchmark'
+NUM_CLIENTS = 2
+COUNT = 1000
+
+
+def wait_for(mbox, value):
+    while mbox.read() != value:
+        mbox.wait()
+
+
+server = SocketMailboxServer(PATH)
+clients = [SocketMailboxClient() for _ in range(NUM_CLIENTS)]
+for client in clients:
+    client.connect(PATH)
+server.wait_for_connection(NUM_CLIENTS)
+
+request = NumericMailbox('request', server)
+replies = [NumericMailbox('reply{}'.format(i), server) for i in range(NUM_CLIENTS)]
+client_requests = [NumericMailbox('request', c) for c in clients]
+client_replies = [NumericMailbox('reply{}'.format(i), c) for i, c in enumerate(clients)]
+
+# The server broadcasts a request and each client replies with the same value
+start = ticks_ms()
+for i in range(COUNT):
+    request.send(i)
+    for client_request, client_reply in zip(client_requests, client_replies):
+        wait_for(client_request, i)
+        client_reply.send(i)
+    for reply in replies:
+        wait_for(reply, i)
+elapsed = ticks_diff(ticks_ms(), start)
+
+print('messages/s:', COUNT * 2 * NUM_CLIENTS * 1000 // elapsed)
+
+for client in clients:
+    client.close()
+server.server_close()
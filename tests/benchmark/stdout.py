@@ -0,0 +1,15 @@
+# Print throughput, as in a loop that prints some telemetry each iteration.
+# Run with stdout connected to a pipe, for example:
+#
+#     pybricks-micropython stdout.py | tail -n 1
+
+from pybricks.tools import StopWatch
+
+COUNT = 10000
+
+watch = StopWatch()
+for i in range(COUNT):
+    print(i, i * 3, -i)
+watch.pause()
+
+print("usec/print:", watch.time() * 1000 // COUNT)
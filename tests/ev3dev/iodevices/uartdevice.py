@@ -0,0 +1,59 @@
+# Tests UARTDevice reads against a pseudo terminal that stands in for the
+# tty of the sensor port.
+
+import ffi
+import uerrno
+import uos
+import utime
+
+from pybricks.iodevices import UARTDevice
+from pybricks.parameters import Port
+
+_libc = ffi.open('libc.so.6')
+_posix_openpt = _libc.func('i', 'posix_openpt', 'i')
+_grantpt = _libc.func('i', 'grantpt', 'i')
+_unlockpt = _libc.func('i', 'unlockpt', 'i')
+_ptsname = _libc.func('s', 'ptsname', 'i')
+_symlink = _libc.func('i', 'symlink', 'ss')
+_write = _libc.func('i', 'write', 'iPi')
+
+_O_RDWR = 0o2
+_O_NOCTTY = 0o400
+
+# The port tty is looked up in the mocked /dev, so point it at the pty
+pty = _posix_openpt(_O_RDWR | _O_NOCTTY)
+_grantpt(pty)
+_unlockpt(pty)
+dev = uos.getenv('UMOCKDEV_DIR') + '/dev'
+try:
+    uos.mkdir(dev)
+except OSError:
+    pass
+_symlink(_ptsname(pty), dev + '/tty_ev3-ports:in1')
+
+
+def send(data):
+    _write(pty, data, len(data))
+
+
+uart = UARTDevice(Port.S1, 115200, timeout=200)
+
+# Data that is already there is read right away
+send(b'hello')
+print(uart.read(5))
+
+# Reading into a buffer fills all of it
+send(b'abc')
+buf = bytearray(3)
+print(uart.read_into(buf), buf)
+print(uart.read_into(bytearray()))
+
+# Reads that don't get enough data raise an error after the timeout
+for read in (lambda: uart.read(2), lambda: uart.read_into(bytearray(2))):
+    send(b'x')
+    start = utime.ticks_ms()
+    try:
+        read()
+    except OSError as ex:
+        elapsed = utime.ticks_diff(utime.ticks_ms(), start)
+        print(ex.args[0] == uerrno.ETIMEDOUT, 200 <= elapsed < 1000)
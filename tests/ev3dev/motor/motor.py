@@ -1,5 +1,8 @@
+from array import array
+
 from pybricks.ev3devices import Motor
 from pybricks.parameters import Port
+from pybricks.robotics import MotorGroup
 
 IIO_BASE = ('/sys/devices/platform/soc@1c00000/ti-pruss/1c32000.pru1'
             '/remoteproc/remoteproc0/virtio0/virtio0.ev3-tacho-rpmsg.-1.0'
@@ -80,3 +83,30 @@ print_tacho('duty_cycle_sp')  # expect -100
 # testing __str__/__repr__
 
 print(m)
+
+
+# testing MotorGroup angles
+
+group = MotorGroup([m])
+
+print(group.angles())  # expect (180,)
+
+angles = [0]
+print(group.angles(angles) is angles)  # expect True
+print(angles)  # expect [180]
+
+angles = array('i', [0])
+group.angles(angles)
+print(angles[0])  # expect 180
+
+# the output must have one value per motor
+try:
+    group.angles([0, 0])
+except ValueError:
+    print('ValueError')
+
+# arrays must hold 32-bit ints
+try:
+    group.angles(array('h', [0, 0]))
+except ValueError:
+    print('ValueError')
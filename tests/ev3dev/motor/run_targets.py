@@ -0,0 +1,38 @@
+from pybricks.ev3devices import Motor
+from pybricks.parameters import Port
+from pybricks.robotics import run_targets
+
+a = Motor(Port.A)
+b = Motor(Port.B)
+
+
+# testing run_targets without waiting, so the mocked motors need not move
+
+run_targets([a, b], 500, [360, 180], wait=False)
+ta = a.control.trajectory()
+tb = b.control.trajectory()
+
+# both axes finish together
+print(ta[3] > 0)  # expect True
+print(ta[1:4] == tb[1:4])  # expect True
+
+# each axis ends at its own target
+print(ta[7], tb[7])  # expect 360 180
+
+a.stop()
+b.stop()
+
+
+# the number of motors and targets must match
+
+try:
+    run_targets([a, b], 500, [360])
+except ValueError:
+    print('ValueError')
+
+# each motor may be used only once
+
+try:
+    run_targets([a, a], 500, [360, 180])
+except ValueError:
+    print('ValueError')
@@ -0,0 +1,31 @@
+from pybricks.tools import DataLog
+
+# headers are the first line of a new file
+data = DataLog('time', 'angle', name='/tmp/pybricks-test-datalog', timestamp=False)
+data.log(0, 1.5, -2)
+data.log(1, 2.0, 'text')
+data.log(10 ** 20, -0.25, None)
+print(data)
+data.close()
+
+# headers are not repeated when appending
+data = DataLog('time', 'angle', name='/tmp/pybricks-test-datalog', timestamp=False, append=True)
+data.log(2, 1e-07)
+print(data)
+data.close()
+
+
+# a row that can't be completed is not written, not even with the next row
+class Bad:
+    def __str__(self):
+        raise ValueError('bad value')
+
+
+data = DataLog(name='/tmp/pybricks-test-datalog', timestamp=False)
+try:
+    data.log(1, Bad())
+except ValueError as ex:
+    print('ValueError:', ex)
+data.log(3, 4)
+print(data)
+data.close()
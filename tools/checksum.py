@@ -76,6 +76,30 @@ def _crc32_fast_block(crc, buffer):
     return crc
 
 
+def crc32_bytes(data, crc=0xffffffff):
+    """Calculate the CRC-32 of a byte string with the same polynomial as the
+    STM32 CRC unit, one byte at a time (CRC-32/MPEG-2). This is used by the
+    block based program download protocol.
+
+    Parameters
+    ----------
+    data : bytes
+        The data.
+    crc : int
+        The initial value, or the result of a previous call to continue it.
+
+    Returns
+    -------
+    int
+        The checksum
+    """
+    for b in data:
+        crc ^= b << 24
+        for _ in range(2):
+            crc = _dword(crc << 4) ^ _CRC_TABLE[crc >> 28]
+    return crc
+
+
 def crc32_checksum(fw, max_size):
     """Calculate the checksum of a firmware file using CRC-32 as implemented
     in STM32 microprocessors.
@@ -6,8 +6,21 @@
 import argparse
 import serial
 import time
+from checksum import crc32_bytes
 from mpybytes import mpy_bytes_from_file, mpy_bytes_from_str
 
+# Block protocol, see lib/pbio/include/pbio/download.h
+BLOCK_MAGIC = b'PBLK'
+BLOCK_SIZE = 64
+BLOCK_ACK = 0x06
+BLOCK_NAK = 0x15
+
+# Resend a block if it has not been acknowledged after this time
+BLOCK_RESEND_TIME = 0.2
+
+# Give up if no block has been acknowledged for this long
+BLOCK_TIMEOUT = 2
+
 
 def send_message(ser, data):
     """Send bytes to the hub, and check if reply matches checksum."""
@@ -33,22 +46,84 @@ def send_message(ser, data):
         raise ValueError("Did not receive expected checksum.")
 
 
-def download_and_run(device, mpy_bytes):
-    """Split bytes from an MPY file into chunks and send to the hub."""
+def make_block(seq, data):
+    """Make a block of the form seq | data | crc32."""
+    frame = seq.to_bytes(2, byteorder="big") + data
+    return frame + crc32_bytes(frame).to_bytes(4, byteorder="big")
+
+
+def send_blocks(ser, data, window):
+    """Send data as CRC checked blocks, keeping up to window blocks in flight
+    and resending only the blocks that were not acknowledged."""
+
+    blocks = [make_block(seq, data[i:i+BLOCK_SIZE])
+              for seq, i in enumerate(range(0, len(data), BLOCK_SIZE))]
+    acked = [False] * len(blocks)
+    sent_time = [None] * len(blocks)
+    reply = b''
+    progress_time = time.time()
+
+    def send(seq):
+        ser.write(blocks[seq])
+        sent_time[seq] = time.time()
+
+    while not all(acked):
+        now = time.time()
+
+        # Handle replies. Skip bytes we don't understand.
+        reply += ser.read_all()
+        while len(reply) >= 3:
+            seq = int.from_bytes(reply[1:3], byteorder="big")
+            if reply[0] == BLOCK_ACK and seq < len(blocks):
+                acked[seq] = True
+                progress_time = now
+            elif reply[0] == BLOCK_NAK and seq < len(blocks):
+                send(seq)
+            else:
+                reply = reply[1:]
+                continue
+            reply = reply[3:]
+
+        # Send new blocks and resend old ones while the window is not full
+        in_flight = 0
+        for seq in range(len(blocks)):
+            if in_flight == window:
+                break
+            if acked[seq]:
+                continue
+            if sent_time[seq] is None or now - sent_time[seq] > BLOCK_RESEND_TIME:
+                send(seq)
+            in_flight += 1
+
+        if now - progress_time > BLOCK_TIMEOUT:
+            raise OSError("Download timed out.")
+
+        time.sleep(0.001)
+
+
+def download_and_run(device, mpy_bytes, window=2, legacy=False):
+    """Send bytes from an MPY file to the hub and show the output."""
 
     # Open serial port
     ser = serial.Serial(device, baudrate=115200, timeout=0)
 
-    # Get the mpy file size as 4 bytes
-    send_message(ser, len(mpy_bytes).to_bytes(4, byteorder="big"))
+    if legacy:
+        # Get the mpy file size as 4 bytes
+        send_message(ser, len(mpy_bytes).to_bytes(4, byteorder="big"))
 
-    # Split binary up in digestable chunks
-    n = 100
-    chunks = [mpy_bytes[i:i+n] for i in range(0, len(mpy_bytes), n)]
+        # Split binary up in digestable chunks
+        n = 100
+        chunks = [mpy_bytes[i:i+n] for i in range(0, len(mpy_bytes), n)]
 
-    # Send the data
-    for chunk in chunks:
-        send_message(ser, chunk)
+        # Send the data
+        for chunk in chunks:
+            send_message(ser, chunk)
+    else:
+        # Select the block protocol, then send the size and the data
+        send_message(ser, BLOCK_MAGIC)
+        send_message(ser, len(mpy_bytes).to_bytes(4, byteorder="big"))
+        ser.reset_input_buffer()
+        send_blocks(ser, mpy_bytes, window)
 
     # Give hub time to start program
     time.sleep(0.2)
@@ -113,6 +188,12 @@ if __name__ == "__main__":
     )
     parser.add_argument(
         '--dev', dest='device', nargs='?', type=str, required=True)
+    parser.add_argument(
+        '--window', dest='window', type=int, default=2,
+        help='number of blocks to send before waiting for a reply')
+    parser.add_argument(
+        '--legacy', dest='legacy', action='store_true',
+        help='use the byte-by-byte protocol of older firmware')
     group = parser.add_mutually_exclusive_group(required=True)
     group.add_argument('--file', dest='file', nargs='?', const=1, type=str)
     group.add_argument('--string', dest='string', nargs='?', const=1, type=str)
@@ -124,4 +205,4 @@ if __name__ == "__main__":
     if args.string:
         bytearr = mpy_bytes_from_str(args.mpy_cross, args.string)
 
-    download_and_run(args.device, bytearr)
+    download_and_run(args.device, bytearr, args.window, args.legacy)
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2020 The Pybricks Authors
+
+"""Convert the output of pybricks.debug.trace_dump() to the Chrome trace event
+format, which can be viewed in chrome://tracing or https://ui.perfetto.dev.
+
+The firmware must be built with PROCESS_CONF_TRACE enabled in contiki-conf.h.
+"""
+
+import argparse
+import json
+import struct
+
+# Layout of pbio_trace_event_t (little endian)
+EVENT_FORMAT = '<IIBBBB'
+EVENT_SIZE = struct.calcsize(EVENT_FORMAT)
+
+# Trace event types from sys/process.h and pbio/trace.h
+TYPE_POST = 0
+TYPE_CALL = 1
+TYPE_TIMER = 2
+TYPE_MOTORPOLL = 16
+TYPE_LIGHTPOLL = 17
+
+TYPE_NAMES = {
+    TYPE_POST: 'post',
+    TYPE_CALL: 'call',
+    TYPE_TIMER: 'timer',
+    TYPE_MOTORPOLL: 'motorpoll',
+    TYPE_LIGHTPOLL: 'lightpoll',
+}
+
+# Process ids that are not in the name table
+ID_NONE = 0
+ID_OTHER = 0xFF
+
+# Contiki events from sys/process.h
+EVENT_NAMES = {
+    0x80: 'NONE',
+    0x81: 'INIT',
+    0x82: 'POLL',
+    0x83: 'EXIT',
+    0x84: 'SERVICE_REMOVED',
+    0x85: 'CONTINUE',
+    0x86: 'MSG',
+    0x87: 'EXITED',
+    0x88: 'TIMER',
+}
+
+
+def parse_dump(lines):
+    """Parse the lines printed by trace_dump().
+
+    Parameters
+    ----------
+    lines : iterable of str
+        Lines of captured output. Anything outside of the trace is ignored.
+
+    Returns
+    -------
+    tuple
+        A dictionary mapping process ids to names, and a list of event tuples
+        (time, duration, type, id, event, nevents).
+    """
+    names = {ID_NONE: 'pbio', ID_OTHER: 'other'}
+    events = []
+    active = False
+
+    for line in lines:
+        line = line.strip()
+        if line.startswith('trace begin'):
+            active = True
+        elif line == 'trace end':
+            active = False
+        elif active and line.startswith('proc '):
+            _, id, name = line.split(' ', 2)
+            names[int(id)] = name
+        elif active and len(line) == EVENT_SIZE * 2:
+            events.append(struct.unpack(EVENT_FORMAT, bytes.fromhex(line)))
+
+    return names, events
+
+
+def to_chrome(names, events):
+    """Convert parsed trace events to Chrome trace format.
+
+    Handled events and pbio polls become complete events on the timeline of
+    their process. Posts and timer expiries become instant events. The queue
+    length is shown as a counter.
+    """
+    trace = []
+
+    for id, name in names.items():
+        trace.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': id,
+                      'args': {'name': name}})
+
+    # Timestamps are 32-bit microseconds, so unwrap them
+    offset = 0
+    prev_time = events[0][0] if events else 0
+
+    for time, duration, type, id, event, nevents in events:
+        if time < prev_time and prev_time - time > 1 << 31:
+            offset += 1 << 32
+        prev_time = time
+        ts = time + offset
+
+        name = TYPE_NAMES.get(type, 'type {}'.format(type))
+        args = {}
+        if type < TYPE_MOTORPOLL:
+            args['event'] = EVENT_NAMES.get(event, hex(event))
+            name = '{} {}'.format(name, args['event'])
+
+        if type in (TYPE_POST, TYPE_TIMER):
+            trace.append({'name': name, 'ph': 'i', 's': 't', 'ts': ts,
+                          'pid': 0, 'tid': id, 'args': args})
+        else:
+            trace.append({'name': name, 'ph': 'X', 'ts': ts, 'dur': duration,
+                          'pid': 0, 'tid': id, 'args': args})
+
+        trace.append({'name': 'queue', 'ph': 'C', 'ts': ts, 'pid': 0,
+                      'args': {'events': nevents}})
+
+    return {'traceEvents': trace, 'displayTimeUnit': 'ms'}
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description='Convert a Pybricks scheduler trace to Chrome trace JSON.')
+    parser.add_argument('input', type=argparse.FileType('r'),
+                        help='captured output of pybricks.debug.trace_dump()')
+    parser.add_argument('output', type=argparse.FileType('w'),
+                        help='trace JSON file to write')
+    args = parser.parse_args()
+
+    names, events = parse_dump(args.input)
+    json.dump(to_chrome(names, events), args.output)